@@ -0,0 +1,216 @@
+/******************************************************************************
+  Example10_FloodBaseline.ino
+
+  Flood detection that follows a drifting dry probe. The probe is on
+  channel 1 and a fixed reference capacitor on channel 0: water raises the
+  probe's capacitance, so the ratio C_ch0 / C_ch1 drops, which is the
+  direction the chip's comparator alarms in. The baseline tracker learns
+  the dry ratio, detects an 8% drop below it and keeps the chip's TRH/TRL on
+  the baseline, so the hardware alarm (and INTB) drift with it.
+
+  Uncomment SIMULATED to benchmark it against fixed thresholds instead: two
+  weeks of one conversion a minute on the simulated MC11S, with the dry
+  probe drifting 6% (dirt) plus a 2.5% daily swing (humidity), conversion
+  noise, and three one-hour floods that raise the probe's capacitance by
+  15%. Each run reports the false alarms and the floods caught.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+  Reference capacitor --> CH0
+  Flood probe --> CH1
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Baseline.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+#endif
+
+#define TRIP            0.08    // Drop below the baseline that detects
+#define RELEASE         0.05
+
+MC11S_BaselineTracker tracker;
+
+#ifdef SIMULATED
+#define DAYS            14
+#define PER_DAY         1440    // Conversions a day
+#define FLOOD_LENGTH    60
+#define FLOOD_RISE      0.15    // Of the probe's capacitance, when wet
+
+const uint32_t floods[] = { 3UL * PER_DAY + 200, 8UL * PER_DAY + 900, 12UL * PER_DAY + 1300 };
+
+// Probe capacitance at conversion n, pF: dry and drifting, or wet during a flood
+float probe(uint32_t n) {
+  float day = (float)n / PER_DAY;
+  float c = 100 * (1 + 0.06 * day / DAYS + 0.025 * sin(2 * PI * day));
+  uint8_t i;
+
+  for (i = 0; i < sizeof(floods) / sizeof(floods[0]); i++)
+    if (n >= floods[i] && n < floods[i] + FLOOD_LENGTH)
+      c *= 1 + FLOOD_RISE;
+
+  return c;
+}
+
+bool inFlood(uint32_t n) {
+  uint8_t i;
+
+  // An alarm up to an hour after the water has gone still belongs to it
+  for (i = 0; i < sizeof(floods) / sizeof(floods[0]); i++)
+    if (n >= floods[i] && n < floods[i] + 2 * FLOOD_LENGTH)
+      return true;
+
+  return false;
+}
+
+// One pass over the whole run, tracking or with fixed thresholds
+void run(bool tracking) {
+  uint32_t n, falseAlarms = 0, hwFalseAlarms = 0, caught = 0, hwCaught = 0;
+  bool alarm = false, hwAlarm = false, counted = false, hwCounted = false;
+  uint16_t ch0, ch1;
+  mc11s_status_t status;
+
+  mySensor.begin();
+  mySensor.setCapacitance(100, probe(0));
+  mySensor.autoRange();
+
+  tracker.setThresholds(TRIP, RELEASE);
+  tracker.setAdaptation(PER_DAY / 8);
+  tracker.setDebounce(2);
+  tracker.setFollow(&mySensor, 16);
+  tracker.reset();
+
+  if (!tracking) {
+    // Thresholds set once from the first conversion
+    mySensor.singleConversion(&ch0, &ch1, &status);
+    tracker.update(ch0, ch1);
+    tracker.setFollow(NULL, 0);
+  }
+
+  for (n = 0; n < (uint32_t)DAYS * PER_DAY; n++) {
+    mySensor.setCapacitance(100, probe(n));
+    if (mySensor.singleConversion(&ch0, &ch1, &status) != 0)
+      continue;
+
+    if (tracking) {
+      tracker.update(ch0, ch1);
+      if (tracker.isDetecting() && !alarm) {
+        if (!inFlood(n))
+          falseAlarms++;
+        else if (!counted)
+          caught++;
+        counted = counted || inFlood(n);
+      }
+      alarm = tracker.isDetecting();
+    }
+
+    if (status.alert && !hwAlarm) {
+      if (!inFlood(n))
+        hwFalseAlarms++;
+      else if (!hwCounted)
+        hwCaught++;
+      hwCounted = hwCounted || inFlood(n);
+    }
+    hwAlarm = status.alert;
+
+    if (!inFlood(n))
+      counted = hwCounted = false;
+  }
+
+  if (tracking) {
+    Serial.print("Baseline (software):  ");
+    Serial.print(falseAlarms);
+    Serial.print(" false alarms, ");
+    Serial.print(caught);
+    Serial.println(" floods caught");
+    Serial.print("Baseline (TRH/TRL):   ");
+  } else {
+    Serial.print("Fixed TRH/TRL:        ");
+  }
+  Serial.print(hwFalseAlarms);
+  Serial.print(" false alarms, ");
+  Serial.print(hwCaught);
+  Serial.print(" floods caught");
+  if (tracking) {
+    Serial.print(", ");
+    Serial.print(tracker.getProgramCount());
+    Serial.print(" threshold writes");
+  }
+  Serial.println();
+}
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 10: Flood detection with baseline tracking");
+
+#ifdef SIMULATED
+  mySensor.setNoise(300, 0.01);
+
+  Serial.print(DAYS);
+  Serial.print(" days, ");
+  Serial.print(sizeof(floods) / sizeof(floods[0]));
+  Serial.println(" floods");
+  run(false);
+  run(true);
+#else
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  mySensor.autoRange();
+
+  // One conversion a second: the baseline follows over a few hours
+  tracker.setThresholds(TRIP, RELEASE);
+  tracker.setAdaptation(4096);
+  tracker.setFollow(&mySensor, 60);
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  uint16_t ch0, ch1;
+  mc11s_status_t status;
+
+  if (mySensor.singleConversion(&ch0, &ch1, &status) == 0 && tracker.update(ch0, ch1)) {
+    Serial.print(tracker.isDetecting() ? "FLOOD, " : "Dry again, ");
+    Serial.print(tracker.getDeviation() * 100, 1);
+    Serial.print("% below baseline ");
+    Serial.println(tracker.getBaseline(), 4);
+  }
+  delay(1000);
+#endif
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+  Example11_LevelBands.ino
+
+  Splits the tank into five bands, EMPTY, LOW, NORMAL, HIGH and OVERFLOW, and
+  prints a timestamped event whenever the level settles into another one.
+  Each boundary has its own hysteresis and each band its own dwell time, so
+  waves from the filling pump don't make the bands flap; OVERFLOW has none
+  and is reported on the first sample.
+
+  The level comes from the calibration stored by Example 8. The band table
+  is checked when the sketch compiles: make two boundaries overlap and it
+  won't build.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Arduino_Library.h"
+#include "MC11S_Calibration.h"
+#include "MC11S_Bands.h"
+#include <Wire.h>
+
+#define CAL_ADDRESS     0
+
+// Levels in mm: rise into the band above, fall back below
+constexpr mc11s_band_edge_t edges[] = {
+  { MC11S_LEVEL_Q16(50),  MC11S_LEVEL_Q16(40) },    // EMPTY | LOW
+  { MC11S_LEVEL_Q16(200), MC11S_LEVEL_Q16(185) },   // LOW | NORMAL
+  { MC11S_LEVEL_Q16(800), MC11S_LEVEL_Q16(780) },   // NORMAL | HIGH
+  { MC11S_LEVEL_Q16(950), MC11S_LEVEL_Q16(930) },   // HIGH | OVERFLOW
+};
+static_assert(mc11s_bands_valid(edges), "band edges overlap");
+
+// ms in a band before the move is reported
+const uint32_t dwell[] = { 10000, 5000, 5000, 5000, 0 };
+
+const char *names[] = { "EMPTY", "LOW", "NORMAL", "HIGH", "OVERFLOW" };
+
+MC11S_I2C mySensor;
+MC11S_Calibration cal;
+MC11S_BandMachine<5> bands(edges, dwell);
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 11: Level bands");
+
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  if (cal.load(CAL_ADDRESS) != 0) {
+    Serial.println("No calibration stored, run Example 8 first");
+    while(1);
+  }
+}
+
+void loop()
+{
+  uint16_t ch0, ch1;
+  mc11s_status_t status;
+  mc11s_band_event_t event;
+
+  if (mySensor.singleConversion(&ch0, &ch1, &status) != 0)
+    return;
+
+  if (bands.update(cal.evaluateCounts(ch0, ch1), millis(), &event)) {
+    Serial.print(event.time);
+    Serial.print(" ms: ");
+    Serial.print(event.from == MC11S_BAND_NONE ? "start" : names[event.from]);
+    Serial.print(" -> ");
+    Serial.print(names[event.to]);
+    Serial.print(" at ");
+    Serial.print((event.level + 0x8000L) >> 16);
+    Serial.print(" mm, crossed ");
+    Serial.print(event.time - event.since);
+    Serial.println(" ms ago");
+  }
+  delay(200);
+}
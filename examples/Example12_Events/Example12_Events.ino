@@ -0,0 +1,134 @@
+/******************************************************************************
+  Example12_Events.ino
+
+  Handles the MC11S through event handlers instead of polling each flag.
+  INTB signals every conversion; on each one service() reads STATUS once and
+  calls only the handlers that apply: two data-ready handlers (one prints,
+  one keeps a running average) share a single data burst, the alert handler
+  reports the alarm setting and clearing, the overflow handler backs the
+  range off and the error handler counts failed bus transfers.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  INT (D2) --> INTB
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+
+MC11S_I2C mySensor;
+
+int intPin = 2;
+bool volatile interruptFlag = false;
+
+float average = 0;
+uint16_t errors = 0;
+
+void isr()
+{
+  interruptFlag = true;
+}
+
+void printData(void *arg, uint16_t ch0, uint16_t ch1)
+{
+  Serial.print("ch0 ");
+  Serial.print(ch0);
+  Serial.print(" ch1 ");
+  Serial.print(ch1);
+  Serial.print(" average ratio ");
+  Serial.println(average, 4);
+}
+
+void averageRatio(void *arg, uint16_t ch0, uint16_t ch1)
+{
+  float *avg = (float *)arg;
+
+  if (ch0 != 0)
+    *avg += ((float)ch1 / ch0 - *avg) / 16;
+}
+
+void alert(void *arg, bool active)
+{
+  Serial.println(active ? "ALERT set" : "ALERT cleared");
+}
+
+void overflow(void *arg)
+{
+  bool reranged;
+
+  mySensor.checkRange(&reranged);
+  if (reranged)
+    Serial.println("Overflow, range backed off");
+}
+
+void busError(void *arg, int32_t err)
+{
+  errors++;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 12: Events");
+
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  mySensor.autoRange();
+  mySensor.setAlarmRatio(0.875, 0.91);
+
+  // Handlers run in the order they were added
+  mySensor.onDataReady(averageRatio, &average);
+  mySensor.onDataReady(printData);
+  mySensor.onAlert(alert);
+  mySensor.onOverflow(overflow);
+  mySensor.onError(busError);
+
+  // INTB pulses on every conversion, once a second
+  pinMode(intPin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(intPin), isr, FALLING);
+
+  mySensor.setIntbMode(MC11S_INTB_CONV);
+  mySensor.setIntbStatus(MC11S_INTB_ENABLE);
+  mySensor.setConvTime(MC11S_CONV_1S);
+  mySensor.setConvMode(MC11S_CONT_CONV);
+}
+
+void loop()
+{
+  if (interruptFlag) {
+    interruptFlag = false;
+    mySensor.service();
+  }
+
+  if (errors != 0) {
+    Serial.print(errors);
+    Serial.println(" bus errors");
+    errors = 0;
+  }
+}
@@ -0,0 +1,123 @@
+/******************************************************************************
+  Example13_Timestamps.ino
+
+  Reads every conversion as a timestamped, numbered sample. The MC11S
+  converts four times a second and pulses INTB at the end of each conversion;
+  the interrupt handler stamps the edge, loop() reads the sample. Every ten
+  seconds the sketch reports the conversions that were missed, the samples
+  that came late and the capture jitter.
+
+  The Serial printing is slow enough to lose conversions now and then: set
+  VERBOSE to 0 and watch the missed count stop growing. Leave INTB
+  unconnected (or set USE_INTB to 0) to see the jitter of polling instead.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  INT (D2) --> INTB
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Arduino_Library.h"
+#include "MC11S_Sampler.h"
+#include <Wire.h>
+
+#define USE_INTB        1
+#define VERBOSE         1
+
+MC11S_I2C mySensor;
+MC11S_Sampler sampler;
+
+int intPin = 2;
+unsigned long lastReport = 0;
+
+void isr()
+{
+  sampler.markIntb();
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 13: Timestamped samples");
+
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  // The period is timed by the internal oscillator: measure it first
+  mySensor.calibrateClock();
+
+  mySensor.setConvTime(MC11S_CONV_0S25);
+#if USE_INTB
+  pinMode(intPin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(intPin), isr, FALLING);
+  mySensor.setIntbMode(MC11S_INTB_CONV);
+  mySensor.setIntbStatus(MC11S_INTB_ENABLE);
+#endif
+
+  sampler.begin(&mySensor);
+  Serial.print("Period ");
+  Serial.print(sampler.getPeriod());
+  Serial.println(" us");
+
+  mySensor.setConvMode(MC11S_CONT_CONV);
+}
+
+void loop()
+{
+  mc11s_sample_t sample;
+  bool fresh;
+
+  if (sampler.poll(&sample, &fresh) == 0 && fresh && VERBOSE) {
+    Serial.print(sample.seq);
+    Serial.print(" @ ");
+    Serial.print(sample.timestamp);
+    Serial.print(" us: ");
+    Serial.print(sample.ch0);
+    Serial.print(", ");
+    Serial.println(sample.ch1);
+  }
+
+  if (millis() - lastReport >= 10000) {
+    MC11S_RunningStats<int32_t> &jitter = sampler.getJitter();
+
+    lastReport = millis();
+    Serial.print(sampler.getSampleCount());
+    Serial.print(" samples, ");
+    Serial.print(sampler.getMissedCount());
+    Serial.print(" missed, ");
+    Serial.print(sampler.getLateCount());
+    Serial.print(" late, jitter ");
+    Serial.print(jitter.getMean(), 0);
+    Serial.print(" +/- ");
+    Serial.print(jitter.getStdDev(), 0);
+    Serial.print(" us (");
+    Serial.print(jitter.getMin());
+    Serial.print(" .. ");
+    Serial.print(jitter.getMax());
+    Serial.println(")");
+  }
+}
@@ -0,0 +1,151 @@
+/******************************************************************************
+  Example14_Latency.ino
+
+  Measures how long a conversion result takes to reach the code that acts on
+  it, and where the time goes. INTB interrupts at the end of every
+  conversion; the handler only stamps the time and sets a flag, loop() reads
+  STATUS and data and works out the capacitances. Every 100 conversions the
+  sketch prints a histogram per stage: interrupt to loop(), the bus transfer,
+  the computation and the total.
+
+  The INTB edge itself can't be seen from software on an Uno, so the isr
+  stage stays empty and the total starts at the handler; feed edge() from a
+  timer input capture to include it.
+
+  Uncomment SIMULATED to run the same code against the simulated MC11S on a
+  host or a bare board: its INTB calls the handler directly, its bus runs
+  at 100 kHz, and the report is printed once after 1000 conversions.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  INT (D2) --> INTB
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Latency.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+#endif
+
+#define REPORT_EVERY    100
+
+MC11S_LatencyProbe probe;
+
+int intPin = 2;
+bool volatile interruptFlag = false;
+uint16_t conversions = 0;
+
+void isr()
+{
+  probe.isrEntry();
+  interruptFlag = true;
+}
+
+#ifdef SIMULATED
+void simIntb(void *arg)
+{
+  isr();
+}
+#endif
+
+// The deferred half: everything the interrupt handler doesn't do
+void service()
+{
+  mc11s_status_t status;
+  uint16_t ch0, ch1;
+  float c0, c1;
+
+  interruptFlag = false;
+  probe.dispatch();
+
+  if (mySensor.getStatusData(&status, &ch0, &ch1) != 0)
+    return;
+  probe.transferred();
+
+  mySensor.calcCapacitance(ch0, ch1, &c0, &c1);
+  probe.consumed();
+
+  conversions++;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 14: Latency");
+
+  probe.setTimebase(micros);
+
+#ifdef SIMULATED
+  mySensor.setCapacitance(100, 120);
+  mySensor.setBusRate(100000);
+  mySensor.setIntbHandler(simIntb);
+#else
+  Wire.begin();
+#endif
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  mySensor.setIntbMode(MC11S_INTB_CONV);
+  mySensor.setIntbStatus(MC11S_INTB_ENABLE);
+
+#ifdef SIMULATED
+  // The model converts when told to; each conversion asserts INTB
+  while (conversions < 1000) {
+    mySensor.convert();
+    if (interruptFlag)
+      service();
+  }
+  probe.report(Serial);
+#else
+  pinMode(intPin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(intPin), isr, FALLING);
+
+  mySensor.setConvTime(MC11S_CONV_0S25);
+  mySensor.setConvMode(MC11S_CONT_CONV);
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  if (interruptFlag)
+    service();
+
+  if (conversions >= REPORT_EVERY) {
+    conversions = 0;
+    probe.report(Serial);
+    probe.reset();
+  }
+#endif
+}
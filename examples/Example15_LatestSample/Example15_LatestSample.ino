@@ -0,0 +1,148 @@
+/******************************************************************************
+  Example15_LatestSample.ino
+
+  Hands the latest sample from the code that reads the MC11S to the code
+  that uses it, without the user ever seeing ch0 of one conversion paired
+  with ch1 of another. acquire() reads each conversion and publishes it to
+  an MC11S_LatestSample; report() picks up whatever is newest once a
+  second. report() could just as well run in another task (ESP32, RTOS) or
+  a timer interrupt (with tryRead() there), and acquire() never waits for
+  it.
+
+  Uncomment SIMULATED to run against the simulated MC11S: its INTB calls a
+  handler that reads the model and publishes from the "interrupt", and
+  loop() only reads the cell.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Latest.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+uint32_t conversions = 0;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+MC11S_Sampler sampler;
+#endif
+
+MC11S_LatestSample latest;
+mc11s_seq_t seen = 0;
+unsigned long lastReport = 0;
+
+// Writer side: one publish per conversion, never blocks
+#ifdef SIMULATED
+void simIntb(void *arg)
+{
+  mc11s_sample_t sample;
+
+  if (mySensor.getStatusData(&sample.status, &sample.ch0, &sample.ch1) != 0)
+    return;
+  sample.timestamp = micros();
+  sample.seq = conversions++;
+  latest.publish(sample);
+}
+#else
+void acquire()
+{
+  mc11s_sample_t sample;
+  bool fresh;
+
+  if (sampler.poll(&sample, &fresh) == 0 && fresh)
+    latest.publish(sample);
+}
+#endif
+
+// Reader side: a coherent copy of the newest sample, if there is one
+void report()
+{
+  mc11s_sample_t sample;
+  float c0, c1;
+
+  if (!latest.readNew(&sample, &seen))
+    return;
+
+  mySensor.calcCapacitance(sample.ch0, sample.ch1, &c0, &c1);
+  Serial.print(sample.seq);
+  Serial.print(" @ ");
+  Serial.print(sample.timestamp);
+  Serial.print(" us: ");
+  Serial.print(c0, 3);
+  Serial.print(" pF, ");
+  Serial.print(c1, 3);
+  Serial.println(" pF");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 15: Latest sample");
+
+#ifdef SIMULATED
+  mySensor.setCapacitance(100, 120);
+  mySensor.setIntbHandler(simIntb);
+#else
+  Wire.begin();
+#endif
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+#ifdef SIMULATED
+  mySensor.setIntbMode(MC11S_INTB_CONV);
+  mySensor.setIntbStatus(MC11S_INTB_ENABLE);
+
+  // Several conversions between reads: only the newest is seen
+  for (uint8_t i = 0; i < 5; i++) {
+    for (uint8_t j = 0; j < 4; j++)
+      mySensor.convert();
+    report();
+  }
+  report();		// Nothing new
+#else
+  mySensor.setConvTime(MC11S_CONV_0S25);
+  sampler.begin(&mySensor);
+  mySensor.setConvMode(MC11S_CONT_CONV);
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  acquire();
+
+  if (millis() - lastReport >= 1000) {
+    lastReport = millis();
+    report();
+  }
+#endif
+}
@@ -0,0 +1,179 @@
+/******************************************************************************
+  Example16_Serialize.ino
+
+  Prints a few samples in each format of MC11S_SampleWriter (CSV, JSON and
+  the binary frame, shown in hex), then benchmarks them: every format is
+  written RECORDS times into a Print that only counts the bytes, so the
+  figures are the formatting cost alone. For comparison the same record is
+  also written field by field with Serial-style print() calls and float
+  capacitances, the way the older examples do it.
+
+  Per format it prints the bytes per record, the time and CPU cycles per
+  record, the bytes/s the formatter can produce and how many records/s
+  fit through a 115200 baud link.
+
+  No sensor is needed; the samples are synthetic.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  none
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Serialize.h"
+
+#define RECORDS         1000
+#define LINK_BAUD       115200
+
+// Counts what would have been sent
+class CountingPrint : public Print {
+  public:
+    uint32_t count = 0;
+    size_t write(uint8_t c) { count++; return 1; }
+    size_t write(const uint8_t *buffer, size_t size) { count += size; return size; }
+};
+
+MC11S_SampleWriter writer;
+CountingPrint sink;
+
+void makeSample(uint32_t i, mc11s_sample_t *sample, float *c0, float *c1)
+{
+  memset(sample, 0, sizeof(*sample));
+  sample->seq = i;
+  sample->timestamp = 1000000UL + i * 250000UL;
+  sample->ch0 = 41000 + (i * 37) % 900;
+  sample->ch1 = 49200 + (i * 11) % 40;
+  sample->status.drdy_ch0 = 1;
+  sample->status.drdy_ch1 = 1;
+  *c0 = 100.0f + (i % 900) * 0.011f;
+  *c1 = 120.0f + (i % 40) * 0.003f;
+}
+
+// Field by field, with the float formatting of print()
+size_t printFields(Print &out, const mc11s_sample_t &sample, float c0, float c1)
+{
+  size_t n = 0;
+
+  n += out.print(sample.seq);
+  n += out.print(',');
+  n += out.print(sample.timestamp);
+  n += out.print(',');
+  n += out.print(sample.ch0);
+  n += out.print(',');
+  n += out.print(sample.ch1);
+  n += out.print(',');
+  n += out.print(sample.status.drdy_ch0 << 4 | sample.status.drdy_ch1 << 5 | sample.status.alert << 1 | sample.status.trh_of_d);
+  n += out.print(',');
+  n += out.print(c0, 3);
+  n += out.print(',');
+  n += out.println(c1, 3);
+  return n;
+}
+
+void bench(const char *label, mc11s_ser_format_t format, bool capacitance, bool fields)
+{
+  mc11s_sample_t sample;
+  float c0, c1;
+  unsigned long start, us;
+  float perRecord, bytes;
+
+  writer.setFormat(format);
+  sink.count = 0;
+
+  start = micros();
+  for (uint32_t i = 0; i < RECORDS; i++) {
+    makeSample(i, &sample, &c0, &c1);
+    if (fields)
+      printFields(sink, sample, c0, c1);
+    else if (capacitance)
+      writer.write(sink, sample, c0, c1);
+    else
+      writer.write(sink, sample);
+  }
+  us = micros() - start;
+
+  perRecord = (float)us / RECORDS;
+  bytes = (float)sink.count / RECORDS;
+
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print(bytes, 1);
+  Serial.print(" B, ");
+  Serial.print(perRecord, 2);
+  Serial.print(" us");
+#ifdef F_CPU
+  Serial.print(" (");
+  Serial.print((unsigned long)(perRecord * (F_CPU / 1000000UL)));
+  Serial.print(" cycles)");
+#endif
+  Serial.print(", ");
+  Serial.print(us ? sink.count * 1000000.0f / us : 0, 0);
+  Serial.print(" B/s, link ");
+  Serial.print(LINK_BAUD / 10 / bytes, 0);
+  Serial.println(" rec/s");
+}
+
+void show(const char *label, mc11s_ser_format_t format)
+{
+  mc11s_sample_t sample;
+  uint8_t buf[MC11S_SER_MAX_LEN];
+  float c0, c1;
+  size_t n;
+
+  writer.setFormat(format);
+  Serial.println(label);
+  writer.writeHeader(Serial, true);
+  for (uint32_t i = 0; i < 2; i++) {
+    makeSample(i, &sample, &c0, &c1);
+    if (format != MC11S_SER_BINARY) {
+      writer.write(Serial, sample, c0, c1);
+      continue;
+    }
+
+    n = writer.format(buf, sizeof(buf), sample);
+    for (size_t j = 0; j < n; j++) {
+      if (buf[j] < 0x10)
+        Serial.print('0');
+      Serial.print(buf[j], HEX);
+      Serial.print(' ');
+    }
+    Serial.println();
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 16: Serialize");
+
+  show("CSV", MC11S_SER_CSV);
+  show("JSON", MC11S_SER_JSON);
+  show("Binary", MC11S_SER_BINARY);
+  Serial.println();
+
+  bench("print() fields ", MC11S_SER_CSV, true, true);
+  bench("CSV            ", MC11S_SER_CSV, false, false);
+  bench("CSV + pF       ", MC11S_SER_CSV, true, false);
+  bench("JSON           ", MC11S_SER_JSON, false, false);
+  bench("JSON + pF      ", MC11S_SER_JSON, true, false);
+  bench("Binary         ", MC11S_SER_BINARY, false, false);
+}
+
+void loop()
+{
+}
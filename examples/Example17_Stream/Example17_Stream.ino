@@ -0,0 +1,102 @@
+/******************************************************************************
+  Example17_Stream.ino
+
+  Sends every conversion over Serial as the compact binary stream of
+  MC11S_StreamEncoder instead of text: delta-encoded samples, a key frame
+  every 32 samples, COBS framing and a CRC per frame. Four samples go in
+  each frame, so at 4 Hz a frame leaves once a second with about 7 bytes
+  per sample, against about 32 for a CSV line.
+
+  On the PC, decode it with the tools in extras/stream:
+
+    mc11s_decode -B 115200 /dev/ttyUSB0
+
+  Set SOURCE differently on each node when several share one link.
+
+  Uncomment SIMULATED to stream from the simulated MC11S instead, with the
+  probe capacitance creeping up like a filling tank.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Stream.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+float level = 0;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+#endif
+
+#define SOURCE          0
+
+MC11S_Sampler sampler;
+MC11S_StreamEncoder stream;
+
+void setup()
+{
+  Serial.begin(115200);
+
+#ifdef SIMULATED
+  mySensor.setCapacitance(95, 120);
+#else
+  Wire.begin();
+#endif
+
+  // Nothing but the stream goes out on Serial, so errors just stop here
+  if (mySensor.begin() == false)
+    while(1);
+
+  mySensor.autoRange();
+  mySensor.setConvTime(MC11S_CONV_0S25);
+  sampler.begin(&mySensor);
+
+  stream.begin(Serial, SOURCE);
+  stream.setKeyframeInterval(32);
+  stream.setBatch(4);
+
+  mySensor.setConvMode(MC11S_CONT_CONV);
+}
+
+void loop()
+{
+  mc11s_sample_t sample;
+  bool fresh;
+
+#ifdef SIMULATED
+  // The model converts when told to, at the rate loop() runs
+  level += 0.01f;
+  mySensor.setCapacitance(95 + level, 120);
+  mySensor.convert();
+#endif
+
+  if (sampler.poll(&sample, &fresh) == 0 && fresh)
+    stream.add(sample);
+}
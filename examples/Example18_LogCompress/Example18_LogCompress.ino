@@ -0,0 +1,223 @@
+/******************************************************************************
+  Example18_LogCompress.ino
+
+  Keeps a compressed history of the samples, as a node would while its
+  uplink is down, and measures what it costs. Samples go into 256 byte
+  blocks (a flash page) with MC11S_LogEncoder: delta-of-delta timestamps
+  and small variable length steps for the counts. Every block that fills up
+  is "stored" (here: decoded again and checked), and the sketch reports
+
+    bytes/sample    against 13 bytes for a packed record (seq, timestamp,
+                    both channels, status) and 8 for the bare counts and
+                    timestamp
+    encode, decode  time and CPU cycles per sample
+
+  The working set is the block buffer and a few words of state, however
+  long the log gets.
+
+  Uncomment SIMULATED to run it on 4000 samples of a simulated tank that
+  fills and drains (4 Hz, sensor noise, timestamp jitter and the odd missed
+  conversion) and print the results once.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Compress.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+#include <math.h>
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+MC11S_Sampler sampler;
+#endif
+
+#define BLOCK_SIZE      256
+#define SIM_SAMPLES     4000
+
+uint8_t block[BLOCK_SIZE];
+MC11S_LogEncoder logger;
+MC11S_LogDecoder reader;
+
+uint32_t samples = 0, blocks = 0, stored = 0, errors = 0;
+uint32_t encodeUs = 0, decodeUs = 0;
+uint32_t recordedSum = 0, storedSum = 0;
+
+uint32_t checksum(const mc11s_sample_t &sample)
+{
+  return sample.seq + sample.timestamp + sample.ch0 + ((uint32_t)sample.ch1 << 16);
+}
+
+void printCost(const char *label, uint32_t us, uint32_t n)
+{
+  float perSample = n ? (float)us / n : 0;
+
+  Serial.print(label);
+  Serial.print(perSample, 2);
+  Serial.print(" us/sample");
+#ifdef F_CPU
+  Serial.print(" (");
+  Serial.print((unsigned long)(perSample * (F_CPU / 1000000UL)));
+  Serial.print(" cycles)");
+#endif
+  Serial.println();
+}
+
+void report()
+{
+  float perSample = samples ? (float)stored / samples : 0;
+
+  Serial.print(samples);
+  Serial.print(" samples in ");
+  Serial.print(blocks);
+  Serial.print(" blocks, ");
+  Serial.print(stored);
+  Serial.print(" B: ");
+  Serial.print(perSample, 2);
+  Serial.print(" B/sample, ");
+  Serial.print(perSample ? 13 / perSample : 0, 1);
+  Serial.print("x packed records, ");
+  Serial.print(perSample ? 8 / perSample : 0, 1);
+  Serial.println("x bare counts + timestamp");
+  printCost("encode ", encodeUs, samples);
+  printCost("decode ", decodeUs, samples);
+  Serial.print(errors ? "MISMATCH in " : "round trip ok, ");
+  if (errors) {
+    Serial.print(errors);
+    Serial.println(" blocks");
+  } else {
+    Serial.println("every block decoded to the samples recorded");
+  }
+}
+
+// A full block would be written to flash here; read it back instead
+void store(uint16_t len)
+{
+  mc11s_sample_t sample;
+  uint32_t sum = 0, start;
+  uint16_t n = 0;
+
+  blocks++;
+  stored += len;
+
+  start = micros();
+  if (reader.begin(block, BLOCK_SIZE) == 0)
+    while (reader.next(&sample)) {
+      sum += checksum(sample);
+      n++;
+    }
+  decodeUs += micros() - start;
+
+  storedSum += sum;
+  if (n != logger.getCount() || storedSum != recordedSum)
+    errors++;
+}
+
+void record(const mc11s_sample_t &sample)
+{
+  uint32_t start = micros();
+  bool ok = logger.add(sample);
+
+  if (!ok) {
+    encodeUs += micros() - start;
+    store(logger.finish());
+    start = micros();
+    logger.begin(block, BLOCK_SIZE);
+    logger.add(sample);
+  }
+  encodeUs += micros() - start;
+
+  recordedSum += checksum(sample);
+  samples++;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 18: Log compression");
+
+#ifndef SIMULATED
+  Wire.begin();
+#endif
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  logger.begin(block, BLOCK_SIZE);
+
+#ifdef SIMULATED
+  // Ranged at the empty tank, where the probe capacitance is smallest
+  mySensor.setCapacitance(95, 120);
+  mySensor.autoRange();
+  mySensor.setNoise(40);
+
+  mc11s_sample_t sample;
+  uint32_t seq = 0, rng = 1;
+
+  for (uint16_t i = 0; i < SIM_SAMPLES; i++) {
+    float level = 0.5f - 0.5f * cosf(6.2832f * i / 2000.0f);
+
+    mySensor.setCapacitance(95 + 30 * level, 120);
+    mySensor.convert();
+    mySensor.getStatusData(&sample.status, &sample.ch0, &sample.ch1);
+
+    rng = rng * 1664525UL + 1013904223UL;
+    seq += ((rng >> 24) < 2) ? 2 : 1;
+    sample.seq = seq;
+    sample.timestamp = seq * 250000UL + (rng >> 8) % 801;
+    record(sample);
+  }
+
+  store(logger.finish());		// The last, partly filled block
+  report();
+#else
+  mySensor.autoRange();
+  mySensor.setConvTime(MC11S_CONV_0S25);
+  sampler.begin(&mySensor);
+  mySensor.setConvMode(MC11S_CONT_CONV);
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  mc11s_sample_t sample;
+  bool fresh;
+  uint32_t before = blocks;
+
+  if (sampler.poll(&sample, &fresh) == 0 && fresh)
+    record(sample);
+
+  if (blocks != before)
+    report();
+#endif
+}
@@ -0,0 +1,149 @@
+/******************************************************************************
+  Example19_FilterBench.ino
+
+  Benchmarks every stage of MC11S_Filters.h on one channel: the time and
+  CPU cycles per sample and the RAM each stage takes (its sizeof, all the
+  state it has). Every stage filters the same SAMPLES synthetic counts,
+  PASSES times over: a slow level change with noise and the odd splash
+  spike. The time of a pass-through stage is taken off, so the figures
+  are the stage alone.
+
+  Flash: set FLASH_STAGE to the number of one stage (as listed) and note
+  the "Sketch uses ... bytes" of the build; the same with FLASH_STAGE 0
+  (pass-through only) subtracted is the program memory that stage costs.
+  A stage type used with another sample type or size is another copy.
+
+  extras/bench/mc11s_filter_bench runs the same measurement on a host.
+
+  No sensor is needed; the samples are synthetic.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  none
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Filters.h"
+
+#define SAMPLES         2000
+#define PASSES          10      // Over the same samples, for timer resolution
+#define FLASH_STAGE     -1      // -1 -> all stages, 0 -> pass-through only, n -> stage n only
+
+#define STAGE(n)        (FLASH_STAGE < 0 || FLASH_STAGE == (n))
+
+volatile uint16_t sink;         // Keeps the outputs from being optimised away
+uint32_t rng;
+float baseUs = 0;
+
+// Counts around 40000: a slow ramp, +/-32 counts of noise, a spike every 200 samples
+uint16_t nextSample(uint16_t i)
+{
+  rng = rng * 1664525UL + 1013904223UL;
+  uint16_t v = 40000 + i / 4 + (uint16_t)(rng >> 26);
+  return (i % 200 == 199) ? v + 3000 : v;
+}
+
+// Time per sample of stage over the synthetic stream, us
+template <class Stage>
+float timeStage(Stage &stage)
+{
+  unsigned long start;
+  uint16_t i, out;
+  uint8_t pass;
+
+  start = micros();
+  for (pass = 0; pass < PASSES; pass++) {
+    stage.reset();
+    rng = 1;
+    for (i = 0; i < SAMPLES; i++)
+      if (stage.push(nextSample(i), &out))
+        sink = out;
+  }
+
+  return (float)(micros() - start) / ((float)SAMPLES * PASSES);
+}
+
+template <class Stage>
+void bench(uint8_t n, const char *name)
+{
+  static Stage stage;
+  float us = timeStage(stage) - baseUs;
+
+  if (us < 0)
+    us = 0;
+
+  Serial.print(n);
+  Serial.print(". ");
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us, 3);
+  Serial.print(" us/sample");
+#ifdef F_CPU
+  Serial.print(", ");
+  Serial.print((unsigned long)(us * (F_CPU / 1000000UL)));
+  Serial.print(" cycles");
+#endif
+  Serial.print(", ");
+  Serial.print((unsigned)sizeof(Stage));
+  Serial.println(" B RAM");
+}
+
+void setup()
+{
+  static MC11S_NoFilter<uint16_t> pass;
+
+  Serial.begin(115200);
+  Serial.println("MC11S Example 19: Filter stage benchmark");
+  Serial.print(SAMPLES);
+  Serial.println(" samples per stage, one channel");
+
+  // The loop and the sample generator, taken off every stage below
+  baseUs = timeStage(pass);
+  Serial.print("0. pass-through (loop + generator): ");
+  Serial.print(baseUs, 3);
+  Serial.println(" us/sample");
+
+#if STAGE(1)
+  bench<MC11S_MovingAverage<uint16_t, 8> >(1, "MovingAverage<uint16_t, 8>");
+#endif
+#if STAGE(2)
+  bench<MC11S_MovingAverage<uint16_t, 32> >(2, "MovingAverage<uint16_t, 32>");
+#endif
+#if STAGE(3)
+  bench<MC11S_ExpIIR<uint16_t, 3> >(3, "ExpIIR<uint16_t, 3>");
+#endif
+#if STAGE(4)
+  bench<MC11S_Median<uint16_t, 5> >(4, "Median<uint16_t, 5>");
+#endif
+#if STAGE(5)
+  bench<MC11S_Median<uint16_t, 9> >(5, "Median<uint16_t, 9>");
+#endif
+#if STAGE(6)
+  bench<MC11S_Hampel<uint16_t, 7> >(6, "Hampel<uint16_t, 7>");
+#endif
+#if STAGE(7)
+  bench<MC11S_CIC<uint16_t, 4, 2> >(7, "CIC<uint16_t, 4, 2> (per input)");
+#endif
+#if STAGE(8)
+  bench<MC11S_Pipeline<MC11S_Hampel<uint16_t, 7>, MC11S_MovingAverage<uint16_t, 8> > >(8, "Hampel 7 + MovingAverage 8");
+#endif
+}
+
+void loop()
+{
+}
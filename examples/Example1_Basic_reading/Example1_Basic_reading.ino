@@ -53,6 +53,9 @@ void setup()
     }
 
     mySensor.reset();
+
+    // VT is read on A2 with analogRead(), 5 V reference
+    mySensor.setTempPin(A2);
     delay(500);
 }
 
@@ -75,41 +78,42 @@ void loop()
         uint16_t data_ch0, data_ch1;
 
         mySensor.getCh0Data(&data_ch0);
-        Serial.println("Ch0 Data: " + String(data_ch0));
+        Serial.print("Ch0 Data: ");
+        Serial.println(data_ch0);
 
         mySensor.getCh1Data(&data_ch1);
-        Serial.println("Ch1 Data: " + String(data_ch1));
+        Serial.print("Ch1 Data: ");
+        Serial.println(data_ch1);
         delay(200);
 
         // Step 2b: get Fin_div
         mc11s_fin_div_val_t Fin_div_val;
         mySensor.getFinDiv(&Fin_div_val);
 
-        Serial.println("Fin Div: " + String(Fin_div_val));
+        Serial.print("Fin Div: ");
+        Serial.println(Fin_div_val);
         delay(200);
 
         if (Fin_div_val > MC11S_FIN_DIV_256)
             Fin_div_val = MC11S_FIN_DIV_256;
 
-        //Fin_div = 2 ^ Fin_div_val;
-
         // Step 2c: get Fclk
-        uint32_t Fclk = 2400000;    // 2.4 MHz CLK based on datasheet
+        uint32_t Fclk = mySensor.getRefClock();    // Selected reference, calibrated
 
         // Step 2d: get Fref_div
-        uint16_t Fref_div;
+        uint8_t Fref_div;
 
-        mySensor.getFrefDiv((uint8_t*) &Fref_div);
-        Serial.println("Fref: " + String(Fref_div + 1));
+        mySensor.getFrefDiv(&Fref_div);
+        Serial.print("Fref: ");
+        Serial.println(Fref_div + 1);
         delay(200);
 
-        //Fref_div = Fref_div + 1;    // Fref value from 1 to 256
-
         // Step 2e: get RCNT
         uint16_t rcnt;
 
         mySensor.getRcnt(&rcnt);
-        Serial.println("RCNT: " + String(rcnt));
+        Serial.print("RCNT: ");
+        Serial.println(rcnt);
         delay(200);
 
         // Step 2f: get Idrv
@@ -150,27 +154,35 @@ void loop()
                 break;
         }
 
-        Serial.println("Idrv: " + String(Idrv));
+        Serial.print("Idrv: ");
+        Serial.println(Idrv);
         delay(200);
 
         // Step 3: Calculate Cref
-        // C = k * Idrv /(data_chx * Fin_div * (Fclk /(Fref_div + 1))/ RCNT)
+        // Fsensor = data_chx * Fin_div * (Fclk / (Fref_div + 1)) / RCNT
+        // C = K * Idrv / Fsensor, with Idrv in uA and Fsensor in MHz -> pF
         float Cref, Csensor;
-        Cref = (float) (K * Idrv / (data_ch1 * (2 ^ Fin_div_val) * (Fclk / (Fref_div + 1)) / rcnt));
-        Serial.println("Cref: " + String(Cref) + " pF");
+        Cref = (float) (K * Idrv * 1e6 / ((float) data_ch1 * (1UL << Fin_div_val) * ((float) Fclk / (Fref_div + 1)) / rcnt));
+        Serial.print("Cref: ");
+        Serial.print(Cref);
+        Serial.println(" pF");
 
         // Step 4: Calculate Csensor
-        Csensor = (float) (K * Idrv / (data_ch0 * (2 ^ Fin_div_val) * (Fclk / (Fref_div + 1)) / rcnt));
-        Serial.println("Csensor: " + String(Csensor) + " pF");
+        Csensor = (float) (K * Idrv * 1e6 / ((float) data_ch0 * (1UL << Fin_div_val) * ((float) Fclk / (Fref_div + 1)) / rcnt));
+        Serial.print("Csensor: ");
+        Serial.print(Csensor);
+        Serial.println(" pF");
 
         // Step 5: start new conversion cycle
         mySensor.setConvMode(MC11S_CONT_CONV); 
 
-        float voltage = (analogRead(A2) * 5.0) / 1023;
-        Serial.println("Voltage: " + String(voltage) + " mV");
-        float temp = (-560.0 * voltage) + 386.3;
+        // Step 6: VT temperature, 16 ADC samples averaged
+        float temp;
+        mySensor.getTemperature(&temp);
 
-        Serial.println("Temp: " + String(temp) + " C");
+        Serial.print("Temp: ");
+        Serial.print(temp);
+        Serial.println(" C");
    } 
    Serial.println("------------------------");
    delay(2000);
@@ -0,0 +1,221 @@
+/******************************************************************************
+  Example20_SpikeBench.ino
+
+  Splash spikes against the level alarm. The chip's glitch filter removes
+  electrical glitches, but a splash is a real change of the capacitance
+  for one conversion and goes straight through it. A Hampel stage
+  (MC11S_Hampel, 7 samples) in front of the alarm replaces such single
+  samples with the median and lets genuine level changes through a few
+  samples late.
+
+  The alarm is Csensor / Cref above TRIP, released below RELEASE. On the
+  hardware both alarms, on the raw and on the filtered counts, are printed
+  as they change.
+
+  Uncomment SIMULATED to benchmark it instead: 20000 conversions (4 Hz, 83
+  minutes) of a sump whose level ripples 2% below the alarm, with 5 fills
+  above it, splashes of +15% in 1% of the conversions and electrical
+  glitches in 0.5% of them. Three configurations are run: no filtering,
+  the chip's glitch filter, and the glitch filter with the Hampel stage.
+  Each reports the false alerts, the fills caught and how late on average.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Filters.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+#endif
+
+#define TRIP            1.10    // Csensor / Cref
+#define RELEASE         1.07
+
+MC11S_DualFilter<MC11S_Hampel<uint16_t, 7> > rejector;
+
+// Alarm with hysteresis on the ratio of a pair of counts; true on the rising edge
+bool alarmRises(bool *alarm, uint16_t ch0, uint16_t ch1)
+{
+  float ratio = ch0 ? (float)ch1 / ch0 : 0;      // Counts fall as the capacitance rises
+  bool was = *alarm;
+
+  if (ratio > TRIP)
+    *alarm = true;
+  else if (ratio < RELEASE)
+    *alarm = false;
+
+  return *alarm && !was;
+}
+
+#ifdef SIMULATED
+#define CONVERSIONS     20000UL
+#define FILLS           5
+#define FILL_LENGTH     300     // Conversions above the alarm
+#define FILL_LEVEL      1.15
+#define SPLASH_RATE     0.01
+#define SPLASH_SIZE     0.15
+
+uint32_t rng;
+
+float uniform()
+{
+  rng = rng * 1664525UL + 1013904223UL;
+  return (rng >> 8) / 16777216.0;
+}
+
+uint32_t fillStart(uint8_t i)
+{
+  return (i + 1) * (CONVERSIONS / (FILLS + 1));
+}
+
+// Index of the fill conversion n belongs to, or -1; an alert until it is released counts for it
+int8_t inFill(uint32_t n)
+{
+  for (uint8_t i = 0; i < FILLS; i++)
+    if (n >= fillStart(i) && n < fillStart(i) + FILL_LENGTH + 20)
+      return i;
+  return -1;
+}
+
+void run(const char *label, bool glitchFilter, bool hampel)
+{
+  uint32_t n, falseAlerts = 0, caught = 0, lateSum = 0;
+  bool alarm = false, counted[FILLS] = {};
+  uint16_t ch0, ch1, out0, out1;
+
+  mySensor.begin();
+  mySensor.setCapacitance(100, 100);
+  mySensor.autoRange();
+  mySensor.setNoise(200, 0.005, 0.2);
+  mySensor.setGlitchFilter(glitchFilter ? MC11S_GLITCH_FILTER_ENABLE : MC11S_GLITCH_FILTER_DISABLE);
+  rejector.reset();
+  rng = 1;
+
+  for (n = 0; n < CONVERSIONS; n++) {
+    int8_t fill = inFill(n);
+    float level = 1 + 0.02 * sin(2 * PI * n / 2400.0);
+
+    if (fill >= 0 && n < fillStart(fill) + FILL_LENGTH)
+      level = FILL_LEVEL;
+    if (uniform() < SPLASH_RATE)
+      level *= 1 + SPLASH_SIZE;
+
+    mySensor.setCapacitance(100 * level, 100);
+    mySensor.convert();
+    if (mySensor.getData(&ch0, &ch1) != 0)
+      continue;
+
+    if (hampel) {
+      rejector.push(ch0, ch1, &out0, &out1);
+      ch0 = out0;
+      ch1 = out1;
+    }
+
+    if (alarmRises(&alarm, ch0, ch1)) {
+      if (fill < 0) {
+        falseAlerts++;
+      } else if (!counted[fill]) {
+        counted[fill] = true;
+        caught++;
+        lateSum += n - fillStart(fill);
+      }
+    }
+  }
+
+  Serial.print(label);
+  Serial.print(falseAlerts);
+  Serial.print(" false alerts, ");
+  Serial.print(caught);
+  Serial.print("/");
+  Serial.print(FILLS);
+  Serial.print(" fills caught, ");
+  Serial.print(caught ? (float)lateSum / caught : 0, 1);
+  Serial.print(" conversions late");
+  if (hampel) {
+    Serial.print(", ");
+    Serial.print(rejector.ch0().getRejected() + rejector.ch1().getRejected());
+    Serial.print(" samples replaced");
+  }
+  Serial.println();
+}
+#else
+bool rawAlarm = false, filteredAlarm = false;
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 20: Splash spikes and the level alarm");
+
+#ifdef SIMULATED
+  Serial.print(CONVERSIONS);
+  Serial.print(" conversions, ");
+  Serial.print(SPLASH_RATE * 100, 1);
+  Serial.println("% splashes");
+  run("No filtering:           ", false, false);
+  run("Chip glitch filter:     ", true, false);
+  run("Glitch filter + Hampel: ", true, true);
+#else
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  mySensor.autoRange();
+  mySensor.setGlitchFilter(MC11S_GLITCH_FILTER_ENABLE);
+  mySensor.setConvTime(MC11S_CONV_0S25);
+  mySensor.setConvMode(MC11S_CONT_CONV);
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  mc11s_status_t status;
+  uint16_t ch0, ch1, out0, out1;
+
+  if (mySensor.getStatus(&status) != 0 || !mySensor.isDataReady(status) || mySensor.getData(&ch0, &ch1) != 0)
+    return;
+
+  rejector.push(ch0, ch1, &out0, &out1);
+
+  if (alarmRises(&rawAlarm, ch0, ch1))
+    Serial.println("Alert on the raw counts");
+  if (alarmRises(&filteredAlarm, out0, out1)) {
+    Serial.print("Alert after the Hampel stage, ");
+    Serial.print(rejector.ch0().getRejected() + rejector.ch1().getRejected());
+    Serial.println(" samples replaced so far");
+  }
+#endif
+}
@@ -0,0 +1,228 @@
+/******************************************************************************
+  Example21_LeakBench.ino
+
+  Level and rate of a tank from the Kalman estimator in MC11S_Kalman.h,
+  with the rate alarm catching fills, drains and slow leaks. The level is
+  the Csensor / Cref ratio scaled by 10000, so the fixed point filter gets
+  whole units (1.0 -> 10000) and its rate resolves to well below a unit
+  an hour. One conversion a second; level and rate are printed as the rate
+  alarm changes.
+
+  Uncomment SIMULATED to benchmark the detection delay instead. The
+  simulated probe goes from 100 pF (empty, 10000 units) to 150 pF (full,
+  15000 units), with conversion noise and a slow slosh. Each scenario is
+  an hour of still water, where any alarm is a false one, followed by a
+  fill (full in 30 minutes), a drain (empty in 15) or a leak (2% of the
+  tank an hour). Each is detected by
+
+    threshold   the level leaving a band of BAND units around where it
+                was when the event started: the simple way
+    Kalman      the rate alarm of MC11S_LevelKalman<float>
+    fixed       the rate alarm of MC11S_LevelKalmanFixed
+
+  and the delay from the start of the event is printed (- if not within
+  two hours).
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Kalman.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+#endif
+
+#define SCALE           10000.0 // Units per unit of Csensor / Cref
+#define PERIOD          1.0     // Seconds between conversions
+#define Q               1e-6    // Process noise, units^2/s^3: how fast the rate may wander
+#define R               4.0     // Measurement noise, units^2
+#define TRIP            0.015   // Rate alarm, units/s (a 2%/hour leak is 0.028)
+#define RELEASE         0.008
+#define BAND            50      // Level threshold, units (1% of the tank)
+
+MC11S_LevelKalman<float> kalman;
+MC11S_LevelKalmanFixed fixed;
+
+// One conversion as a level in units
+bool readLevel(int32_t *level)
+{
+  mc11s_status_t status;
+  uint16_t ch0, ch1;
+
+#ifdef SIMULATED
+  mySensor.convert();
+  if (mySensor.getStatusData(&status, &ch0, &ch1) != 0 || ch0 == 0)
+    return false;
+#else
+  if (mySensor.singleConversion(&ch0, &ch1, &status) != 0 || ch0 == 0)
+    return false;
+#endif
+
+  // Counts fall as the capacitance rises: Csensor / Cref = ch1 / ch0
+  *level = (int32_t)(SCALE * ch1 / ch0 + 0.5);
+  return true;
+}
+
+void setupFilters()
+{
+  kalman.setNoise(Q, R);
+  kalman.setPeriod(PERIOD);
+  kalman.setRateAlarm(TRIP, RELEASE);
+
+  fixed.setNoise(Q, R);
+  fixed.setPeriod(PERIOD);
+  fixed.setRateAlarm(TRIP, RELEASE);
+}
+
+#ifdef SIMULATED
+#define STILL           3600UL  // Seconds of still water before each event
+#define TIMEOUT         7200UL
+
+// Simulated tank at second t: level 0..1 plus a slosh, as Csensor in pF
+void setLevel(float h, uint32_t t)
+{
+  h += 0.0005 * sin(2 * PI * t / 37.0);
+  mySensor.setCapacitance(100 + 50 * h, 100);
+}
+
+void printDelay(const char *label, int32_t delay)
+{
+  Serial.print(label);
+  if (delay < 0) {
+    Serial.print("-");
+  } else {
+    Serial.print(delay);
+    Serial.print(" s");
+  }
+}
+
+// Still water, then the level moving at rate (tank per second) until everything has detected it
+void scenario(const char *name, float start, float rate)
+{
+  int32_t level, ref = 0, delay[3] = { -1, -1, -1 };
+  uint32_t t, falseAlarms = 0;
+  mc11s_rate_state_t expect = (rate > 0) ? MC11S_RATE_RISING : MC11S_RATE_FALLING;
+  float h = start;
+
+  kalman = MC11S_LevelKalman<float>();
+  fixed = MC11S_LevelKalmanFixed();
+  setupFilters();
+
+  for (t = 0; t < STILL + TIMEOUT; t++) {
+    if (t >= STILL) {
+      h += rate * PERIOD;
+      if (h < 0)
+        h = 0;
+      if (h > 1)
+        h = 1;
+    }
+    setLevel(h, t);
+
+    if (!readLevel(&level))
+      continue;
+    kalman.update(level);
+    fixed.update(level);
+
+    if (t < STILL) {
+      // Alarms in still water are false; the threshold is set where the level sits
+      if (t > 600 && (kalman.getRateState() != MC11S_RATE_STEADY || fixed.getRateState() != MC11S_RATE_STEADY))
+        falseAlarms++;
+      ref = (t < 600) ? level : ref + (level - ref) / 16;
+      continue;
+    }
+
+    if (delay[0] < 0 && (level > ref + BAND || level < ref - BAND))
+      delay[0] = t - STILL;
+    if (delay[1] < 0 && kalman.getRateState() == expect)
+      delay[1] = t - STILL;
+    if (delay[2] < 0 && fixed.getRateState() == expect)
+      delay[2] = t - STILL;
+    if (delay[0] >= 0 && delay[1] >= 0 && delay[2] >= 0)
+      break;
+  }
+
+  Serial.print(name);
+  printDelay("threshold ", delay[0]);
+  printDelay(", Kalman ", delay[1]);
+  printDelay(", fixed ", delay[2]);
+  Serial.print("; in alarm before it: ");
+  Serial.print(falseAlarms);
+  Serial.println(" s");
+}
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 21: Level and rate, leak detection");
+
+#ifdef SIMULATED
+  mySensor.begin();
+  mySensor.setCapacitance(125, 100);
+  mySensor.autoRange();
+  mySensor.setNoise(300);
+
+  scenario("Fill  (full in 30 min):  ", 0.2, 1.0 / 1800);
+  scenario("Drain (empty in 15 min): ", 0.8, -1.0 / 900);
+  scenario("Leak  (2% an hour):      ", 0.8, -0.02 / 3600);
+#else
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  mySensor.autoRange();
+  setupFilters();
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  int32_t level;
+
+  if (readLevel(&level) && fixed.update(level)) {
+    switch (fixed.getRateState()) {
+      case MC11S_RATE_RISING:  Serial.print("Filling, "); break;
+      case MC11S_RATE_FALLING: Serial.print("Draining or leaking, "); break;
+      default:                 Serial.print("Steady, "); break;
+    }
+    Serial.print(fixed.getLevel());
+    Serial.print(" units, ");
+    Serial.print(fixed.getRate() * 3600, 1);
+    Serial.println(" units/hour");
+  }
+  delay(1000 * PERIOD);
+#endif
+}
@@ -0,0 +1,241 @@
+/******************************************************************************
+  Example22_QuantileBench.ino
+
+  Accuracy and memory of the streaming quantile estimators in
+  MC11S_Quantile.h against the exact quantiles. SAMPLES synthetic counts
+  of each of four shapes of day are fed to
+
+    P2          three MC11S_P2Quantile, one each for p5, p50 and p95
+    hist 32     MC11S_QuantileHistogram<32>
+    hist 64     MC11S_QuantileHistogram<64>
+    merged      four MC11S_QuantileHistogram<32>, each fed every fourth
+                sample as four nodes would be, merged into one
+
+  and p5/p50/p95 are read back. The exact quantiles need no buffer: the
+  samples are generated again from the same seed as often as needed and
+  counted (a binary search over the counts), so this runs on an Uno too,
+  in about a minute. For each estimate the sketch prints the error in
+  counts and the rank error: how far, in percent of the samples, the
+  estimate is from the rank it should have. Then the RAM each takes.
+
+  What to expect: a histogram is off by at most one bin, and its bins
+  widen with the range of the day, so two levels far apart leave few bins
+  for the samples around each. P2 tracks those well but lags when the
+  distribution moves through the day (drift).
+
+  No sensor is needed; the samples are synthetic.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  none
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Quantile.h"
+#include <math.h>
+
+#define SAMPLES         10000UL
+#define NODES           4       // Sketches merged in the last row
+
+const float quantiles[3] = { 0.05, 0.50, 0.95 };
+
+enum shape_t { NORMAL, SKEWED, TWO_LEVELS, DRIFT };
+
+uint32_t rng;
+
+float uniform()
+{
+  rng = rng * 1664525UL + 1013904223UL;
+  return ((rng >> 8) + 0.5) / 16777216.0;
+}
+
+// Sample i of the day, in counts
+uint16_t sample(shape_t shape, uint32_t i)
+{
+  float noise = (uniform() + uniform() + uniform() + uniform() - 2) * 60;   // About 35 counts rms
+
+  switch (shape) {
+    case SKEWED:     return 40000 - 120 * log(uniform());                    // Mostly quiet, long tail of ripples
+    case TWO_LEVELS: return (uniform() < 0.7 ? 38000 : 42000) + noise;       // The tank sits at one of two levels
+    case DRIFT:      return 40000 + 1000.0 * i / SAMPLES + noise;            // Slow fill over the day
+    default:         return 40000 + noise;
+  }
+}
+
+// Samples at or below v, and below v
+void countAt(shape_t shape, uint16_t v, uint32_t *atOrBelow, uint32_t *below)
+{
+  uint32_t i;
+
+  *atOrBelow = *below = 0;
+  rng = 1;
+  for (i = 0; i < SAMPLES; i++) {
+    uint16_t x = sample(shape, i);
+
+    if (x <= v)
+      (*atOrBelow)++;
+    if (x < v)
+      (*below)++;
+  }
+}
+
+// Smallest count with a fraction q of the samples at or below it
+uint16_t exactQuantile(shape_t shape, float q)
+{
+  uint32_t lo = 0, hi = 65535, atOrBelow, below;
+
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+
+    countAt(shape, mid, &atOrBelow, &below);
+    if (atOrBelow >= q * SAMPLES)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
+
+// Distance from q to the ranks v covers, in percent of the samples; v is rounded to a count
+float rankError(shape_t shape, float v, float q)
+{
+  uint32_t atOrBelow, below;
+
+  countAt(shape, (uint16_t)(v + 0.5), &atOrBelow, &below);
+  if (q * SAMPLES < below)
+    return 100.0 * (below - q * SAMPLES) / SAMPLES;
+  if (q * SAMPLES > atOrBelow)
+    return 100.0 * (q * SAMPLES - atOrBelow) / SAMPLES;
+  return 0;
+}
+
+void printRow(const char *name, shape_t shape, const float *est, const uint16_t *exact)
+{
+  uint8_t k;
+
+  Serial.print(name);
+  for (k = 0; k < 3; k++) {
+    Serial.print("  ");
+    Serial.print(est[k], 1);
+    Serial.print(" (");
+    Serial.print(est[k] - exact[k], 1);
+    Serial.print(", ");
+    Serial.print(rankError(shape, est[k], quantiles[k]), 2);
+    Serial.print("%)");
+  }
+  Serial.println();
+}
+
+void run(const char *label, shape_t shape)
+{
+  static MC11S_P2Quantile p2[3];
+  static MC11S_QuantileHistogram<32> hist32, node[NODES];
+  static MC11S_QuantileHistogram<64> hist64;
+  uint16_t exact[3];
+  float est[3];
+  uint32_t i;
+  uint8_t k;
+
+  for (k = 0; k < 3; k++) {
+    p2[k].setQuantile(quantiles[k]);
+    exact[k] = exactQuantile(shape, quantiles[k]);
+  }
+  hist32.reset();
+  hist64.reset();
+  for (k = 0; k < NODES; k++)
+    node[k].reset();
+
+  rng = 1;
+  for (i = 0; i < SAMPLES; i++) {
+    uint16_t x = sample(shape, i);
+
+    for (k = 0; k < 3; k++)
+      p2[k].add(x);
+    hist32.add(x);
+    hist64.add(x);
+    node[i % NODES].add(x);
+  }
+  for (k = 1; k < NODES; k++)
+    node[0].merge(node[k]);
+
+  Serial.println(label);
+  Serial.print("  exact      ");
+  for (k = 0; k < 3; k++) {
+    Serial.print("  ");
+    Serial.print(exact[k]);
+  }
+  Serial.println();
+
+  for (k = 0; k < 3; k++)
+    est[k] = p2[k].get();
+  printRow("  P2         ", shape, est, exact);
+
+  for (k = 0; k < 3; k++)
+    est[k] = hist32.quantile(quantiles[k]);
+  printRow("  hist 32    ", shape, est, exact);
+
+  for (k = 0; k < 3; k++)
+    est[k] = hist64.quantile(quantiles[k]);
+  printRow("  hist 64    ", shape, est, exact);
+
+  for (k = 0; k < 3; k++)
+    est[k] = node[0].quantile(quantiles[k]);
+  printRow("  merged     ", shape, est, exact);
+
+  Serial.print("  bin width: hist 32 ");
+  Serial.print(hist32.getBinWidth());
+  Serial.print(", hist 64 ");
+  Serial.print(hist64.getBinWidth());
+  Serial.print(", merged ");
+  Serial.println(node[0].getBinWidth());
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 22: Streaming quantiles against exact ones");
+  Serial.print(SAMPLES);
+  Serial.println(" samples a day; p5 p50 p95 as estimate (error in counts, rank error)");
+
+  run("Normal noise:", NORMAL);
+  run("Skewed (ripples):", SKEWED);
+  run("Two levels:", TWO_LEVELS);
+  run("Drift over the day:", DRIFT);
+
+  Serial.println("RAM:");
+  Serial.print("  P2 x3      ");
+  Serial.print((unsigned)(3 * sizeof(MC11S_P2Quantile)));
+  Serial.println(" B");
+  Serial.print("  hist 32    ");
+  Serial.print((unsigned)sizeof(MC11S_QuantileHistogram<32>));
+  Serial.print(" B, ");
+  Serial.print((unsigned)MC11S_QuantileHistogram<32>::kPackedSize);
+  Serial.println(" B packed");
+  Serial.print("  hist 64    ");
+  Serial.print((unsigned)sizeof(MC11S_QuantileHistogram<64>));
+  Serial.print(" B, ");
+  Serial.print((unsigned)MC11S_QuantileHistogram<64>::kPackedSize);
+  Serial.println(" B packed");
+  Serial.print("  exact      ");
+  Serial.print((unsigned long)(SAMPLES * sizeof(uint16_t)));
+  Serial.println(" B to buffer the samples");
+}
+
+void loop()
+{
+}
@@ -46,9 +46,10 @@ int intPin = 2;
 // Star the flag as false
 bool volatile interruptFlag = false;
 
-// Threshold values
-uint8_t highThreshold = 72;
-uint8_t lowThreshold  = 70;
+// Alarm points as Csensor / Cref: the alert sets when the ratio falls to
+// tripRatio and clears once it is back above releaseRatio
+float tripRatio    = 0.875;
+float releaseRatio = 0.91;
 float Cref, Csensor;
 
 // ISR to set the triggered interrupt
@@ -71,11 +72,18 @@ void setupSensor() {
   // Step 4: Set conversion time to convert every second
   mySensor.setConvTime(MC11S_CONV_1S);
 
-  // Step 5: Set High Threshold
-  mySensor.setTrh(highThreshold);
+  // Step 5: Program TRH/TRL from the trip and release ratios
+  if (mySensor.setAlarmRatio(tripRatio, releaseRatio) != 0) {
+    Serial.println("Alarm ratios out of range");
+  }
 
-  // Step 6: Set low Threshold
-  mySensor.setTrl(lowThreshold);
+  // Step 6: Print the trip points actually programmed
+  float trip, release;
+  mySensor.getAlarmRatio(&trip, &release);
+  Serial.print("Alarm trips at ");
+  Serial.print(trip, 4);
+  Serial.print(", releases at ");
+  Serial.println(release, 4);
 
   // Step 7: Start Continuous conversion
   mySensor.setConvMode(MC11S_CONT_CONV);
@@ -94,41 +102,37 @@ void getCapacitance(float *Cref, float* Csensor) {
   uint16_t data_ch0, data_ch1;
 
   mySensor.getCh0Data(&data_ch0);
-  // Serial.println("Ch0 Data: " + String(data_ch0));
+  // Serial.print("Ch0 Data: "); Serial.println(data_ch0);
 
   mySensor.getCh1Data(&data_ch1);
-  // Serial.println("Ch1 Data: " + String(data_ch1));
+  // Serial.print("Ch1 Data: "); Serial.println(data_ch1);
   // delay(200);
 
   // Step 2b: get Fin_div
   mc11s_fin_div_val_t Fin_div_val;
   mySensor.getFinDiv(&Fin_div_val);
 
-  // Serial.println("Fin Div: " + String(Fin_div_val));
+  // Serial.print("Fin Div: "); Serial.println(Fin_div_val);
   // delay(200);
 
   if (Fin_div_val > MC11S_FIN_DIV_256)
       Fin_div_val = MC11S_FIN_DIV_256;
 
-  //Fin_div = 2 ^ Fin_div_val;
-
   // Step 2c: get Fclk
-  uint32_t Fclk = 2400000;    // 2.4 MHz CLK based on datasheet
+  uint32_t Fclk = mySensor.getRefClock();    // Selected reference, calibrated
 
   // Step 2d: get Fref_div
-  uint16_t Fref_div;
+  uint8_t Fref_div;
 
-  mySensor.getFrefDiv((uint8_t*) &Fref_div);
-  // Serial.println("Fref: " + String(Fref_div + 1));
+  mySensor.getFrefDiv(&Fref_div);
+  // Serial.print("Fref: "); Serial.println(Fref_div + 1);
   // delay(200);
 
-  //Fref_div = Fref_div + 1;    // Fref value from 1 to 256
-
   // Step 2e: get RCNT
   uint16_t rcnt;
 
   mySensor.getRcnt(&rcnt);
-  // Serial.println("RCNT: " + String(rcnt));
+  // Serial.print("RCNT: "); Serial.println(rcnt);
   // delay(200);
 
   // Step 2f: get Idrv
@@ -169,15 +173,16 @@ void getCapacitance(float *Cref, float* Csensor) {
           break;
   }
 
-  // Serial.println("Idrv: " + String(Idrv));
+  // Serial.print("Idrv: "); Serial.println(Idrv);
   // delay(200);
 
   // Step 3: Calculate Cref
-  // C = k * Idrv /(data_chx * Fin_div * (Fclk /(Fref_div + 1))/ RCNT)
-  *Cref = (float) (K * Idrv / (data_ch1 * (2 ^ Fin_div_val) * (Fclk / (Fref_div + 1)) / rcnt));
+  // Fsensor = data_chx * Fin_div * (Fclk / (Fref_div + 1)) / RCNT
+  // C = K * Idrv / Fsensor, with Idrv in uA and Fsensor in MHz -> pF
+  *Cref = (float) (K * Idrv * 1e6 / ((float) data_ch1 * (1UL << Fin_div_val) * ((float) Fclk / (Fref_div + 1)) / rcnt));
 
   // Step 4: Calculate Csensor
-  *Csensor = (float) (K * Idrv / (data_ch0 * (2 ^ Fin_div_val) * (Fclk / (Fref_div + 1)) / rcnt));
+  *Csensor = (float) (K * Idrv * 1e6 / ((float) data_ch0 * (1UL << Fin_div_val) * ((float) Fclk / (Fref_div + 1)) / rcnt));
 
 
   // Step 5: start new conversion cycle
@@ -225,8 +230,12 @@ void loop()
     {
       getCapacitance(&Cref, &Csensor);
 
-      Serial.println("Cref: " + String(Cref) + "pF");
-      Serial.println("Csensor: " + String(Csensor) + "pF");
+      Serial.print("Cref: ");
+      Serial.print(Cref);
+      Serial.println(" pF");
+      Serial.print("Csensor: ");
+      Serial.print(Csensor);
+      Serial.println(" pF");
     }
     attachInterrupt(digitalPinToInterrupt(intPin), isr1, CHANGE);
   }
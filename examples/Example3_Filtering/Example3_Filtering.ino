@@ -0,0 +1,102 @@
+/******************************************************************************
+  Example3_Filtering.ino
+  
+  Read both channels of the MC11S in one burst, smooth them with a chain of
+  streaming filters (Hampel outlier rejection to knock out splash spikes, then
+  a moving average) and compute capacitance from the filtered counts. The time
+  spent in the filter per sample and the number of rejected samples are
+  printed as well.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Arduino_Library.h"
+#include "MC11S_Filters.h"
+#include <Wire.h>
+
+MC11S_I2C mySensor;
+
+// 7 sample Hampel rejector followed by an 8 sample moving average, on both channels
+MC11S_DualFilter<MC11S_Pipeline<MC11S_Hampel<uint16_t, 7>,
+                                MC11S_MovingAverage<uint16_t, 8> > > filter;
+
+void setup()
+{
+    Serial.begin(115200);
+    Serial.println("MC11S Example 3: Filtering");
+
+    // Establish communication with device 
+    if (mySensor.begin() == false) {
+      Serial.println("Error setting up device - please check wiring.");
+      while(1);
+    }
+
+    // Don't treat a couple of counts of noise on a flat signal as spikes
+    filter.ch0().stage().setMinDeviation(4);
+    filter.ch1().stage().setMinDeviation(4);
+
+    mySensor.setConvTime(MC11S_CONV_0S25);
+    mySensor.setConvMode(MC11S_CONT_CONV);
+}
+
+void loop()
+{
+  mc11s_drdy_ch0_status_t ch0DataReady;
+  mc11s_drdy_ch1_status_t ch1DataReady;
+
+  mySensor.getCh0DataReady(&ch0DataReady);
+  mySensor.getCh1DataReady(&ch1DataReady);
+
+  if (ch0DataReady.drdy_ch0 && ch1DataReady.drdy_ch1) {
+    uint16_t raw0, raw1, ch0, ch1;
+    float Csensor, Cref;
+
+    // Both channels in a single I2C transaction
+    mySensor.getData(&raw0, &raw1);
+
+    unsigned long start = micros();
+    bool ready = filter.push(raw0, raw1, &ch0, &ch1);
+    unsigned long elapsed = micros() - start;
+
+    if (ready) {
+      mySensor.calcCapacitance(ch0, ch1, &Csensor, &Cref);
+
+      Serial.print("Ch0: ");
+      Serial.print(raw0);
+      Serial.print(" -> ");
+      Serial.print(ch0);
+      Serial.print("  Ch1: ");
+      Serial.print(raw1);
+      Serial.print(" -> ");
+      Serial.print(ch1);
+      Serial.print("  Csensor: ");
+      Serial.print(Csensor);
+      Serial.print(" pF  filter: ");
+      Serial.print(elapsed);
+      Serial.print(" us  rejected: ");
+      Serial.println(filter.ch0().stage().getRejected() + filter.ch1().stage().getRejected());
+    }
+  }
+}
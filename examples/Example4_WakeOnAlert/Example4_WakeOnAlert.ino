@@ -0,0 +1,230 @@
+/******************************************************************************
+  Example4_WakeOnAlert.ino
+
+  Battery operation: the MC11S converts once a minute and compares each
+  result with TRH/TRL itself, the Arduino sleeps in power-down until INTB
+  pulls D2 low. On wake-up STATUS and both channels are read and printed,
+  then the Arduino goes back to sleep. While the alarm stays active the
+  library switches INTB to pulse once per conversion, so the Arduino still
+  sleeps between conversions and wakes once more when the alarm clears.
+
+  At start-up the energy model prints the estimated average current of this
+  mode next to polling every conversion.
+
+  Uncomment SIMULATED to check the mode against the simulated sensor
+  instead: ten hours of conversions with two alarms. Every conversion in
+  alarm and the one that clears it must wake the Arduino, no other may,
+  and each wake-up must take only the reads (plus the INTB mode write when
+  the alarm sets or clears). The sketch prints PASS or FAIL.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  INT (D2) --> INTB
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_LowPower.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+MC11S_I2C mySensor;
+#endif
+
+MC11S_WakeOnAlert lowPower;
+
+#ifndef SIMULATED
+int intPin = 2;
+
+bool volatile wakeFlag = false;
+
+void wake()
+{
+  wakeFlag = true;
+  // INTB is a level, detach or the interrupt keeps firing
+  detachInterrupt(digitalPinToInterrupt(intPin));
+}
+#endif
+
+void printCharge(const char *mode, MC11S_EnergyModel &model) {
+  mc11s_charge_t charge;
+
+  model.estimate(&charge);
+  Serial.print(mode);
+  Serial.print(": ");
+  Serial.print(charge.total, 2);
+  Serial.print(" uA (sensor ");
+  Serial.print(charge.convert + charge.drive + charge.standby, 2);
+  Serial.print(", bus ");
+  Serial.print(charge.bus, 3);
+  Serial.print(", MCU ");
+  Serial.print(charge.mcu, 2);
+  Serial.println(")");
+}
+
+#ifdef SIMULATED
+#define CONVERSIONS     600     // Ten hours, one a minute
+
+// Csensor for conversion n: normal at 100 pF, two alarms at 85 pF
+float level(uint16_t n)
+{
+  return ((n >= 200 && n < 230) || (n >= 400 && n < 405)) ? 85 : 100;
+}
+
+bool simulate()
+{
+  mc11s_wake_sample_t sample;
+  mc11s_status_t status;
+  uint32_t before, reads;
+  uint16_t n, alarms = 0, wakes = 0, wrongWakes = 0, wrongReads = 0;
+  bool wasAlert = false;
+
+  for (n = 0; n < CONVERSIONS; n++) {
+    mySensor.setCapacitance(level(n), 100);
+    mySensor.convert();
+
+    uint8_t raw = mySensor.peekReg(MC11S_STATUS);
+    memcpy(&status, &raw, 1);
+    bool alert = status.alert;
+    bool expectWake = alert || wasAlert;      // Every alarm conversion and the one that clears it
+
+    alarms += alert;
+    if (mySensor.getIntb() != expectWake)
+      wrongWakes++;
+
+    if (mySensor.getIntb()) {
+      before = mySensor.getTransferCount();
+      lowPower.service(&sample);
+      wakes++;
+
+      // The reads, and a read-modify-write of CFG when the alarm sets or clears
+      reads = mySensor.getTransferCount() - before;
+      if (reads != MC11S_WAKE_READS + ((alert != wasAlert) ? 2 : 0))
+        wrongReads++;
+      if (mySensor.getIntb())                 // Must be released again before sleeping
+        wrongWakes++;
+    }
+    wasAlert = alert;
+  }
+
+  Serial.print(CONVERSIONS);
+  Serial.print(" conversions, ");
+  Serial.print(alarms);
+  Serial.print(" in alarm, ");
+  Serial.print(wakes);
+  Serial.print(" wake-ups; wrong wake-ups ");
+  Serial.print(wrongWakes);
+  Serial.print(", wake-ups with extra bus traffic ");
+  Serial.println(wrongReads);
+
+  return wrongWakes == 0 && wrongReads == 0 && alarms > 0 && !lowPower.inAlarm();
+}
+#else
+void sleepUntilIntb() {
+  Serial.flush();
+
+#if defined(__AVR__)
+  // Only a LOW level on INT0 wakes the AVR from power-down
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  noInterrupts();
+  attachInterrupt(digitalPinToInterrupt(intPin), wake, LOW);
+  sleep_enable();
+  interrupts();
+  sleep_cpu();
+  sleep_disable();
+#else
+  attachInterrupt(digitalPinToInterrupt(intPin), wake, LOW);
+  while (!wakeFlag);
+#endif
+}
+#endif
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 4: Wake on alert");
+
+#ifdef SIMULATED
+  mySensor.begin();
+  mySensor.setCapacitance(100, 100);
+  mySensor.autoRange();
+#else
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  pinMode(intPin, INPUT_PULLUP);
+#endif
+
+  // Alarm when Csensor / Cref drops to 0.875, release above 0.91
+  mySensor.setAlarmRatio(0.875, 0.91);
+
+  lowPower.begin(&mySensor, MC11S_CONV_60S);
+
+  // Compare with reading STATUS and both channels every conversion
+  MC11S_EnergyModel model;
+
+  model.readConversion(&mySensor);
+  model.setWakeups(60, MC11S_WAKE_READS, MC11S_WAKE_READ_BYTES);
+  printCharge("Polling", model);
+
+  // A few alarms a day
+  model.setWakeups(0.2, MC11S_WAKE_READS, MC11S_WAKE_READ_BYTES);
+  printCharge("Wake on alert", model);
+
+#ifdef SIMULATED
+  Serial.println(simulate() ? "PASS" : "FAIL");
+#endif
+}
+
+void loop()
+{
+#ifndef SIMULATED
+  mc11s_wake_sample_t sample;
+
+  // INTB is low on an alarm, and once per conversion while the alarm holds
+  sleepUntilIntb();
+
+  wakeFlag = false;
+  lowPower.service(&sample);
+
+  Serial.print("Wake ");
+  Serial.print(lowPower.getWakeCount());
+  Serial.print(lowPower.inAlarm() ? ": ALERT" : ": clear");
+  Serial.print(" ch0 ");
+  Serial.print(sample.ch0);
+  Serial.print(" ch1 ");
+  Serial.println(sample.ch1);
+#endif
+}
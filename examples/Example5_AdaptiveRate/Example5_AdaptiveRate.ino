@@ -0,0 +1,168 @@
+/******************************************************************************
+  Example5_AdaptiveRate.ino
+
+  Benchmark of the adaptive conversion-rate scheduler. Runs on the simulated
+  MC11S, so no sensor is needed: two hours of a tank that sits still, fills
+  quickly, sits still again and then leaks slowly are played through the
+  simulator three times, at a fixed 4 Hz, at a fixed 60 s and with the
+  scheduler choosing the period. For each run it prints the estimated average
+  current and how late each event was seen.
+
+  An event counts as seen at the first conversion that is DETECT_COUNTS away
+  from the resting level. Latency is measured from the start of the event, so
+  even a perfect sampler needs DETECT_COUNTS / rate seconds (2 s for the fill,
+  160 s for the leak).
+
+  The leak is too slow for the rate and spread terms. Without the drift
+  term the scheduler sits at 60 s through it and sees it no sooner than the
+  fixed 60 s run; with it the period drops to 5 s a minute or two into the
+  leak.
+
+  On real hardware the scheduler is fed from the data ready loop:
+
+    mySensor.getData(&ch0, &ch1);
+    scheduler.service(&mySensor, ch0, millis());
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  None, the MC11S is simulated.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Sim.h"
+#include "MC11S_Scheduler.h"
+#include "MC11S_LowPower.h"
+
+#define RUN_SECONDS     7200UL
+#define REST_COUNTS     4000.0
+#define DETECT_COUNTS   8.0
+
+// Fill: +4 counts/s for 60 s from 30 min. Leak: -0.05 counts/s for 30 min from 75 min
+#define FILL_START      1800.0
+#define FILL_RATE       4.0
+#define FILL_SECONDS    60.0
+#define LEAK_START      4500.0
+#define LEAK_RATE       -0.05
+#define LEAK_SECONDS    1800.0
+
+MC11S_Sim sim;
+MC11S_RateScheduler scheduler;
+MC11S_EnergyModel model;
+
+uint32_t noiseState = 1;
+
+// Roughly +/-2 counts of noise, repeatable from run to run
+float noise() {
+  noiseState ^= noiseState << 13;
+  noiseState ^= noiseState >> 17;
+  noiseState ^= noiseState << 5;
+  return ((int32_t)(noiseState % 401) - 200) / 100.0;
+}
+
+float trueLevel(float t) {
+  float level = REST_COUNTS;
+
+  if (t > FILL_START)
+    level += FILL_RATE * (t < FILL_START + FILL_SECONDS ? t - FILL_START : FILL_SECONDS);
+  if (t > LEAK_START)
+    level += LEAK_RATE * (t < LEAK_START + LEAK_SECONDS ? t - LEAK_START : LEAK_SECONDS);
+
+  return level;
+}
+
+void run(const char *name, bool adaptive, mc11s_conv_time_status_t fixed) {
+  float t = 0, rest = REST_COUNTS;
+  float fillSeen = -1, leakSeen = -1;
+  uint32_t conversions = 0, periodMs;
+  float charge;
+
+  noiseState = 1;
+  sim.begin();
+  sim.setConvTime(fixed);
+  scheduler.reset(fixed);
+  model.readConversion(&sim);
+  sim.clearTransferCount();
+
+  while (t < RUN_SECONDS) {
+    uint16_t ch0, ch1;
+    mc11s_conv_time_status_t cr;
+
+    sim.latchConversion((uint16_t)(trueLevel(t) + noise() + 0.5), 4096);
+    sim.getData(&ch0, &ch1);
+    conversions++;
+
+    if (adaptive)
+      scheduler.service(&sim, ch0, (uint32_t)(t * 1000));
+
+    // The level after the fill is the new resting level for the leak
+    if (fillSeen < 0 && t >= FILL_START && ch0 - rest >= DETECT_COUNTS) {
+      fillSeen = t;
+      rest = REST_COUNTS + FILL_RATE * FILL_SECONDS;
+    }
+    if (leakSeen < 0 && t >= LEAK_START && rest - ch0 >= DETECT_COUNTS)
+      leakSeen = t;
+
+    sim.getConvTime(&cr);
+    mc11s_conv_time_ms_get(cr, &periodMs);
+    t += periodMs / 1000.0;
+  }
+
+  // One data read per conversion, the rest of the transactions reconfigured CR
+  model.setWakeups(0, 1, 4);
+  charge = conversions * (model.getConversionCharge() + model.getWakeCharge()) +
+           (sim.getTransferCount() - conversions) * model.getTransactionCharge(1);
+
+  model.setConversion(fixed, MC11S_DRIVE_I_200uA, 0, 0, 0, 0);
+  model.setWakeups(0, 0, 0, 0);
+  mc11s_charge_t idle;
+  model.estimate(&idle);
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(conversions);
+  Serial.print(" conversions, ");
+  Serial.print(idle.total + charge / RUN_SECONDS, 2);
+  Serial.print(" uA, fill seen after ");
+  Serial.print(fillSeen < 0 ? -1 : fillSeen - FILL_START, 2);
+  Serial.print(" s, leak seen after ");
+  Serial.print(leakSeen < 0 ? -1 : leakSeen - LEAK_START, 2);
+  Serial.println(" s");
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 5: Adaptive conversion rate");
+
+  // Active above 0.5 counts/s or 6 counts of spread, quiet below 0.1 counts/s and 3 counts;
+  // a drift above 0.01 counts/s over 5 minutes holds 5 s conversions
+  scheduler.setRange(MC11S_CONV_60S, MC11S_CONV_0S25);
+  scheduler.setRateThresholds(0.5, 0.1);
+  scheduler.setSpreadThresholds(6, 3);
+  scheduler.setQuietTime(30000);
+  scheduler.setMinInterval(5000);
+  scheduler.setDriftThreshold(0.01);
+
+  run("Fixed 4 Hz", false, MC11S_CONV_0S25);
+  run("Fixed 60 s", false, MC11S_CONV_60S);
+  run("Adaptive  ", true, MC11S_CONV_0S25);
+}
+
+void loop()
+{
+}
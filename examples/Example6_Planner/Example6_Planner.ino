@@ -0,0 +1,118 @@
+/******************************************************************************
+  Example6_Planner.ino
+
+  Plans the MC11S settings for a probe instead of tuning them by hand. The
+  probe here reads 80 pF empty to 160 pF full, must resolve 20000 counts,
+  settles in 32 counts and is sampled once a second.
+
+  The fixed profile is checked when the sketch compiles (a static_assert
+  fails the build if it can't deliver), the five cheapest plans are printed
+  at start-up and the best one is written to the sensor.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Arduino_Library.h"
+#include "MC11S_Planner.h"
+#include <Wire.h>
+
+MC11S_I2C mySensor;
+
+// period (s), counts, C min (pF), C max (pF), SCNT, channels, Fclk, core current (uA)
+constexpr mc11s_plan_req_t probe = { 1.0f, 20000, 80, 160, 0x20, 2, MC11S_INT_CLK_HZ, 100 };
+
+// The settings this board shipped with, checked at compile time
+constexpr mc11s_plan_t shipped = mc11s_plan_for(probe, MC11S_DRIVE_I_3mA2_1, MC11S_FIN_DIV_4, 0);
+static_assert(mc11s_plan_valid(probe, shipped), "shipped settings can't resolve 20000 counts");
+
+// And the best settings there are, also found at compile time
+constexpr mc11s_plan_t best = mc11s_plan_best(probe);
+static_assert(best.rcnt != 0, "no settings meet the probe requirements");
+
+void printPlan(const mc11s_plan_t &plan) {
+  uint16_t Idrv;
+
+  mc11s_drive_i_ua_get(plan.drive, &Idrv);
+  Serial.print("Idrv ");
+  Serial.print(Idrv);
+  Serial.print(" uA, FIN_DIV ");
+  Serial.print(1UL << plan.fin_div);
+  Serial.print(", FREF_DIV ");
+  Serial.print(plan.fref_div);
+  Serial.print(", RCNT ");
+  Serial.print(plan.rcnt);
+  Serial.print(": ");
+  Serial.print(plan.conv_time * 1000, 2);
+  Serial.print(" ms, ");
+  Serial.print(plan.counts_min, 0);
+  Serial.print("..");
+  Serial.print(plan.counts_max, 0);
+  Serial.print(" counts, ");
+  Serial.print(plan.current, 2);
+  Serial.println(" uA");
+}
+
+void setup()
+{
+  mc11s_plan_t plans[5];
+  uint8_t n;
+
+  Serial.begin(115200);
+  Serial.println("MC11S Example 6: Planner");
+
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  n = mc11s_plan_rank(probe, plans, 5);
+  for (uint8_t i = 0; i < n; i++)
+    printPlan(plans[i]);
+
+  Serial.print("Shipped: ");
+  printPlan(shipped);
+
+  mySensor.setConvMode(MC11S_STOP_CONV);
+  mySensor.setDriveCurrent(best.drive);
+  mySensor.setFinDiv(best.fin_div);
+  mySensor.setFrefDiv(best.fref_div);
+  mySensor.setScnt(best.scnt);
+  mySensor.setRcnt(best.rcnt);
+  mySensor.setConvTime(MC11S_CONV_1S);
+  mySensor.setConvMode(MC11S_CONT_CONV);
+}
+
+void loop()
+{
+  uint16_t ch0, ch1;
+
+  mySensor.getData(&ch0, &ch1);
+  Serial.print(ch0);
+  Serial.print(" ");
+  Serial.println(ch1);
+  delay(1000);
+}
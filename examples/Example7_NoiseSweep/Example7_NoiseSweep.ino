@@ -0,0 +1,120 @@
+/******************************************************************************
+  Example7_NoiseSweep.ino
+
+  Characterises the noise of a probe. With the probe held at a steady level
+  the sketch steps through RCNT, FIN_DIV, drive current and the glitch filter,
+  takes 64 conversions at each point and prints a CSV table of the mean,
+  standard deviation, peak-to-peak and effective bits of both channels with
+  the conversion time. Paste it into a spreadsheet, or switch FORMAT to
+  MC11S_SWEEP_BINARY and capture the raw serial stream.
+
+  The last line is the setting with the most effective bits that converts
+  both channels within 20 ms: use it as the default for this type of probe.
+
+  Uncomment SIMULATED to run the sweep against the simulated MC11S and its
+  noise model instead (no sensor needed).
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SIMULATED
+
+#include "MC11S_Noise.h"
+
+#ifdef SIMULATED
+#include "MC11S_Sim.h"
+MC11S_Sim mySensor;
+#else
+#include "MC11S_Arduino_Library.h"
+#include <Wire.h>
+MC11S_I2C mySensor;
+#endif
+
+#define FORMAT          MC11S_SWEEP_CSV
+#define SAMPLES         64
+#define MAX_CONV_US     20000
+
+const uint16_t rcntValues[] = { 0x0100, 0x0400, 0x1000, 0x4000 };
+const mc11s_fin_div_val_t finDivValues[] = { MC11S_FIN_DIV_2, MC11S_FIN_DIV_8, MC11S_FIN_DIV_32 };
+const mc11s_drive_i_status_t driveValues[] = { MC11S_DRIVE_I_200uA, MC11S_DRIVE_I_800uA, MC11S_DRIVE_I_3mA2_1 };
+
+MC11S_NoiseSweep sweep;
+
+void setup()
+{
+  mc11s_noise_point_t best;
+  uint16_t Idrv;
+
+  Serial.begin(115200);
+  Serial.println("MC11S Example 7: Noise sweep");
+
+#ifdef SIMULATED
+  // 100 pF and 120 pF, 300 ppm of jitter, a 2% glitch in 2% of the conversions
+  mySensor.setCapacitance(100, 120);
+  mySensor.setNoise(300, 0.02);
+#else
+  Wire.begin();
+#endif
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  sweep.setRcnt(rcntValues, sizeof(rcntValues) / sizeof(rcntValues[0]));
+  sweep.setFinDiv(finDivValues, sizeof(finDivValues) / sizeof(finDivValues[0]));
+  sweep.setDrive(driveValues, sizeof(driveValues) / sizeof(driveValues[0]));
+  sweep.setGlitchSweep(true);
+  sweep.setSamples(SAMPLES);
+  sweep.setFormat(FORMAT);
+  sweep.setMaxConvTime(MAX_CONV_US);
+
+  if (sweep.run(&mySensor, Serial) != 0) {
+    Serial.println("Sweep failed");
+    return;
+  }
+
+  if (FORMAT == MC11S_SWEEP_BINARY || !sweep.getBest(&best))
+    return;
+
+  mc11s_drive_i_ua_get(best.drive, &Idrv);
+  Serial.print("Best: RCNT ");
+  Serial.print(best.rcnt);
+  Serial.print(", FIN_DIV ");
+  Serial.print(1UL << best.fin_div);
+  Serial.print(", Idrv ");
+  Serial.print(Idrv);
+  Serial.print(" uA, glitch filter ");
+  Serial.print(best.glitch ? "on" : "off");
+  Serial.print(": ");
+  Serial.print(best.enob[0] < best.enob[1] ? best.enob[0] : best.enob[1], 2);
+  Serial.print(" bits in ");
+  Serial.print(best.conv_us);
+  Serial.println(" us");
+}
+
+void loop()
+{
+}
@@ -0,0 +1,136 @@
+/******************************************************************************
+  Example8_Calibration.ino
+
+  Calibrates a tank probe on site and keeps the curve in EEPROM, so the sketch
+  no longer carries any conversion constants. Boards without the AVR EEPROM
+  library (ESP32, SAMD, RP2040) can't save it and ask for the points at every
+  start.
+
+  At start-up a stored curve is loaded. If there is none (or it is corrupt)
+  the sketch asks for reference points: fill the tank to a known level, type
+  the level in mm into the Serial Monitor and press enter; the ratio is
+  measured and recorded. Type 'f' after three or more points to fit a
+  quadratic (or 'p' for straight lines through the points). The curve is
+  saved and the sketch starts printing levels, worked out from the raw counts
+  in fixed point. Type 'c' at any time to calibrate again.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "MC11S_Arduino_Library.h"
+#include "MC11S_Calibration.h"
+#include <Wire.h>
+
+#define CAL_ADDRESS     0
+
+MC11S_I2C mySensor;
+MC11S_Calibration cal;
+bool calibrating = false;
+
+void startCalibration() {
+  calibrating = true;
+  cal.clearPoints();
+  cal.setInput(MC11S_CAL_RATIO);
+  Serial.println("Type a level in mm and press enter for each point, 'f' to fit a quadratic, 'p' for lines");
+}
+
+void finishCalibration(bool quadratic) {
+  float rms = 0;
+  int32_t ret = quadratic ? cal.fitPolynomial(2, &rms) : cal.fitPiecewise();
+
+  if (ret != 0) {
+    Serial.println("Fit failed, add more (distinct) points");
+    return;
+  }
+
+  if (quadratic) {
+    Serial.print("Residual ");
+    Serial.print(rms, 2);
+    Serial.println(" mm");
+  }
+
+  Serial.println(cal.save(CAL_ADDRESS) == 0 ? "Saved" : "Not saved, curve used until reset");
+  calibrating = false;
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 8: Calibration");
+
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  if (cal.load(CAL_ADDRESS) == 0)
+    Serial.println("Calibration loaded, type 'c' to redo it");
+  else
+    startCalibration();
+}
+
+void loop()
+{
+  uint16_t ch0, ch1;
+  mc11s_status_t status;
+
+  if (Serial.available()) {
+    int c = Serial.peek();
+
+    if (c == 'c' || c == 'f' || c == 'p') {
+      Serial.read();
+      if (c == 'c')
+        startCalibration();
+      else if (calibrating)
+        finishCalibration(c == 'f');
+    } else if (calibrating) {
+      float level = Serial.parseFloat();
+
+      if (cal.addPoint(&mySensor, level) == 0) {
+        Serial.print("Point ");
+        Serial.print(cal.getPointCount());
+        Serial.print(" at ");
+        Serial.print(level, 1);
+        Serial.println(" mm");
+      } else {
+        Serial.println("Point not taken");
+      }
+    } else {
+      Serial.read();
+    }
+  }
+
+  if (calibrating || !cal.isValid())
+    return;
+
+  if (mySensor.singleConversion(&ch0, &ch1, &status) == 0) {
+    // Q16.16 mm, rounded to whole mm
+    Serial.print((cal.evaluateCounts(ch0, ch1) + 0x8000L) >> 16);
+    Serial.println(" mm");
+  }
+  delay(1000);
+}
@@ -0,0 +1,153 @@
+/******************************************************************************
+  Example9_TankVolume.ino
+
+  Turns the calibrated level into the volume in the tank. The tank here is a
+  horizontal cylinder, 1200 mm across and 3000 mm long, so the same 10 mm of
+  level is worth far less near the bottom than at the middle.
+
+  At start-up the sketch builds the level -> volume table, reports how far
+  the interpolated table is from the exact formula, and times both per sample
+  on the board. extras/bench/mc11s_geometry_bench does the same on a host.
+  Then it prints the volume for every conversion, using the calibration
+  stored by Example 8.
+
+  Uncomment SUMP to use a compiled-in table instead, e.g. for an irregular
+  sump strapped by filling it in known amounts.
+
+  MIS Electronics MC11S Arduino Library
+  Lovelesh Patel @ MIS Electronics
+  https://github.com/lovelesh-mis/MC11S
+
+  Development environment specifics:
+
+  IDE: Arduino 1.8.19
+
+  Hardware Connections:
+
+  ARDUINO --> MC11S
+  SDA (A4) --> SDA
+  SCL (A5) --> SCL
+  3.3V --> 3.3V
+  GND --> GND
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// #define SUMP
+
+#include "MC11S_Arduino_Library.h"
+#include "MC11S_Calibration.h"
+#include "MC11S_Geometry.h"
+#include <Wire.h>
+
+#define CAL_ADDRESS     0
+#define DIAMETER        1200.0f   // mm
+#define LENGTH          3000.0f   // mm
+#define SAMPLES         1000
+
+#ifdef SUMP
+// ml at 0, 50, 100 ... 400 mm
+const uint32_t sump[] = { 0, 1800, 4900, 9300, 15200, 22400, 30100, 38000, 46000 };
+#endif
+
+MC11S_I2C mySensor;
+MC11S_Calibration cal;
+MC11S_TankGeometry tank;
+volatile uint32_t sink;
+
+// Exact volume of the horizontal cylinder, ml
+float exactVolume(float h) {
+  float r = DIAMETER / 2;
+
+  return LENGTH / 1000 * (r * r * acos((r - h) / r) - (r - h) * sqrt(2 * r * h - h * h));
+}
+
+void benchmark() {
+  unsigned long start, intUs, floatUs, exactUs;
+  float maxError = 0;
+  uint16_t i;
+
+  for (i = 0; i <= SAMPLES; i++) {
+    float h = DIAMETER * i / SAMPLES;
+    float error = fabs(tank.volume(h) - exactVolume(h)) / tank.getCapacity() * 100;
+
+    if (error > maxError)
+      maxError = error;
+  }
+  Serial.print("Largest table error ");
+  Serial.print(maxError, 3);
+  Serial.println(" % of capacity");
+
+  start = micros();
+  for (i = 0; i < SAMPLES; i++)
+    sink = tank.volumeQ16((int32_t)i * (int32_t)(DIAMETER * 65536 / SAMPLES));
+  intUs = micros() - start;
+
+  start = micros();
+  for (i = 0; i < SAMPLES; i++)
+    sink = tank.volume(DIAMETER * i / SAMPLES);
+  floatUs = micros() - start;
+
+  start = micros();
+  for (i = 0; i < SAMPLES; i++)
+    sink = exactVolume(DIAMETER * i / SAMPLES);
+  exactUs = micros() - start;
+
+  Serial.print("ns per sample: table (integer) ");
+  Serial.print(intUs * 1000.0 / SAMPLES, 1);
+  Serial.print(", table (float) ");
+  Serial.print(floatUs * 1000.0 / SAMPLES, 1);
+  Serial.print(", formula ");
+  Serial.println(exactUs * 1000.0 / SAMPLES, 1);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println("MC11S Example 9: Tank volume");
+
+#ifdef SUMP
+  tank.setTable(sump, sizeof(sump) / sizeof(sump[0]), 400);
+#else
+  tank.horizontalCylinder(DIAMETER, LENGTH);
+  benchmark();
+#endif
+
+  Serial.print("Capacity ");
+  Serial.print(tank.getCapacity() / 1000.0, 1);
+  Serial.println(" l");
+
+  Wire.begin();
+
+  if (mySensor.begin() == false) {
+    Serial.println("Error setting up device - please check wiring.");
+    while(1);
+  }
+
+  if (cal.load(CAL_ADDRESS) != 0) {
+    Serial.println("No calibration stored, run Example 8 first");
+    while(1);
+  }
+}
+
+void loop()
+{
+  uint16_t ch0, ch1;
+  mc11s_status_t status;
+
+  if (mySensor.singleConversion(&ch0, &ch1, &status) == 0) {
+    int32_t level = cal.evaluateCounts(ch0, ch1);
+
+    Serial.print((level + 0x8000L) >> 16);
+    Serial.print(" mm, ");
+    Serial.print(tank.volumeQ16(level) / 1000.0, 1);
+    Serial.println(" l");
+  }
+  delay(1000);
+}
@@ -0,0 +1,60 @@
+/******************************************************************************
+Timing helpers of the host benchmarks: a nanosecond clock and, on x86, the
+time stamp counter. The TSC ticks at a fixed rate (the nominal clock of
+the CPU), not at the current core clock, so its "cycles" are only a
+cycles figure while the core runs at nominal speed; the nanoseconds are
+the figure to compare across hosts.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#ifndef __MC11S_Bench_H__
+#define __MC11S_Bench_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MC11S_BENCH_HAS_TSC     1
+#else
+#define MC11S_BENCH_HAS_TSC     0
+#endif
+
+static inline uint64_t mc11s_bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline uint64_t mc11s_bench_ticks(void)
+{
+#if MC11S_BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Time and ticks of one run of a benchmark
+typedef struct {
+    uint64_t ns;
+    uint64_t ticks;
+} mc11s_bench_t;
+
+static inline void mc11s_bench_start(mc11s_bench_t *b)
+{
+    b->ticks = mc11s_bench_ticks();
+    b->ns = mc11s_bench_ns();
+}
+
+static inline void mc11s_bench_stop(mc11s_bench_t *b)
+{
+    b->ns = mc11s_bench_ns() - b->ns;
+    b->ticks = mc11s_bench_ticks() - b->ticks;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/******************************************************************************
+mc11s_filter_bench: the host side of Example 19. Every stage of
+MC11S_Filters.h filters the same synthetic counts on one channel (a slow
+level change with noise and a splash spike every 200 samples), passes
+times over, and the time and TSC ticks per sample (the fastest of five
+runs) and the RAM of each stage are printed. The cost of a pass-through
+stage (the loop and the sample generator) is taken off, so the figures
+are the stage alone.
+
+    ./mc11s_filter_bench [-n samples] [-p passes]
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "MC11S_Filters.h"
+#include "mc11s_bench.h"
+
+#define RUNS        5       // Of each stage; the fastest counts, the others were disturbed
+
+static volatile uint16_t sink;  // Keeps the outputs from being optimised away
+static uint32_t rng;
+static uint16_t samples = 2000;
+static uint16_t passes = 1000;
+static double baseNs, baseTicks;
+
+// Counts around 40000: a slow ramp, +/-32 counts of noise, a spike every 200 samples
+static uint16_t nextSample(uint16_t i)
+{
+    rng = rng * 1664525UL + 1013904223UL;
+    uint16_t v = 40000 + i / 4 + (uint16_t)(rng >> 26);
+    return (i % 200 == 199) ? v + 3000 : v;
+}
+
+// Time and ticks per sample of stage over the synthetic stream, the fastest of RUNS
+template <class Stage>
+static void timeStage(Stage &stage, double *ns, double *ticks)
+{
+    mc11s_bench_t b, best = { UINT64_MAX, UINT64_MAX };
+    uint16_t i, out, pass;
+    uint8_t run;
+
+    for (run = 0; run < RUNS; run++) {
+        mc11s_bench_start(&b);
+        for (pass = 0; pass < passes; pass++) {
+            stage.reset();
+            rng = 1;
+            for (i = 0; i < samples; i++)
+                if (stage.push(nextSample(i), &out))
+                    sink = out;
+        }
+        mc11s_bench_stop(&b);
+
+        if (b.ns < best.ns)
+            best = b;
+    }
+
+    *ns = (double)best.ns / ((double)samples * passes);
+    *ticks = (double)best.ticks / ((double)samples * passes);
+}
+
+template <class Stage>
+static void bench(int n, const char *name)
+{
+    static Stage stage;
+    double ns, ticks;
+
+    timeStage(stage, &ns, &ticks);
+    ns -= baseNs;
+    ticks -= baseTicks;
+
+    printf("%d. %-36s %7.2f ns", n, name, ns > 0 ? ns : 0);
+    if (MC11S_BENCH_HAS_TSC)
+        printf(" %7.1f ticks", ticks > 0 ? ticks : 0);
+    printf(" %5u B RAM\n", (unsigned)sizeof(Stage));
+}
+
+int main(int argc, char **argv)
+{
+    static MC11S_NoFilter<uint16_t> pass;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:p:")) != -1) {
+        switch (opt) {
+            case 'n': samples = (uint16_t)strtoul(optarg, NULL, 0); break;
+            case 'p': passes = (uint16_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-p passes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (samples == 0 || passes == 0) {
+        fprintf(stderr, "samples and passes must be > 0\n");
+        return 2;
+    }
+
+    printf("%u samples x %u passes per stage, best of %d, one channel, per sample:\n", samples, passes, RUNS);
+
+    // The loop and the sample generator, taken off every stage below
+    timeStage(pass, &baseNs, &baseTicks);
+    printf("0. %-36s %7.2f ns", "pass-through (loop + generator)", baseNs);
+    if (MC11S_BENCH_HAS_TSC)
+        printf(" %7.1f ticks", baseTicks);
+    printf("\n");
+
+    bench<MC11S_MovingAverage<uint16_t, 8> >(1, "MovingAverage<uint16_t, 8>");
+    bench<MC11S_MovingAverage<uint16_t, 32> >(2, "MovingAverage<uint16_t, 32>");
+    bench<MC11S_ExpIIR<uint16_t, 3> >(3, "ExpIIR<uint16_t, 3>");
+    bench<MC11S_Median<uint16_t, 5> >(4, "Median<uint16_t, 5>");
+    bench<MC11S_Median<uint16_t, 9> >(5, "Median<uint16_t, 9>");
+    bench<MC11S_Hampel<uint16_t, 7> >(6, "Hampel<uint16_t, 7>");
+    bench<MC11S_CIC<uint16_t, 4, 2> >(7, "CIC<uint16_t, 4, 2> (per input)");
+    bench<MC11S_Pipeline<MC11S_Hampel<uint16_t, 7>, MC11S_MovingAverage<uint16_t, 8> > >(8, "Hampel 7 + MovingAverage 8");
+
+    return 0;
+}
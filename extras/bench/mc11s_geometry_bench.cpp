@@ -0,0 +1,97 @@
+/******************************************************************************
+mc11s_geometry_bench: the host side of Example 9. Builds the level -> volume
+table of the same horizontal cylinder (1200 mm across, 3000 mm long),
+reports how far the interpolated table is from the exact formula, and
+times a lookup through the table (integer and float) and through the
+formula, in ns and TSC ticks per sample.
+
+    ./mc11s_geometry_bench [-n samples] [-p points]
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "MC11S_Geometry.h"
+#include "mc11s_bench.h"
+
+#define DIAMETER    1200.0f     // mm
+#define LENGTH      3000.0f     // mm
+
+static volatile uint32_t sink;  // Keeps the results from being optimised away
+
+// Exact volume of the horizontal cylinder, ml
+static float exactVolume(float h)
+{
+    float r = DIAMETER / 2;
+
+    return LENGTH / 1000 * (r * r * acosf((r - h) / r) - (r - h) * sqrtf(2 * r * h - h * h));
+}
+
+static void report(const char *name, const mc11s_bench_t *b, uint32_t samples)
+{
+    printf("%-16s %8.2f ns", name, (double)b->ns / samples);
+    if (MC11S_BENCH_HAS_TSC)
+        printf(" %8.1f ticks", (double)b->ticks / samples);
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    MC11S_TankGeometry tank;
+    mc11s_bench_t b;
+    uint32_t samples = 1000000, i;
+    int points = MC11S_GEOM_MAX_POINTS;
+    float maxError = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:p:")) != -1) {
+        switch (opt) {
+            case 'n': samples = strtoul(optarg, NULL, 0); break;
+            case 'p': points = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-n samples] [-p points]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    if (samples == 0 || tank.horizontalCylinder(DIAMETER, LENGTH, (uint8_t)points) != 0) {
+        fprintf(stderr, "bad table or sample count\n");
+        return 1;
+    }
+
+    for (i = 0; i <= 1000; i++) {
+        float h = DIAMETER * i / 1000;
+        float error = fabsf(tank.volume(h) - exactVolume(h)) / tank.getCapacity() * 100;
+
+        if (error > maxError)
+            maxError = error;
+    }
+    printf("%d points, capacity %.1f l, largest table error %.3f %% of capacity\n",
+           points, tank.getCapacity() / 1000.0, maxError);
+    printf("%u samples, per sample:\n", samples);
+
+    mc11s_bench_start(&b);
+    for (i = 0; i < samples; i++)
+        sink = tank.volumeQ16((int32_t)((uint64_t)i * (uint32_t)(DIAMETER * 65536) / samples));
+    mc11s_bench_stop(&b);
+    report("table (integer)", &b, samples);
+
+    mc11s_bench_start(&b);
+    for (i = 0; i < samples; i++)
+        sink = tank.volume(DIAMETER * i / samples);
+    mc11s_bench_stop(&b);
+    report("table (float)", &b, samples);
+
+    mc11s_bench_start(&b);
+    for (i = 0; i < samples; i++)
+        sink = exactVolume(DIAMETER * i / samples);
+    mc11s_bench_stop(&b);
+    report("formula", &b, samples);
+
+    return 0;
+}
@@ -0,0 +1,313 @@
+/******************************************************************************
+mc11s_i2c_bench: counts the syscalls MC11S_LinuxI2C makes for the common
+driver operations, against a transport that uses separate write() and
+read() calls as most i2c-dev examples do, and checks that bursts longer
+than the adapter allows are split correctly.
+
+    LD_PRELOAD=./mc11s_i2c_preload.so ./mc11s_i2c_bench [-n repeats] [device]
+
+The device defaults to the simulated one of mc11s_i2c_preload.so. On a
+real /dev/i2c-N without the interposer only the library's own count of
+I2C_RDWR ioctls and the times are reported; the chunking checks need the
+interposer, which plays an adapter with a message limit.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+#include "MC11S_LinuxI2C.h"
+#include "mc11s_i2c_preload.h"
+
+// The register map the chunking checks read back in one burst
+#define MAP_LEN     0x20
+
+// The classic i2c-dev transport: write() the register address, then read()
+class MC11S_SplitI2C : public MC11S
+{
+    public:
+        MC11S_SplitI2C(void) : _fd{-1} {}
+        ~MC11S_SplitI2C(void) { end(); }
+
+        bool begin(const char *devPath, uint8_t devAddr = MC11S_I2C_ADDRESS)
+        {
+            _fd = open(devPath, O_RDWR);
+            if (_fd < 0 || ioctl(_fd, I2C_SLAVE, devAddr) < 0)
+                return false;
+
+            sensor.read_reg = MC11S_SplitI2C::read;
+            sensor.write_reg = MC11S_SplitI2C::write;
+            sensor.handle = this;
+            return true;
+        }
+
+        void end(void)
+        {
+            if (_fd >= 0)
+                close(_fd);
+            _fd = -1;
+        }
+
+        static int32_t read(void *device, uint8_t addr, uint8_t *data, uint16_t numData)
+        {
+            MC11S_SplitI2C *dev = (MC11S_SplitI2C *)device;
+
+            if (::write(dev->_fd, &addr, 1) != 1 || ::read(dev->_fd, data, numData) != numData)
+                return -1;
+            return 0;
+        }
+
+        static int32_t write(void *device, uint8_t addr, const uint8_t *data, uint16_t numData)
+        {
+            MC11S_SplitI2C *dev = (MC11S_SplitI2C *)device;
+            uint8_t buff[MAP_LEN + 1];
+
+            if (numData > MAP_LEN)
+                return -1;
+            buff[0] = addr;
+            memcpy(&buff[1], data, numData);
+            return ::write(dev->_fd, buff, numData + 1) == numData + 1 ? 0 : -1;
+        }
+
+    private:
+        int _fd;
+};
+
+typedef int32_t (*op_fn)(MC11S *dev);
+
+static int32_t opStatus(MC11S *dev)
+{
+    mc11s_status_t status;
+    return dev->getStatus(&status);
+}
+
+static int32_t opData(MC11S *dev)
+{
+    uint16_t ch0, ch1;
+    return dev->getData(&ch0, &ch1);
+}
+
+static int32_t opStatusData(MC11S *dev)
+{
+    mc11s_status_t status;
+    uint16_t ch0, ch1;
+    return dev->getStatusData(&status, &ch0, &ch1);
+}
+
+static int32_t opRcnt(MC11S *dev)
+{
+    return dev->setRcnt(0x0400);
+}
+
+static int32_t opConversion(MC11S *dev)
+{
+    mc11s_status_t status;
+    uint16_t ch0, ch1;
+    return dev->singleConversion(&ch0, &ch1, &status);
+}
+
+static int32_t opMap(MC11S *dev)
+{
+    uint8_t map[MAP_LEN];
+    return dev->readFunctionConfiguration(0x00, map, MAP_LEN);
+}
+
+static const struct {
+    const char *name;
+    op_fn fn;
+} ops[] = {
+    { "getStatus",          opStatus },
+    { "getData",            opData },
+    { "getStatusData",      opStatusData },
+    { "setRcnt",            opRcnt },
+    { "singleConversion",   opConversion },
+    { "32 byte burst",      opMap },
+};
+
+static double nowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static uint32_t syscalls(void)
+{
+    mc11s_i2c_sim_stats_t stats;
+
+    if (mc11s_i2c_sim_get_stats == NULL)
+        return 0;
+    mc11s_i2c_sim_get_stats(&stats);
+    return stats.syscalls;
+}
+
+// Syscalls and time per call of op, averaged over n calls
+static bool measure(MC11S *dev, op_fn fn, uint32_t n, double *calls, double *us)
+{
+    uint32_t i, before = syscalls();
+    double start = nowUs();
+
+    for (i = 0; i < n; i++)
+        if (fn(dev) != 0)
+            return false;
+
+    *us = (nowUs() - start) / n;
+    *calls = (double)(syscalls() - before) / n;
+    return true;
+}
+
+// STATUS is left out: reading the data registers clears its flags between reads
+static bool sameMap(const uint8_t *a, const uint8_t *b, uint16_t len)
+{
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+        if (i != MC11S_STATUS && a[i] != b[i])
+            return false;
+    return true;
+}
+
+// Reads the map with the adapter limited to limit bytes per message; 0 -> as expected
+static int checkChunking(MC11S_LinuxI2C *dev, const uint8_t *ref, uint16_t limit, uint16_t maxTransfer)
+{
+    uint8_t map[MAP_LEN];
+    mc11s_i2c_sim_stats_t stats;
+    uint32_t before = dev->getTransferCount();
+    int32_t ret;
+
+    mc11s_i2c_sim_set_max_msg(limit);
+    dev->setMaxTransfer(maxTransfer);
+    mc11s_i2c_sim_clear_stats();
+
+    memset(map, 0xA5, sizeof(map));
+    ret = dev->readFunctionConfiguration(0x00, map, MAP_LEN);
+    mc11s_i2c_sim_get_stats(&stats);
+
+    printf("  adapter %4u B/msg, setMaxTransfer %4u: %s, %u ioctl, %2u messages\n",
+           limit, dev->getMaxTransfer(), ret == 0 ? (sameMap(map, ref, MAP_LEN) ? "ok" : "WRONG DATA") : "refused",
+           dev->getTransferCount() - before, stats.messages);
+
+    mc11s_i2c_sim_set_max_msg(0);
+    dev->setMaxTransfer(MC11S_LINUX_I2C_MAX_MSG_LEN);
+
+    // Within the limit the burst must come back intact, beyond it the adapter must refuse it
+    if (maxTransfer <= limit || limit == 0)
+        return (ret == 0 && sameMap(map, ref, MAP_LEN)) ? 0 : 1;
+    return ret != 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    static MC11S_LinuxI2C rdwr;
+    static MC11S_SplitI2C split;
+    const char *path = MC11S_I2C_SIM_DEV;
+    uint32_t n = 1000;
+    uint8_t ref[MAP_LEN];
+    double calls[2], us[2];
+    bool interposed = (mc11s_i2c_sim_get_stats != NULL);
+    int opt, failures = 0;
+    size_t i;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n')
+            n = (uint32_t)atoi(optarg);
+        else {
+            fprintf(stderr, "usage: mc11s_i2c_bench [-n repeats] [device]\n");
+            return 2;
+        }
+    }
+    if (optind < argc)
+        path = argv[optind];
+    if (n == 0)
+        n = 1;
+
+    if (interposed)
+        mc11s_i2c_sim_set_capacitance(20, 22);
+
+    if (!rdwr.begin(path)) {
+        fprintf(stderr, "mc11s_i2c_bench: can't open %s%s\n", path,
+                interposed ? "" : " (run with LD_PRELOAD=./mc11s_i2c_preload.so for the simulated device)");
+        return 1;
+    }
+
+    printf("%-18s %24s %24s\n", "", "I2C_RDWR", "write() + read()");
+    printf("%-18s %12s %11s %12s %11s\n", "operation", "syscalls", "us", "syscalls", "us");
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        uint32_t before = rdwr.getTransferCount();
+
+        if (!measure(&rdwr, ops[i].fn, n, &calls[0], &us[0])) {
+            printf("%-18s failed\n", ops[i].name);
+            failures++;
+            continue;
+        }
+        if (!interposed)
+            calls[0] = (double)(rdwr.getTransferCount() - before) / n;
+
+        // The split transport needs the device to itself
+        rdwr.end();
+        if (!split.begin(path) || !measure(&split, ops[i].fn, n, &calls[1], &us[1])) {
+            calls[1] = us[1] = 0;
+        }
+        split.end();
+        if (!rdwr.begin(path)) {
+            fprintf(stderr, "mc11s_i2c_bench: can't reopen %s\n", path);
+            return 1;
+        }
+
+        if (interposed)
+            printf("%-18s %12.2f %11.2f %12.2f %11.2f\n", ops[i].name, calls[0], us[0], calls[1], us[1]);
+        else
+            printf("%-18s %12.2f %11.2f %12s %11.2f\n", ops[i].name, calls[0], us[0], "-", us[1]);
+    }
+
+    if (!interposed) {
+        printf("chunking checks skipped: not running under mc11s_i2c_preload.so\n");
+        return failures ? 1 : 0;
+    }
+
+    // Bursts split to fit an adapter with a message limit
+    printf("\n32 byte burst through a limited adapter:\n");
+    if (rdwr.readFunctionConfiguration(0x00, ref, MAP_LEN) != 0)
+        return 1;
+
+    failures += checkChunking(&rdwr, ref, 0, MC11S_LINUX_I2C_MAX_MSG_LEN);
+    failures += checkChunking(&rdwr, ref, 16, MC11S_LINUX_I2C_MAX_MSG_LEN);
+    failures += checkChunking(&rdwr, ref, 16, 16);
+    failures += checkChunking(&rdwr, ref, 8, 8);
+    failures += checkChunking(&rdwr, ref, 4, 3);
+    failures += checkChunking(&rdwr, ref, 2, 2);
+
+    // 128 bytes in 2 byte chunks is 128 messages: more than one ioctl may carry
+    {
+        uint8_t map[0x80], whole[0x80];
+        uint32_t before;
+
+        rdwr.readFunctionConfiguration(0x00, whole, sizeof(whole));
+        mc11s_i2c_sim_set_max_msg(2);
+        rdwr.setMaxTransfer(2);
+        before = rdwr.getTransferCount();
+        memset(map, 0xA5, sizeof(map));
+
+        bool ok = rdwr.readFunctionConfiguration(0x00, map, sizeof(map)) == 0 &&
+                  sameMap(map, whole, sizeof(map));
+        printf("  adapter    2 B/msg, 128 byte burst: %s, %u ioctl\n",
+               ok ? "ok" : "WRONG DATA", rdwr.getTransferCount() - before);
+        failures += ok ? 0 : 1;
+
+        mc11s_i2c_sim_set_max_msg(0);
+        rdwr.setMaxTransfer(MC11S_LINUX_I2C_MAX_MSG_LEN);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "all checks passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,313 @@
+/******************************************************************************
+mc11s_i2c_preload.so: an ioctl interposer that answers for an i2c-dev
+device with a simulated MC11S, so MC11S_LinuxI2C (or any program using
+i2c-dev) runs unchanged on a host without the sensor or an I2C adapter.
+
+    LD_PRELOAD=./mc11s_i2c_preload.so program /dev/i2c-sim
+
+open() of the device path (MC11S_I2C_SIM_DEV, "/dev/i2c-sim" by default)
+returns a descriptor that read(), write(), ioctl() and close() route to an
+MC11S_Sim register model instead of the kernel. Every other path and
+descriptor goes to libc untouched. What the kernel and an adapter do is
+checked, not assumed:
+
+    I2C_FUNCS       reports I2C_FUNC_I2C (plain I2C, combined transfers)
+    I2C_SLAVE       sets the address read() and write() go to
+    I2C_RDWR        runs the messages in order: a write sets the register
+                    pointer and writes the bytes after it, a read reads
+                    from the pointer on. More than I2C_RDWR_IOCTL_MAX_MSGS
+                    messages fail with EINVAL, a message to another address
+                    with ENXIO (no ACK) and, with a limit set, a message
+                    longer than the adapter takes with EOPNOTSUPP, like the
+                    quirks of the real adapters
+    read/write      one message each, to the I2C_SLAVE address
+
+Environment:
+
+    MC11S_I2C_SIM_DEV       device path to answer for
+    MC11S_I2C_SIM_MAX_MSG   longest message the adapter takes (0 -> any)
+    MC11S_I2C_SIM_CAP       "c0,c1": capacitances in pF the model converts
+    MC11S_I2C_SIM_STATS     when set, the counters go to stderr at exit
+
+mc11s_i2c_preload.h declares the functions a program can call to read the
+counters and set the limits while it runs.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "MC11S_Sim.h"
+#include "mc11s_i2c_preload.h"
+
+#ifndef I2C_RDWR_IOCTL_MAX_MSGS
+#define I2C_RDWR_IOCTL_MAX_MSGS 42
+#endif
+
+typedef int (*open_fn)(const char *, int, ...);
+typedef int (*close_fn)(int);
+typedef ssize_t (*read_fn)(int, void *, size_t);
+typedef ssize_t (*write_fn)(int, const void *, size_t);
+typedef int (*ioctl_fn)(int, unsigned long, ...);
+
+static MC11S_Sim sim;
+static mc11s_i2c_sim_stats_t stats;
+static int simFd = -1;
+static uint16_t slaveAddr = MC11S_I2C_ADDRESS;
+static uint8_t regPtr = 0;
+static uint16_t maxMsg = 0;
+static bool configured = false;
+
+template <typename T>
+static T real(const char *name)
+{
+    return (T)dlsym(RTLD_NEXT, name);
+}
+
+static void configure(void)
+{
+    const char *env;
+    float c0, c1;
+
+    if (configured)
+        return;
+    configured = true;
+
+    env = getenv("MC11S_I2C_SIM_MAX_MSG");
+    if (env != NULL)
+        maxMsg = (uint16_t)atoi(env);
+
+    env = getenv("MC11S_I2C_SIM_CAP");
+    if (env != NULL && sscanf(env, "%f,%f", &c0, &c1) == 2)
+        sim.setCapacitance(c0, c1);
+}
+
+static bool isSimPath(const char *path)
+{
+    const char *dev = getenv("MC11S_I2C_SIM_DEV");
+
+    return path != NULL && strcmp(path, dev != NULL ? dev : MC11S_I2C_SIM_DEV) == 0;
+}
+
+// One message as the adapter would move it (0, or -errno for a NACK or a message too long)
+static int transfer(uint16_t addr, bool rd, uint8_t *buf, uint16_t len)
+{
+    if (addr != MC11S_I2C_ADDRESS)
+        return -ENXIO;
+    if (maxMsg != 0 && len > maxMsg) {
+        stats.rejected++;
+        return -EOPNOTSUPP;
+    }
+
+    stats.messages++;
+    stats.bytes += len;
+
+    if (rd) {
+        MC11S_Sim::read(&sim, regPtr, buf, len);
+        regPtr = (uint8_t)(regPtr + len);
+    } else if (len > 0) {
+        regPtr = buf[0];
+        if (len > 1) {
+            MC11S_Sim::write(&sim, regPtr, buf + 1, len - 1);
+            regPtr = (uint8_t)(regPtr + len - 1);
+        }
+    }
+
+    return 0;
+}
+
+static int rdwr(struct i2c_rdwr_ioctl_data *xfer)
+{
+    uint32_t i;
+    int ret;
+
+    stats.rdwr++;
+
+    if (xfer->nmsgs > I2C_RDWR_IOCTL_MAX_MSGS) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (i = 0; i < xfer->nmsgs; i++) {
+        struct i2c_msg *msg = &xfer->msgs[i];
+
+        ret = transfer(msg->addr, (msg->flags & I2C_M_RD) != 0, msg->buf, msg->len);
+        if (ret != 0) {
+            errno = -ret;
+            return -1;
+        }
+    }
+
+    return (int)xfer->nmsgs;
+}
+
+extern "C" {
+
+int open(const char *path, int flags, ...)
+{
+    static open_fn next = real<open_fn>("open");
+    mode_t mode = 0;
+    va_list ap;
+
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    if (!isSimPath(path))
+        return next(path, flags, mode);
+
+    configure();
+    if (simFd >= 0) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    // A real descriptor keeps the number from being handed out twice
+    simFd = next("/dev/null", O_RDWR);
+    if (simFd >= 0)
+        stats.syscalls++;
+    return simFd;
+}
+
+int open64(const char *path, int flags, ...)
+{
+    mode_t mode = 0;
+    va_list ap;
+
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    return open(path, flags, mode);
+}
+
+int close(int fd)
+{
+    static close_fn next = real<close_fn>("close");
+
+    if (fd >= 0 && fd == simFd) {
+        stats.syscalls++;
+        simFd = -1;
+    }
+
+    return next(fd);
+}
+
+ssize_t read(int fd, void *buf, size_t len)
+{
+    static read_fn next = real<read_fn>("read");
+    int ret;
+
+    if (fd < 0 || fd != simFd)
+        return next(fd, buf, len);
+
+    stats.syscalls++;
+    ret = transfer(slaveAddr, true, (uint8_t *)buf, (uint16_t)len);
+    if (ret != 0) {
+        errno = -ret;
+        return -1;
+    }
+
+    return (ssize_t)len;
+}
+
+ssize_t write(int fd, const void *buf, size_t len)
+{
+    static write_fn next = real<write_fn>("write");
+    int ret;
+
+    if (fd < 0 || fd != simFd)
+        return next(fd, buf, len);
+
+    stats.syscalls++;
+    ret = transfer(slaveAddr, false, (uint8_t *)buf, (uint16_t)len);
+    if (ret != 0) {
+        errno = -ret;
+        return -1;
+    }
+
+    return (ssize_t)len;
+}
+
+int ioctl(int fd, unsigned long request, ...) __THROW
+{
+    static ioctl_fn next = real<ioctl_fn>("ioctl");
+    void *arg;
+    va_list ap;
+
+    va_start(ap, request);
+    arg = va_arg(ap, void *);
+    va_end(ap);
+
+    if (fd < 0 || fd != simFd)
+        return next(fd, request, arg);
+
+    stats.syscalls++;
+
+    switch (request) {
+    case I2C_FUNCS:
+        *(unsigned long *)arg = I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+        return 0;
+    case I2C_SLAVE:
+    case I2C_SLAVE_FORCE:
+        slaveAddr = (uint16_t)(unsigned long)arg;
+        return 0;
+    case I2C_RDWR:
+        return rdwr((struct i2c_rdwr_ioctl_data *)arg);
+    default:
+        errno = ENOTTY;
+        return -1;
+    }
+}
+
+void mc11s_i2c_sim_get_stats(mc11s_i2c_sim_stats_t *out)
+{
+    *out = stats;
+}
+
+void mc11s_i2c_sim_clear_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+void mc11s_i2c_sim_set_max_msg(uint16_t len)
+{
+    configure();
+    maxMsg = len;
+}
+
+void mc11s_i2c_sim_set_capacitance(float c0pF, float c1pF)
+{
+    configure();
+    sim.setCapacitance(c0pF, c1pF);
+}
+
+}
+
+__attribute__((destructor))
+static void report(void)
+{
+    if (getenv("MC11S_I2C_SIM_STATS") == NULL)
+        return;
+
+    fprintf(stderr, "mc11s_i2c_preload: %u syscalls, %u I2C_RDWR, %u messages, %u bytes, %u rejected\n",
+            stats.syscalls, stats.rdwr, stats.messages, stats.bytes, stats.rejected);
+}
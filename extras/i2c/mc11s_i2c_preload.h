@@ -0,0 +1,37 @@
+/******************************************************************************
+This file declares the query interface of mc11s_i2c_preload.so, the ioctl
+interposer that puts a simulated MC11S behind an i2c-dev path. A program
+running under it can read the interposer's counters and set the limits of
+the adapter it pretends to be.
+
+Declare nothing else from the interposer: the functions are weak, so a
+program that was started without LD_PRELOAD sees them as NULL.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#ifndef __MC11S_I2C_Preload_H__
+#define __MC11S_I2C_Preload_H__
+
+#include <stdint.h>
+
+// Device path the interposer answers for, unless MC11S_I2C_SIM_DEV says otherwise
+#define MC11S_I2C_SIM_DEV       "/dev/i2c-sim"
+
+typedef struct {
+    uint32_t syscalls;      // open/close/read/write/ioctl on the simulated device
+    uint32_t rdwr;          // I2C_RDWR ioctls among them
+    uint32_t messages;      // i2c_msg moved by those ioctls, read() and write()
+    uint32_t bytes;         // Data bytes on the bus, register addresses included
+    uint32_t rejected;      // Calls the adapter limits turned down
+} mc11s_i2c_sim_stats_t;
+
+extern "C" {
+    void mc11s_i2c_sim_get_stats(mc11s_i2c_sim_stats_t *stats) __attribute__((weak));
+    void mc11s_i2c_sim_clear_stats(void) __attribute__((weak));
+    void mc11s_i2c_sim_set_max_msg(uint16_t len) __attribute__((weak));   // 0 -> no limit
+    void mc11s_i2c_sim_set_capacitance(float c0pF, float c1pF) __attribute__((weak));
+}
+
+#endif
@@ -0,0 +1,112 @@
+/******************************************************************************
+mc11s_decode: reads the binary stream of MC11S_StreamEncoder from a serial
+device, a file or stdin and prints every sample it reconstructs as a CSV
+line, source first:
+
+    source,seq,time_us,ch0,ch1,status
+
+    mc11s_decode [-B baud] [-n samples] [-q] device|file|-
+
+    -B  baud rate of a serial device (default 115200)
+    -n  stop after this many samples (default: at the end of the input)
+    -q  no sample lines, only the summary
+
+The summary on stderr has the frames, samples, CRC errors, frames lost
+(gaps in the frame seq) and delta frames skipped while waiting for a key
+frame, the bytes per sample received and what the same samples would have
+taken as CSV.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "MC11S_Stream.h"
+#include "MC11S_Serialize.h"
+#include "mc11s_serial.h"
+
+typedef struct {
+    MC11S_FdPrint *out;
+    MC11S_CountPrint csvSize;
+    MC11S_SampleWriter csv;
+    uint32_t limit;
+} decode_ctx_t;
+
+static void onSample(void *arg, uint8_t source, const mc11s_sample_t &sample)
+{
+    decode_ctx_t *ctx = (decode_ctx_t *)arg;
+
+    if (ctx->out != NULL) {
+        ctx->out->print((unsigned int)source);
+        ctx->out->print(',');
+        ctx->csv.write(*ctx->out, sample);
+    }
+
+    ctx->csvSize.print((unsigned int)source);
+    ctx->csvSize.print(',');
+    ctx->csv.write(ctx->csvSize, sample);
+}
+
+int main(int argc, char **argv)
+{
+    static MC11S_StreamDecoder decoder;
+    MC11S_FdPrint out(STDOUT_FILENO);
+    decode_ctx_t ctx;
+    uint32_t baud = 115200;
+    bool quiet = false;
+    uint8_t buf[256];
+    int opt, fd;
+
+    ctx.limit = 0;
+    while ((opt = getopt(argc, argv, "B:n:q")) != -1) {
+        switch (opt) {
+            case 'B': baud = strtoul(optarg, NULL, 0); break;
+            case 'n': ctx.limit = strtoul(optarg, NULL, 0); break;
+            case 'q': quiet = true; break;
+            default:
+                fprintf(stderr, "usage: mc11s_decode [-B baud] [-n samples] [-q] device|file|-\n");
+                return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: mc11s_decode [-B baud] [-n samples] [-q] device|file|-\n");
+        return 2;
+    }
+
+    fd = mc11s_serial_open(argv[optind], baud);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    ctx.out = quiet ? NULL : &out;
+    decoder.onSample(onSample, &ctx);
+
+    while (ctx.limit == 0 || decoder.getSampleCount() < ctx.limit) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        // 0 at the end of a file, EIO once the other end of a pty has gone
+        if (n <= 0)
+            break;
+        decoder.push(buf, n);
+    }
+
+    uint32_t samples = decoder.getSampleCount(), bytes = decoder.getByteCount();
+
+    fprintf(stderr, "%u frames, %u samples, %u errors, %u lost, %u skipped\n",
+            decoder.getFrameCount(), samples, decoder.getErrorCount(),
+            decoder.getLostCount(), decoder.getSkippedCount());
+    if (samples != 0)
+        fprintf(stderr, "%u B received, %.2f B/sample; as csv %u B, %.2f B/sample (%.1f%% saved)\n",
+                bytes, (double)bytes / samples, ctx.csvSize.getByteCount(),
+                (double)ctx.csvSize.getByteCount() / samples,
+                100.0 * (1.0 - (double)bytes / ctx.csvSize.getByteCount()));
+
+    return decoder.getErrorCount() != 0;
+}
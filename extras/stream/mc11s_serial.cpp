@@ -0,0 +1,121 @@
+#include "mc11s_serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t mc11s_serial_speed(uint32_t baud)
+{
+    switch (baud) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 921600: return B921600;
+        default: return 0;
+    }
+}
+
+static int mc11s_serial_raw(int fd, uint32_t baud)
+{
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) != 0)
+        return -1;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (baud != 0) {
+        speed_t speed = mc11s_serial_speed(baud);
+
+        if (speed == 0)
+            return -1;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+int mc11s_serial_open(const char *path, uint32_t baud)
+{
+    int fd;
+
+    if (strcmp(path, "-") == 0)
+        return STDIN_FILENO;
+
+    fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+
+    if (isatty(fd) && mc11s_serial_raw(fd, baud) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int mc11s_pty_open(char *slavePath, size_t len, int *slaveFd)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    const char *name;
+
+    if (master < 0)
+        return -1;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || (name = ptsname(master)) == NULL ||
+        strlen(name) >= len) {
+        close(master);
+        return -1;
+    }
+    strcpy(slavePath, name);
+
+    // Raw on the slave side, or the line discipline rewrites the bytes
+    *slaveFd = open(slavePath, O_RDWR | O_NOCTTY);
+    if (*slaveFd < 0 || mc11s_serial_raw(*slaveFd, 0) != 0) {
+        close(master);
+        return -1;
+    }
+
+    return master;
+}
+
+MC11S_FdPrint::MC11S_FdPrint(int fd) : _fd{fd}, _bytes{0}
+{
+}
+
+size_t MC11S_FdPrint::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t MC11S_FdPrint::write(const uint8_t *buffer, size_t size)
+{
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t n = ::write(_fd, buffer + done, size - done);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += n;
+    }
+
+    _bytes += done;
+    return done;
+}
+
+uint32_t MC11S_FdPrint::getByteCount(void)
+{
+    return _bytes;
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+This file defines the host side plumbing of the stream tools: opening a
+serial device, a file or stdin as a raw byte source, creating a pseudo
+terminal for a simulated device, and a Print that writes to a file
+descriptor so the library's encoder and serializers can write to any of
+them.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#ifndef __MC11S_Serial_H__
+#define __MC11S_Serial_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "MC11S_Print.h"
+
+// Opens path for reading ("-" -> stdin); a tty is put in raw mode at baud (0 -> as is)
+int mc11s_serial_open(const char *path, uint32_t baud);
+
+// Creates a raw pseudo terminal; the slave is kept open so writes buffer until a reader comes
+int mc11s_pty_open(char *slavePath, size_t len, int *slaveFd);
+
+class MC11S_FdPrint : public Print
+{
+    public:
+        MC11S_FdPrint(int fd);
+
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buffer, size_t size);
+        uint32_t getByteCount(void);
+
+    private:
+        int _fd;
+        uint32_t _bytes;
+};
+
+// Counts bytes without writing them, for size comparisons
+class MC11S_CountPrint : public Print
+{
+    public:
+        MC11S_CountPrint(void) : _bytes{0} { }
+
+        size_t write(uint8_t) { _bytes++; return 1; }
+        size_t write(const uint8_t *, size_t size) { _bytes += size; return size; }
+        uint32_t getByteCount(void) { return _bytes; }
+
+    private:
+        uint32_t _bytes;
+};
+
+#endif
@@ -0,0 +1,204 @@
+/******************************************************************************
+mc11s_simstream: a simulated tank level node. One or more simulated MC11S
+(MC11S_Sim) follow a tank that fills and drains, converting at 4 Hz with
+some timing jitter and the odd missed conversion, and their samples are
+sent as the binary stream of MC11S_StreamEncoder, or as CSV / JSON lines
+for comparison, to a file, stdout or a pseudo terminal that a decoder can
+open like a serial port.
+
+    mc11s_simstream [-n samples] [-s sources] [-r hz] [-k keyframe]
+                    [-b batch] [-f stream|csv|json] [-p | output]
+
+    -n  samples per source (default 1000)
+    -s  number of sensors sharing the link (default 1)
+    -r  send in real time at this rate (default 0, as fast as possible)
+    -k  key frame interval in samples (default 32)
+    -b  samples per frame (default 1)
+    -f  output format (default stream)
+    -p  create a pseudo terminal, print its path and wait for a reader
+
+The size of the same samples in every format goes to stderr at the end,
+with how many sensors at 4 Hz a 115200 baud link would carry in each.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux
+    Hardware Platform: any Linux host
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "MC11S_Sim.h"
+#include "MC11S_Stream.h"
+#include "MC11S_Serialize.h"
+#include "mc11s_serial.h"
+
+#define SIM_MAX_SOURCES     16
+#define SIM_PERIOD_US       250000UL
+#define LINK_BYTES_PER_S    11520.0     // 115200 baud, 10 bits per byte
+
+static uint32_t rng = 12345;
+
+// Uniform in [-1, 1), fixed seed so every run sends the same samples
+static float noise(void)
+{
+    rng = rng * 1664525UL + 1013904223UL;
+    return (rng >> 8) / 8388608.0f - 1.0f;
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: mc11s_simstream [-n samples] [-s sources] [-r hz] [-k keyframe] "
+                    "[-b batch] [-f stream|csv|json] [-p | output]\n");
+    exit(2);
+}
+
+static void report(const char *label, uint32_t bytes, uint32_t samples)
+{
+    double perSample = samples ? (double)bytes / samples : 0;
+
+    fprintf(stderr, "%-8s %9u B  %6.2f B/sample  %5.0f sensors @ 4 Hz on 115200 baud\n",
+            label, bytes, perSample, perSample ? LINK_BYTES_PER_S / (4 * perSample) : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    static MC11S_Sim sims[SIM_MAX_SOURCES];
+    static MC11S_StreamEncoder encoders[SIM_MAX_SOURCES];
+    static MC11S_StreamEncoder shadow[SIM_MAX_SOURCES];
+    uint32_t seq[SIM_MAX_SOURCES] = { 0 };
+    uint32_t samples = 1000, keyInterval = 32, batch = 1, total = 0;
+    uint8_t sources = 1;
+    float rate = 0;
+    const char *format = "stream";
+    bool pty = false;
+    int opt, fd = STDOUT_FILENO, slave = -1;
+    char path[128];
+
+    while ((opt = getopt(argc, argv, "n:s:r:k:b:f:p")) != -1) {
+        switch (opt) {
+            case 'n': samples = strtoul(optarg, NULL, 0); break;
+            case 's': sources = (uint8_t)strtoul(optarg, NULL, 0); break;
+            case 'r': rate = strtof(optarg, NULL); break;
+            case 'k': keyInterval = strtoul(optarg, NULL, 0); break;
+            case 'b': batch = strtoul(optarg, NULL, 0); break;
+            case 'f': format = optarg; break;
+            case 'p': pty = true; break;
+            default: usage();
+        }
+    }
+    if (sources == 0 || sources > SIM_MAX_SOURCES || optind < argc - 1 ||
+        (strcmp(format, "stream") && strcmp(format, "csv") && strcmp(format, "json")))
+        usage();
+
+    if (pty) {
+        fd = mc11s_pty_open(path, sizeof(path), &slave);
+        if (fd < 0) {
+            perror("pty");
+            return 1;
+        }
+        printf("%s\n", path);
+        fflush(stdout);
+    } else if (optind < argc) {
+        fd = open(argv[optind], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    MC11S_FdPrint out(fd);
+    MC11S_CountPrint csvSize, jsonSize, frameSize, streamSize;
+    MC11S_SampleWriter csv(MC11S_SER_CSV), json(MC11S_SER_JSON), frame(MC11S_SER_BINARY);
+    bool stream = (strcmp(format, "stream") == 0);
+    MC11S_SampleWriter &text = (strcmp(format, "json") == 0) ? json : csv;
+
+    for (uint8_t s = 0; s < sources; s++) {
+        sims[s].begin();
+        // Ranged at the empty tank, the smallest probe capacitance gives the most counts
+        sims[s].setCapacitance(95.0f, 120.0f);
+        sims[s].autoRange();
+        sims[s].setNoise(40);
+        encoders[s].begin(out, s);
+        encoders[s].setKeyframeInterval(keyInterval);
+        encoders[s].setBatch(batch);
+        // Sizes the stream for the report when another format is sent
+        shadow[s].begin(streamSize, s);
+        shadow[s].setKeyframeInterval(keyInterval);
+        shadow[s].setBatch(batch);
+    }
+
+    for (uint32_t i = 0; i < samples; i++) {
+        for (uint8_t s = 0; s < sources; s++) {
+            mc11s_sample_t sample;
+            float level = 0.5f - 0.5f * cosf(6.2832f * (i + 97.0f * s) / 2000.0f);
+
+            // Probe capacitance follows the level, the reference stays put
+            sims[s].setCapacitance(95.0f + 30.0f * level + 0.05f * noise(), 120.0f);
+            sims[s].convert();
+            if (sims[s].getStatusData(&sample.status, &sample.ch0, &sample.ch1) != 0)
+                return 1;
+
+            // Now and then a conversion is overwritten before it is read
+            seq[s] += (noise() > 0.99f) ? 2 : 1;
+            sample.seq = seq[s];
+            sample.timestamp = 1000000UL * (s + 1) + sample.seq * SIM_PERIOD_US + (int32_t)(400 * noise());
+
+            if (stream) {
+                encoders[s].add(sample);
+            } else {
+                out.print((unsigned int)s);
+                out.print(',');
+                text.write(out, sample);
+            }
+
+            shadow[s].add(sample);
+            csvSize.print((unsigned int)s);
+            csvSize.print(',');
+            csv.write(csvSize, sample);
+            jsonSize.print((unsigned int)s);
+            jsonSize.print(',');
+            json.write(jsonSize, sample);
+            frame.write(frameSize, sample);
+            total++;
+        }
+
+        if (rate > 0)
+            usleep((useconds_t)(1000000 / rate));
+    }
+
+    for (uint8_t s = 0; s < sources; s++) {
+        encoders[s].flush();
+        shadow[s].flush();
+    }
+
+    report("csv", csvSize.getByteCount(), total);
+    report("json", jsonSize.getByteCount(), total);
+    report("frame", frameSize.getByteCount(), total);
+    report("stream", streamSize.getByteCount(), total);
+    fprintf(stderr, "stream saves %.1f%% of csv\n",
+            100.0 * (1.0 - (double)streamSize.getByteCount() / csvSize.getByteCount()));
+
+    // Let the reader drain the pseudo terminal before it goes away: the input
+    // queue of the slave has to stay empty for a while, bytes still on their
+    // way from the master side show up in it late
+    if (pty) {
+        int pending, idle = 0;
+
+        for (int t = 0; t < 1000 && idle < 50; t++) {
+            if (ioctl(slave, FIONREAD, &pending) != 0)
+                break;
+            idle = pending ? 0 : idle + 1;
+            usleep(10000);
+        }
+        close(slave);
+    }
+    if (fd != STDOUT_FILENO)
+        close(fd);
+
+    return 0;
+}
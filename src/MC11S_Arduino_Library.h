@@ -11,7 +11,7 @@ Development environment specifics:
 #define __MC11S_Arduino_Library_H__
 
 
-#include "mc11s_class.h"
+#include "MC11S_class.h"
 #include <Wire.h>
 
 // #define DEBUG
@@ -0,0 +1,160 @@
+/******************************************************************************
+This file defines the level band state machine. The MC11S compares against
+one TRH/TRL pair; a tank usually needs more than two states, e.g.
+
+    EMPTY | LOW | NORMAL | HIGH | OVERFLOW
+
+MC11S_BandMachine<N> runs N bands over a level stream (Q16.16, e.g. from
+MC11S_Calibration::evaluateCounts()) from two const tables:
+
+    edges[N - 1]    the boundary above each band: the level rises into the
+                    band above at or past rise, and falls back only below
+                    fall (fall <= rise is that boundary's hysteresis)
+    dwell[N]        ms the level has to stay in a band before the move into
+                    it is reported, so a wave or a splash can't flap it
+
+Each reported move is an mc11s_band_event_t with the time it was reported
+and the time the level first crossed, so the delay the dwell added is
+known. A level that jumps several bands at once gives one event from the
+old band to the new one. Nothing is allocated, the tables are only read,
+and a sample costs the same whatever the history; only a jump across k
+bands walks k edges.
+
+The sizes of both tables are checked against N when the machine is built,
+and mc11s_bands_valid() checks a constexpr table when the sketch compiles:
+
+    constexpr mc11s_band_edge_t edges[] = {
+        { MC11S_LEVEL_Q16(50),  MC11S_LEVEL_Q16(40) },     // EMPTY | LOW
+        ...
+    };
+    static_assert(mc11s_bands_valid(edges), "band edges overlap");
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Bands_H__
+#define __MC11S_Bands_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Level in Q16.16 from a constant, usable in constexpr tables
+#define MC11S_LEVEL_Q16(x)		((int32_t)((x) * 65536.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+// Band before the first sample
+#define MC11S_BAND_NONE			0xFF
+
+typedef enum {
+	MC11S_BAND_EMPTY = 0x0,
+	MC11S_BAND_LOW = 0x1,
+	MC11S_BAND_NORMAL = 0x2,
+	MC11S_BAND_HIGH = 0x3,
+	MC11S_BAND_OVERFLOW = 0x4,
+} mc11s_band_t;
+
+typedef struct {
+	int32_t rise;			// Level the band above is entered at, Q16.16
+	int32_t fall;			// Level below which it is left again, <= rise
+} mc11s_band_edge_t;
+
+typedef struct {
+	uint32_t time;			// When the move was reported, ms
+	uint32_t since;			// When the level crossed into the band, ms
+	int32_t level;			// Level of the sample that reported it, Q16.16
+	uint8_t from;			// MC11S_BAND_NONE on the first sample
+	uint8_t to;
+} mc11s_band_event_t;
+
+/**
+ * @brief  True when every boundary has fall <= rise and every band keeps
+ *         some level of its own: a boundary's fall lies above the rise of
+ *         the one below it.
+ */
+template <size_t E>
+constexpr bool mc11s_bands_valid(const mc11s_band_edge_t (&edges)[E], size_t i = 0) {
+	return i >= E ? true :
+		   edges[i].fall <= edges[i].rise &&
+		   (i == 0 || edges[i - 1].rise < edges[i].fall) &&
+		   mc11s_bands_valid(edges, i + 1);
+}
+
+template <uint8_t N>
+class MC11S_BandMachine {
+		static_assert(N >= 2, "MC11S_BandMachine needs at least two bands");
+	public:
+		MC11S_BandMachine(const mc11s_band_edge_t (&edges)[N - 1], const uint32_t (&dwell)[N]) :
+			_edges(edges), _dwell(dwell)
+		{
+			reset();
+		}
+
+		// The next sample sets the band again, without dwell
+		void reset(void) {
+			_band = MC11S_BAND_NONE;
+			_candidate = MC11S_BAND_NONE;
+			_since = 0;
+		}
+
+		// Run time check of the tables, for ones that aren't constexpr
+		bool isValid(void) {
+			for (uint8_t i = 0; i < N - 1; i++)
+				if (_edges[i].fall > _edges[i].rise || (i > 0 && _edges[i - 1].rise >= _edges[i].fall))
+					return false;
+			return true;
+		}
+
+		/**
+		 * @brief  Takes one level sample.
+		 * @param  level  Q16.16
+		 * @param  now    ms, e.g. millis(); may wrap
+		 * @param  event  Filled in when the band changed (may be NULL)
+		 * @retval true when the band changed
+		 */
+		bool update(int32_t level, uint32_t now, mc11s_band_event_t *event) {
+			uint8_t target = (_band == MC11S_BAND_NONE) ? 0 : _band;
+
+			while (target < N - 1 && level >= _edges[target].rise)
+				target++;
+			while (target > 0 && level < _edges[target - 1].fall)
+				target--;
+
+			if (_band == MC11S_BAND_NONE) {
+				_since = now;
+			} else if (target == _band) {
+				_candidate = _band;
+				return false;
+			} else if (target != _candidate) {
+				_candidate = target;
+				_since = now;
+			}
+
+			if (_band != MC11S_BAND_NONE && now - _since < _dwell[target])
+				return false;
+
+			if (event != NULL) {
+				event->time = now;
+				event->since = _since;
+				event->level = level;
+				event->from = _band;
+				event->to = target;
+			}
+
+			_band = target;
+			_candidate = target;
+			return true;
+		}
+
+		uint8_t getBand(void) { return _band; }				// MC11S_BAND_NONE before the first sample
+		bool isPending(void) { return _candidate != _band; }	// Level in another band, dwell running
+		uint32_t getSince(void) { return _since; }			// When the band or the pending move began
+
+	private:
+		const mc11s_band_edge_t (&_edges)[N - 1];
+		const uint32_t (&_dwell)[N];
+		uint8_t _band;
+		uint8_t _candidate;
+		uint32_t _since;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "MC11S_Baseline.h"
+
+MC11S_BaselineTracker::MC11S_BaselineTracker(void) :
+	_trip{0.08f}, _release{0.05f}, _alpha{1.0f / 1024}, _debounce{2}, _pending{0},
+	_seeded{false}, _baseline{0}, _ratio{0}, _state{MC11S_BASELINE_CLEAR},
+	_sensor{NULL}, _interval{0}, _sinceProgram{0}, _trh{-1}, _trl{-1}, _programs{0}
+{
+}
+
+/**
+ * @brief  			Sets how far below the baseline the ratio has to drop
+ * @param	trip		Detection sets at baseline * (1 - trip)
+ * @param	release		and clears above baseline * (1 - release)
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_BaselineTracker::setThresholds(float trip, float release) {
+	if (trip <= 0 || trip >= 1 || release < 0 || release >= trip)
+		return -1;
+
+	_trip = trip;
+	_release = release;
+	return 0;
+}
+
+/**
+ * @brief  			Sets how fast the baseline follows the dry ratio. Drift much
+ * 					slower than this is followed, a flood much faster trips.
+ * @param	samples		Time constant in samples (0 -> baseline fixed)
+ */
+void MC11S_BaselineTracker::setAdaptation(uint16_t samples) {
+	_alpha = (samples == 0) ? 0 : 1.0f / samples;
+}
+
+/**
+ * @brief  			Sets how many samples in a row have to be past the trip ratio,
+ * 					so a single glitch doesn't raise an alarm
+ * @param	samples		1 -> detect on the first
+ */
+void MC11S_BaselineTracker::setDebounce(uint8_t samples) {
+	_debounce = (samples == 0) ? 1 : samples;
+}
+
+/**
+ * @brief  			Keeps the chip's TRH/TRL on the baseline
+ * @param	sensor		MC11S to reprogram (NULL -> software detection only)
+ * @param	interval	Samples between checks of the thresholds
+ */
+void MC11S_BaselineTracker::setFollow(MC11S *sensor, uint16_t interval) {
+	_sensor = sensor;
+	_interval = (interval == 0) ? 1 : interval;
+	_sinceProgram = 0;
+	_trh = -1;
+	_trl = -1;
+}
+
+void MC11S_BaselineTracker::reset(void) {
+	_seeded = false;
+	_pending = 0;
+	_state = MC11S_BASELINE_CLEAR;
+}
+
+void MC11S_BaselineTracker::setBaseline(float ratio) {
+	_baseline = ratio;
+	_seeded = ratio > 0;
+}
+
+/**
+ * @brief  			C_ch0 / C_ch1 from a pair of counts, with the same correction
+ * 					the alarm comparator thresholds are worked out with
+ * @param	ch0		Channel0 count
+ * @param	ch1		Channel1 count
+ * @retval  		Ratio, 0 if ch0 is 0
+ */
+float MC11S_BaselineTracker::ratioFromCounts(uint16_t ch0, uint16_t ch1) {
+	float ratio, Coef_fix;
+
+	if (ch0 == 0)
+		return 0;
+
+	ratio = (float)ch1 / ch0;
+	mc11s_coef_fix_ratio_get(ratio, &Coef_fix);
+
+	return ratio * Coef_fix;
+}
+
+bool MC11S_BaselineTracker::update(uint16_t ch0, uint16_t ch1) {
+	float ratio = ratioFromCounts(ch0, ch1);
+
+	// A saturated or missing channel says nothing about the water
+	if (ratio <= 0 || ch0 == 0xFFFF || ch1 == 0xFFFF)
+		return false;
+
+	return update(ratio);
+}
+
+/**
+ * @brief  			Takes one sample: runs the detection, then moves the baseline
+ * 					unless a detection is active or pending, then reprograms TRH/TRL
+ * 					if they are due and have moved
+ * @param	ratio	C_ch0 / C_ch1 (reference / probe)
+ * @retval  		true when the detection set or cleared
+ */
+bool MC11S_BaselineTracker::update(float ratio) {
+	mc11s_baseline_state_t prev = _state;
+
+	if (ratio <= 0)
+		return false;
+
+	_ratio = ratio;
+
+	if (!_seeded) {
+		setBaseline(ratio);
+		if (_sensor != NULL)
+			program();
+		return false;
+	}
+
+	if (_state == MC11S_BASELINE_CLEAR) {
+		if (ratio < getTripRatio()) {
+			if (++_pending >= _debounce) {
+				_state = MC11S_BASELINE_DETECT;
+				_pending = 0;
+			}
+		} else {
+			_pending = 0;
+		}
+	} else if (ratio > getReleaseRatio()) {
+		_state = MC11S_BASELINE_CLEAR;
+	}
+
+	if (_state == MC11S_BASELINE_CLEAR && _pending == 0) {
+		_baseline += (ratio - _baseline) * _alpha;
+
+		if (_sensor != NULL && ++_sinceProgram >= _interval) {
+			float trh, trl;
+
+			_sinceProgram = 0;
+
+			// Only touch the bus when a code changes
+			if (mc11s_threshold_from_ratio(getTripRatio(), &trh) == 0 &&
+				mc11s_threshold_from_ratio(getReleaseRatio(), &trl) == 0 &&
+				((int16_t)(trh + 0.5f) != _trh || (int16_t)(trl + 0.5f) != _trl))
+				program();
+		}
+	}
+
+	return _state != prev;
+}
+
+mc11s_baseline_state_t MC11S_BaselineTracker::getState(void) {
+	return _state;
+}
+
+bool MC11S_BaselineTracker::isDetecting(void) {
+	return _state == MC11S_BASELINE_DETECT;
+}
+
+float MC11S_BaselineTracker::getBaseline(void) {
+	return _baseline;
+}
+
+float MC11S_BaselineTracker::getRatio(void) {
+	return _ratio;
+}
+
+float MC11S_BaselineTracker::getDeviation(void) {
+	return (_baseline > 0) ? (_baseline - _ratio) / _baseline : 0;
+}
+
+float MC11S_BaselineTracker::getTripRatio(void) {
+	return _baseline * (1 - _trip);
+}
+
+float MC11S_BaselineTracker::getReleaseRatio(void) {
+	return _baseline * (1 - _release);
+}
+
+/**
+ * @brief  			Writes TRH/TRL for the trip and release ratios of the current
+ * 					baseline
+ * @retval  		Error code (0 -> no Error, -1 -> no sensor, no baseline yet or
+ * 					a ratio the comparator can't represent)
+ */
+int32_t MC11S_BaselineTracker::program(void) {
+	float trh, trl;
+	int32_t ret;
+
+	if (_sensor == NULL || !_seeded)
+		return -1;
+
+	ret = _sensor->setAlarmRatio(getTripRatio(), getReleaseRatio());
+	ret += mc11s_threshold_from_ratio(getTripRatio(), &trh);
+	ret += mc11s_threshold_from_ratio(getReleaseRatio(), &trl);
+
+	if (ret == 0) {
+		_trh = (int16_t)(trh + 0.5f);
+		_trl = (int16_t)(trl + 0.5f);
+		_programs++;
+	}
+
+	return ret;
+}
+
+uint32_t MC11S_BaselineTracker::getProgramCount(void) {
+	return _programs;
+}
@@ -0,0 +1,90 @@
+/******************************************************************************
+This file defines the baseline tracker for flood detection. A dry probe's
+capacitance wanders with humidity, temperature and dirt, far more than a
+fixed TRH/TRL pair can allow for, so the tracker keeps a reference that
+follows the dry ratio and detects relative to it, the way capacitive touch
+controllers keep their baselines.
+
+The ratio is C_ch0 / C_ch1 (ch1 / ch0 counts), and detection is a drop of
+it, because that is the only direction the chip's comparator alarms in
+(ALERT sets when 0x40 * DATA_D0 / DATA_D1 rises above TRH). Water raises
+the capacitance of a wetted probe, so the probe goes on channel 1 and the
+reference capacitor on channel 0: a flood raises C_ch1 and the ratio
+drops. With the probe on channel 0 a flood would move the ratio away from
+the trip point and never be detected.
+
+    baseline    exponential average of the ratio with a time constant of
+                setAdaptation() samples; frozen while a detection is active
+                or pending, so the water being detected is never learned
+    trip        the ratio has dropped by the trip fraction of the baseline
+                for setDebounce() samples in a row
+    release     it is back within the release fraction
+
+The first sample after reset() seeds the baseline, so the probe should be
+dry then (or setBaseline() given a known dry ratio).
+
+With setFollow() the chip's own comparator is moved along with the
+baseline: every interval samples TRH/TRL are reprogrammed (setAlarmRatio)
+for the current trip and release ratios, so wake-on-alert operation
+(MC11S_WakeOnAlert) follows the drift too. The bus is only touched when a
+threshold code actually changes. TRH/TRL are 8 bit codes of
+0x40 * DATA_D0 / DATA_D1, a step of about 1.6 % of the ratio near 1, so
+hardware thresholds are that much coarser than the software ones.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Baseline_H__
+#define __MC11S_Baseline_H__
+
+#include "MC11S_class.h"
+
+typedef enum {
+	MC11S_BASELINE_CLEAR = 0x0,
+	MC11S_BASELINE_DETECT = 0x1,
+} mc11s_baseline_state_t;
+
+class MC11S_BaselineTracker {
+	public:
+		MC11S_BaselineTracker(void);
+
+		int32_t setThresholds(float trip, float release);	// Fractions of the baseline, release < trip
+		void setAdaptation(uint16_t samples);		// Baseline time constant, default 1024 samples
+		void setDebounce(uint8_t samples);			// Samples past trip to detect, default 2
+		void setFollow(MC11S *sensor, uint16_t interval);	// Reprogram TRH/TRL every interval samples (NULL -> off)
+
+		void reset(void);							// Next sample seeds the baseline
+		void setBaseline(float ratio);
+
+		bool update(uint16_t ch0, uint16_t ch1);	// True when the state changed
+		bool update(float ratio);
+
+		mc11s_baseline_state_t getState(void);
+		bool isDetecting(void);
+		float getBaseline(void);
+		float getRatio(void);						// C_ch0 / C_ch1 of the last sample
+		float getDeviation(void);					// Drop below the baseline, fraction of it
+		float getTripRatio(void);
+		float getReleaseRatio(void);
+
+		int32_t program(void);						// Writes TRH/TRL for the current baseline now
+		uint32_t getProgramCount(void);				// TRH/TRL writes so far
+
+		static float ratioFromCounts(uint16_t ch0, uint16_t ch1);	// C_ch0 / C_ch1, 0 if ch0 is 0
+
+	private:
+		float _trip, _release;
+		float _alpha;
+		uint8_t _debounce, _pending;
+		bool _seeded;
+		float _baseline, _ratio;
+		mc11s_baseline_state_t _state;
+
+		MC11S *_sensor;
+		uint16_t _interval, _sinceProgram;
+		int16_t _trh, _trl;							// Codes last written, -1 -> none
+		uint32_t _programs;
+};
+
+#endif
@@ -0,0 +1,469 @@
+#include "MC11S_Calibration.h"
+#include "MC11S_Crc.h"
+#include "MC11S_Eeprom.h"
+#include <math.h>
+
+#define MC11S_CAL_Q16_MAX		32767.0f
+
+static bool fitsQ16(float val) {
+	return val > -MC11S_CAL_Q16_MAX && val < MC11S_CAL_Q16_MAX;
+}
+
+static int32_t toQ16(float val) {
+	return (int32_t)(val * 65536.0f + (val < 0 ? -0.5f : 0.5f));
+}
+
+static int32_t saturate(int64_t val) {
+	return (val > INT32_MAX) ? INT32_MAX : (val < INT32_MIN) ? INT32_MIN : (int32_t)val;
+}
+
+// Q16.16 multiply with a 64 bit intermediate, saturated
+static int32_t mulQ16(int32_t a, int32_t b) {
+	return saturate(((int64_t)a * b) >> 16);
+}
+
+MC11S_Calibration::MC11S_Calibration(void) :
+	_input{MC11S_CAL_RATIO}, _model{MC11S_CAL_PIECEWISE}, _valid{false}, _points{0},
+	_terms{0}, _offset{0}, _scale{0}, _shift{0}
+{
+}
+
+void MC11S_Calibration::setInput(mc11s_cal_input_t input) {
+	_input = input;
+}
+
+mc11s_cal_input_t MC11S_Calibration::getInput(void) {
+	return _input;
+}
+
+void MC11S_Calibration::clearPoints(void) {
+	_points = 0;
+}
+
+/**
+ * @brief  			Adds a reference point
+ * @param	x		Input at that level (ratio or pF, see setInput())
+ * @param	level	Known level
+ * @retval  		Error code (0 -> no Error, -1 -> full or out of range)
+ */
+int32_t MC11S_Calibration::addPoint(float x, float level) {
+	if (_points >= MC11S_CAL_MAX_POINTS || !fitsQ16(x) || !fitsQ16(level))
+		return -1;
+
+	_px[_points] = x;
+	_py[_points] = level;
+	_points++;
+
+	return 0;
+}
+
+/**
+ * @brief  			Measures the input with single conversions and adds it as a
+ * 					reference point. The probe must be at the known level.
+ * @param	sensor		Device
+ * @param	level		Known level
+ * @param	conversions	Conversions averaged
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_Calibration::addPoint(MC11S *sensor, float level, uint8_t conversions) {
+	mc11s_status_t status;
+	uint32_t sum0 = 0, sum1 = 0;
+	uint16_t ch0, ch1;
+	float c0, c1, x;
+	uint8_t i;
+	int32_t ret;
+
+	if (conversions == 0)
+		conversions = 1;
+
+	for (i = 0; i < conversions; i++) {
+		ret = sensor->singleConversion(&ch0, &ch1, &status);
+		if (ret != 0)
+			return ret;
+		sum0 += ch0;
+		sum1 += ch1;
+	}
+
+	if (sum0 == 0)
+		return -1;
+
+	if (_input == MC11S_CAL_RATIO) {
+		x = (float)sum1 / sum0;
+	} else {
+		ret = sensor->calcCapacitance((uint16_t)((sum0 + conversions / 2) / conversions),
+									  (uint16_t)((sum1 + conversions / 2) / conversions), &c0, &c1);
+		if (ret != 0)
+			return ret;
+		x = c0;
+	}
+
+	return addPoint(x, level);
+}
+
+uint8_t MC11S_Calibration::getPointCount(void) {
+	return _points;
+}
+
+// Slopes between the breakpoints in _bx/_by, Q16.16
+int32_t MC11S_Calibration::setSegments(void) {
+	uint8_t i;
+
+	for (i = 0; i + 1 < _terms; i++) {
+		int64_t dx = (int64_t)_bx[i + 1] - _bx[i];
+		int64_t slope;
+
+		if (dx <= 0)
+			return -1;
+
+		slope = (((int64_t)_by[i + 1] - _by[i]) * 65536) / dx;
+		if (slope >= INT32_MAX || slope <= INT32_MIN)
+			return -1;
+		_slope[i] = (int32_t)slope;
+	}
+
+	// Beyond the last point the last segment continues
+	_slope[_terms - 1] = (_terms > 1) ? _slope[_terms - 2] : 0;
+
+	return 0;
+}
+
+/**
+ * @brief  			Fits straight lines through the reference points
+ * @retval  		Error code (0 -> no Error, -1 -> fewer than two points, two
+ * 					points at the same input or a slope out of range)
+ */
+int32_t MC11S_Calibration::fitPiecewise(void) {
+	uint8_t i, j;
+
+	_valid = false;
+	if (_points < 2)
+		return -1;
+
+	// Insertion sort by input, the points stay in the order they were added
+	for (i = 0; i < _points; i++) {
+		int32_t x = toQ16(_px[i]), y = toQ16(_py[i]);
+
+		for (j = i; j > 0 && _bx[j - 1] > x; j--) {
+			_bx[j] = _bx[j - 1];
+			_by[j] = _by[j - 1];
+		}
+		_bx[j] = x;
+		_by[j] = y;
+	}
+
+	_terms = _points;
+	_model = MC11S_CAL_PIECEWISE;
+	if (setSegments() != 0)
+		return -1;
+
+	_valid = true;
+	return 0;
+}
+
+/**
+ * @brief  			Least-squares polynomial through the reference points
+ * @param	degree		1 to 3
+ * @param	rmsError	Residual over the points, of the fixed-point curve (optional)
+ * @retval  		Error code (0 -> no Error, -1 -> too few distinct points or
+ * 					coefficients out of range)
+ */
+int32_t MC11S_Calibration::fitPolynomial(uint8_t degree, float *rmsError) {
+	float a[MC11S_CAL_MAX_DEGREE + 1][MC11S_CAL_MAX_DEGREE + 2];
+	float xMin, xMax, scale, c[MC11S_CAL_MAX_DEGREE + 1];
+	uint8_t n = degree + 1, i, j, k;
+
+	_valid = false;
+	if (degree < 1 || degree > MC11S_CAL_MAX_DEGREE || _points < n)
+		return -1;
+
+	xMin = xMax = _px[0];
+	for (i = 1; i < _points; i++) {
+		if (_px[i] < xMin)
+			xMin = _px[i];
+		if (_px[i] > xMax)
+			xMax = _px[i];
+	}
+	if (xMax <= xMin)
+		return -1;
+
+	// u = (x - offset) * scale spans -1..1 over the points
+	_offset = toQ16((xMin + xMax) / 2);
+	scale = 2.0f / (xMax - xMin);
+	for (_shift = 0; _shift < 46 && scale * (float)(1ULL << (_shift + 1)) < 1073741824.0f; _shift++)
+		;
+	_scale = (int32_t)(scale * (float)(1ULL << _shift) + 0.5f);
+
+	// Normal equations: sum(u^(i+j)) c = sum(u^i y)
+	for (i = 0; i < n; i++)
+		for (j = 0; j <= n; j++)
+			a[i][j] = 0;
+
+	for (k = 0; k < _points; k++) {
+		float u = normalise(toQ16(_px[k])) / 65536.0f, ui = 1;
+
+		for (i = 0; i < n; i++) {
+			float uij = ui;
+
+			for (j = 0; j < n; j++) {
+				a[i][j] += uij;
+				uij *= u;
+			}
+			a[i][n] += ui * _py[k];
+			ui *= u;
+		}
+	}
+
+	// Gaussian elimination with partial pivoting
+	for (i = 0; i < n; i++) {
+		uint8_t pivot = i;
+
+		for (k = i + 1; k < n; k++)
+			if (fabsf(a[k][i]) > fabsf(a[pivot][i]))
+				pivot = k;
+		if (fabsf(a[pivot][i]) < 1e-12f)
+			return -1;
+
+		if (pivot != i) {
+			for (j = 0; j <= n; j++) {
+				float t = a[i][j];
+				a[i][j] = a[pivot][j];
+				a[pivot][j] = t;
+			}
+		}
+
+		for (k = i + 1; k < n; k++) {
+			float f = a[k][i] / a[i][i];
+
+			for (j = i; j <= n; j++)
+				a[k][j] -= f * a[i][j];
+		}
+	}
+
+	for (i = n; i-- > 0;) {
+		float sum = a[i][n];
+
+		for (j = i + 1; j < n; j++)
+			sum -= a[i][j] * c[j];
+		c[i] = sum / a[i][i];
+	}
+
+	for (i = 0; i < n; i++) {
+		if (!fitsQ16(c[i]))
+			return -1;
+		_by[i] = toQ16(c[i]);
+	}
+
+	_terms = n;
+	_model = MC11S_CAL_POLYNOMIAL;
+	_valid = true;
+
+	if (rmsError) {
+		float sum = 0;
+
+		for (k = 0; k < _points; k++) {
+			float e = evaluate(_px[k]) - _py[k];
+			sum += e * e;
+		}
+		*rmsError = sqrtf(sum / _points);
+	}
+
+	return 0;
+}
+
+bool MC11S_Calibration::isValid(void) {
+	return _valid;
+}
+
+mc11s_cal_model_t MC11S_Calibration::getModel(void) {
+	return _model;
+}
+
+int32_t MC11S_Calibration::normalise(int32_t xQ16) {
+	return saturate((((int64_t)xQ16 - _offset) * _scale) >> _shift);
+}
+
+/**
+ * @brief  			Level for an input, all in Q16.16 integer math
+ * @param	xQ16	Input, Q16.16
+ * @retval  		Level, Q16.16 (0 if not fitted)
+ */
+int32_t MC11S_Calibration::evaluateQ16(int32_t xQ16) {
+	int32_t acc, u;
+	uint8_t i;
+
+	if (!_valid)
+		return 0;
+
+	if (_model == MC11S_CAL_POLYNOMIAL) {
+		// Horner: c0 + u * (c1 + u * (c2 + u * c3))
+		u = normalise(xQ16);
+		acc = _by[_terms - 1];
+		for (i = _terms - 1; i-- > 0;)
+			acc = saturate((int64_t)mulQ16(acc, u) + _by[i]);
+		return acc;
+	}
+
+	// Segment that starts at or below x, the first one below the first point
+	for (i = _terms - 1; i > 0 && _bx[i] > xQ16; i--)
+		;
+
+	return saturate((int64_t)_by[i] + (((int64_t)xQ16 - _bx[i]) * _slope[i] >> 16));
+}
+
+/**
+ * @brief  			Level straight from the channel counts (ratio input), without
+ * 					any float math
+ * @param	ch0		Channel0 data
+ * @param	ch1		Channel1 data
+ * @retval  		Level, Q16.16
+ */
+int32_t MC11S_Calibration::evaluateCounts(uint16_t ch0, uint16_t ch1) {
+	uint32_t ratio;
+
+	if (ch0 == 0 || ch1 >= 0x8000UL * ch0)
+		ratio = INT32_MAX;
+	else
+		ratio = ((uint32_t)ch1 << 16) / ch0;
+
+	return evaluateQ16((int32_t)ratio);
+}
+
+float MC11S_Calibration::evaluate(float x) {
+	return evaluateQ16(fitsQ16(x) ? toQ16(x) : (x > 0 ? INT32_MAX : INT32_MIN)) / 65536.0f;
+}
+
+static void putLe32(uint8_t *p, int32_t val) {
+	p[0] = (uint8_t)val;
+	p[1] = (uint8_t)(val >> 8);
+	p[2] = (uint8_t)(val >> 16);
+	p[3] = (uint8_t)(val >> 24);
+}
+
+static int32_t getLe32(const uint8_t *p) {
+	return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/**
+ * @brief  			Writes the fitted curve as an image:
+ * 					'M' 'C' version model input terms shift, offset, scale (int32),
+ * 					polynomial: terms coefficients; piecewise: terms (x, y) pairs,
+ * 					then the CRC-16 of all of it, little-endian throughout
+ * @param	buf		Destination, MC11S_CAL_IMAGE_MAX bytes is always enough
+ * @param	len		Size of buf
+ * @retval  		Bytes written, -1 if not fitted or buf too small
+ */
+int32_t MC11S_Calibration::pack(uint8_t *buf, uint16_t len) {
+	uint16_t size, pos, crc;
+	uint8_t i;
+
+	if (!_valid)
+		return -1;
+
+	size = 15 + _terms * (_model == MC11S_CAL_PIECEWISE ? 8 : 4) + 2;
+	if (len < size)
+		return -1;
+
+	buf[0] = 'M';
+	buf[1] = 'C';
+	buf[2] = MC11S_CAL_VERSION;
+	buf[3] = (uint8_t)_model;
+	buf[4] = (uint8_t)_input;
+	buf[5] = _terms;
+	buf[6] = _shift;
+	putLe32(&buf[7], _offset);
+	putLe32(&buf[11], _scale);
+
+	pos = 15;
+	for (i = 0; i < _terms; i++) {
+		if (_model == MC11S_CAL_PIECEWISE) {
+			putLe32(&buf[pos], _bx[i]);
+			pos += 4;
+		}
+		putLe32(&buf[pos], _by[i]);
+		pos += 4;
+	}
+
+	crc = mc11s_crc16(buf, pos);
+	buf[pos++] = (uint8_t)crc;
+	buf[pos++] = (uint8_t)(crc >> 8);
+
+	return pos;
+}
+
+/**
+ * @brief  			Loads a curve written by pack()
+ * @param	buf		Image
+ * @param	len		Bytes available in buf (may be more than the image)
+ * @retval  		Error code (0 -> loaded, -1 -> wrong format or version, bad CRC)
+ */
+int32_t MC11S_Calibration::unpack(const uint8_t *buf, uint16_t len) {
+	uint16_t size, pos;
+	uint8_t i, terms;
+
+	_valid = false;
+
+	if (len < 17 || buf[0] != 'M' || buf[1] != 'C' || buf[2] != MC11S_CAL_VERSION)
+		return -1;
+
+	terms = buf[5];
+	if (buf[3] > MC11S_CAL_POLYNOMIAL || buf[4] > MC11S_CAL_CAPACITANCE || terms == 0 ||
+		terms > (buf[3] == MC11S_CAL_PIECEWISE ? MC11S_CAL_MAX_POINTS : MC11S_CAL_MAX_DEGREE + 1))
+		return -1;
+
+	size = 15 + terms * (buf[3] == MC11S_CAL_PIECEWISE ? 8 : 4);
+	if (len < size + 2 || mc11s_crc16(buf, size) != (uint16_t)(buf[size] | (buf[size + 1] << 8)))
+		return -1;
+
+	_model = (mc11s_cal_model_t)buf[3];
+	_input = (mc11s_cal_input_t)buf[4];
+	_terms = terms;
+	_shift = buf[6];
+	_offset = getLe32(&buf[7]);
+	_scale = getLe32(&buf[11]);
+
+	pos = 15;
+	for (i = 0; i < _terms; i++) {
+		if (_model == MC11S_CAL_PIECEWISE) {
+			_bx[i] = getLe32(&buf[pos]);
+			pos += 4;
+		}
+		_by[i] = getLe32(&buf[pos]);
+		pos += 4;
+	}
+
+	if (_model == MC11S_CAL_PIECEWISE && setSegments() != 0)
+		return -1;
+
+	_valid = true;
+	return 0;
+}
+
+/**
+ * @brief  			Stores the fitted curve in EEPROM (only changed bytes are written)
+ * @param	address	First EEPROM byte, MC11S_CAL_IMAGE_MAX bytes are reserved from it
+ * @retval  		Error code (0 -> no Error, -1 -> not fitted, no room or no EEPROM)
+ */
+int32_t MC11S_Calibration::save(int address) {
+	uint8_t buf[MC11S_CAL_IMAGE_MAX];
+	int32_t len = pack(buf, sizeof(buf));
+
+	if (len < 0)
+		return -1;
+
+	return mc11s_eeprom_write(address, buf, (uint16_t)len);
+}
+
+/**
+ * @brief  			Loads a curve stored by save()
+ * @param	address	First EEPROM byte
+ * @retval  		Error code (0 -> loaded, -1 -> none stored, corrupt or no EEPROM)
+ */
+int32_t MC11S_Calibration::load(int address) {
+	uint8_t buf[MC11S_CAL_IMAGE_MAX];
+	int32_t len = mc11s_eeprom_read(address, buf, sizeof(buf));
+
+	if (len < 0)
+		return -1;
+
+	return unpack(buf, (uint16_t)len);
+}
@@ -0,0 +1,109 @@
+/******************************************************************************
+This file defines the level calibration: the curve from what the MC11S
+measures (the channel count ratio or a capacitance) to a level in the units
+the application wants (mm, litres, percent). It replaces the conversion
+constants every deployment used to hard-code in its sketch.
+
+Reference points are collected on site, a known level against the measured
+input, either typed in with addPoint(x, level) or measured with
+addPoint(sensor, level). Two models are fitted on the device:
+
+    piecewise   straight lines through the points, sorted by input, and
+                continued beyond the first and last point
+    polynomial  degree 1 to 3 least-squares fit over the points (normal
+                equations, Gaussian elimination with partial pivoting), in
+                the input normalised to -1..1 across the points so the fit
+                stays well conditioned in float
+
+The result is held in Q16.16 fixed point and evaluated without floats:
+Horner's rule for the polynomial, one multiply per segment for the lines,
+and evaluateCounts() forms the ratio from the raw counts with one integer
+division. Levels and coefficients must fit in +/-32767 units; the fit
+fails otherwise.
+
+    ratio        ch1 / ch0 counts, which grows with Csensor / Cref
+
+pack()/unpack() turn the fitted curve into a small versioned image with a
+CRC-16 (MC11S_Crc.h) and back; on AVR boards save()/load() keep it in
+EEPROM. On other boards they return -1 (MC11S_Eeprom.h), and the image from
+pack() goes wherever the board keeps its data. A corrupt or older image is
+refused and the curve left invalid.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Calibration_H__
+#define __MC11S_Calibration_H__
+
+#include "MC11S_class.h"
+
+#ifndef MC11S_CAL_MAX_POINTS
+#define MC11S_CAL_MAX_POINTS		10
+#endif
+
+#define MC11S_CAL_MAX_DEGREE		3
+#define MC11S_CAL_VERSION			1
+
+// Largest image pack() writes: header, offset and scale, MC11S_CAL_MAX_POINTS pairs, CRC
+#define MC11S_CAL_IMAGE_MAX			(15 + 8 * MC11S_CAL_MAX_POINTS + 2)
+
+typedef enum {
+	MC11S_CAL_PIECEWISE = 0,
+	MC11S_CAL_POLYNOMIAL = 1,
+} mc11s_cal_model_t;
+
+typedef enum {
+	MC11S_CAL_RATIO = 0,			// ch1 / ch0 counts
+	MC11S_CAL_CAPACITANCE = 1,		// Channel 0 capacitance, pF
+} mc11s_cal_input_t;
+
+class MC11S_Calibration {
+	public:
+		MC11S_Calibration(void);
+
+		void setInput(mc11s_cal_input_t input);
+		mc11s_cal_input_t getInput(void);
+
+		void clearPoints(void);
+		int32_t addPoint(float x, float level);
+		int32_t addPoint(MC11S *sensor, float level, uint8_t conversions = 8);	// Measures x with single conversions
+		uint8_t getPointCount(void);
+
+		int32_t fitPiecewise(void);
+		int32_t fitPolynomial(uint8_t degree, float *rmsError = NULL);	// rmsError: residual over the points
+		bool isValid(void);
+		mc11s_cal_model_t getModel(void);
+
+		int32_t evaluateQ16(int32_t xQ16);				// Level, Q16.16
+		int32_t evaluateCounts(uint16_t ch0, uint16_t ch1);	// Level, Q16.16, ratio input only
+		float evaluate(float x);
+
+		int32_t pack(uint8_t *buf, uint16_t len);		// Bytes written, -1 if not fitted or too small
+		int32_t unpack(const uint8_t *buf, uint16_t len);	// 0 -> loaded, -1 -> bad image
+		int32_t save(int address);						// EEPROM on AVR (MC11S_Eeprom.h), -1 elsewhere
+		int32_t load(int address);
+
+	private:
+		int32_t normalise(int32_t xQ16);
+		int32_t setSegments(void);
+
+		mc11s_cal_input_t _input;
+		mc11s_cal_model_t _model;
+		bool _valid;
+
+		float _px[MC11S_CAL_MAX_POINTS];		// Reference points
+		float _py[MC11S_CAL_MAX_POINTS];
+		uint8_t _points;
+
+		// Fitted curve: breakpoints (x, y, slope to the next) or polynomial in u
+		int32_t _bx[MC11S_CAL_MAX_POINTS];
+		int32_t _by[MC11S_CAL_MAX_POINTS];
+		int32_t _slope[MC11S_CAL_MAX_POINTS];
+		uint8_t _terms;							// Breakpoints, or coefficients in _by
+		int32_t _offset;						// u = (x - offset) * scale >> shift, Q16.16
+		int32_t _scale;
+		uint8_t _shift;
+};
+
+#endif
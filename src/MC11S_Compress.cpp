@@ -0,0 +1,338 @@
+#include "MC11S_Compress.h"
+#include "MC11S_Crc.h"
+#include <string.h>
+
+#define MC11S_LOG_SEQ_BITS		16
+
+static uint8_t mc11s_log_status(const mc11s_status_t &status) {
+	uint8_t raw;
+
+	memcpy(&raw, &status, 1);
+	return raw;
+}
+
+static void mc11s_log_put16(uint8_t *p, uint16_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t mc11s_log_get16(const uint8_t *p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t mc11s_log_get32(const uint8_t *p) {
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t mc11s_log_zigzag(int32_t v) {
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t mc11s_log_unzigzag(uint32_t u) {
+	return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+MC11S_LogEncoder::MC11S_LogEncoder(void) :
+	_block{NULL}, _size{0}, _bitPos{0}, _count{0}, _full{true}, _prevStep{0}
+{
+	memset(&_prev, 0, sizeof(_prev));
+}
+
+/**
+ * @brief  			Starts a new, empty block
+ * @param	block	Buffer for the block, cleared here
+ * @param	size	Its size; at least MC11S_LOG_MIN_BLOCK, flash page sized is typical
+ */
+void MC11S_LogEncoder::begin(uint8_t *block, uint16_t size) {
+	_block = block;
+	_size = size;
+	_bitPos = (uint32_t)MC11S_LOG_HEADER_LEN * 8;
+	_count = 0;
+	_full = (block == NULL || size < MC11S_LOG_MIN_BLOCK);
+	_prevStep = 0;
+
+	if (!_full)
+		memset(block, 0, size);
+}
+
+// Appends the low bits of value, MSB first; false when they don't fit before the CRC
+bool MC11S_LogEncoder::putBits(uint32_t value, uint8_t bits) {
+	if (_bitPos + bits > (uint32_t)(_size - 2) * 8)
+		return false;
+
+	while (bits--) {
+		if ((value >> bits) & 1)
+			_block[_bitPos >> 3] |= 0x80 >> (_bitPos & 7);
+		_bitPos++;
+	}
+
+	return true;
+}
+
+// 4 bit groups, low group first, each behind a continuation bit
+bool MC11S_LogEncoder::putVarint(uint32_t value) {
+	do {
+		uint8_t group = value & 0x0F;
+
+		value >>= 4;
+		if (!putBits((value ? 0x10 : 0) | group, 5))
+			return false;
+	} while (value);
+
+	return true;
+}
+
+/**
+ * @brief  			Appends a sample to the block
+ * @param	sample	Next sample
+ * @retval  		true when stored; false when it doesn't fit or seq jumps too far
+ * 					(the block is unchanged then, and takes no more samples)
+ */
+bool MC11S_LogEncoder::add(const mc11s_sample_t &sample) {
+	uint32_t start = _bitPos, seqStep;
+	int32_t step, dod;
+	uint8_t status = mc11s_log_status(sample.status);
+	bool ok;
+
+	if (_full)
+		return false;
+
+	if (_count == 0) {
+		for (uint8_t i = 0; i < 4; i++) {
+			_block[4 + i] = (uint8_t)(sample.seq >> (8 * i));
+			_block[8 + i] = (uint8_t)(sample.timestamp >> (8 * i));
+		}
+		mc11s_log_put16(&_block[12], sample.ch0);
+		mc11s_log_put16(&_block[14], sample.ch1);
+		_block[16] = status;
+
+		_prev = sample;
+		_prevStep = 0;
+		_count = 1;
+		return true;
+	}
+
+	seqStep = sample.seq - _prev.seq;
+	step = (int32_t)(sample.timestamp - _prev.timestamp);
+	dod = (int32_t)((uint32_t)step - (uint32_t)_prevStep);
+
+	if (seqStep == 0 || seqStep > (1UL << MC11S_LOG_SEQ_BITS)) {
+		_full = true;
+		return false;
+	}
+
+	ok = (seqStep == 1) ? putBits(0, 1) : putBits(1, 1) && putBits(seqStep - 1, MC11S_LOG_SEQ_BITS);
+
+	if (ok)
+		ok = (status == mc11s_log_status(_prev.status)) ? putBits(0, 1) : putBits(1, 1) && putBits(status, 8);
+
+	if (ok) {
+		if (dod == 0)
+			ok = putBits(0x0, 1);
+		else if (dod >= -64 && dod <= 63)
+			ok = putBits(0x2, 2) && putBits((uint32_t)dod, 7);
+		else if (dod >= -256 && dod <= 255)
+			ok = putBits(0x6, 3) && putBits((uint32_t)dod, 9);
+		else if (dod >= -2048 && dod <= 2047)
+			ok = putBits(0xE, 4) && putBits((uint32_t)dod, 12);
+		else
+			ok = putBits(0xF, 4) && putBits((uint32_t)dod, 32);
+	}
+
+	if (ok)
+		ok = putVarint(mc11s_log_zigzag((int32_t)sample.ch0 - _prev.ch0)) &&
+			 putVarint(mc11s_log_zigzag((int32_t)sample.ch1 - _prev.ch1));
+
+	if (!ok) {
+		// Take back the bits of the partial sample
+		while (_bitPos > start) {
+			_bitPos--;
+			_block[_bitPos >> 3] &= ~(0x80 >> (_bitPos & 7));
+		}
+		_full = true;
+		return false;
+	}
+
+	_prev = sample;
+	_prevStep = step;
+	_count++;
+	return true;
+}
+
+/**
+ * @brief  			Completes the block: length, count and CRC
+ * @retval  		Bytes used, to be stored (0 -> no block or no samples)
+ */
+uint16_t MC11S_LogEncoder::finish(void) {
+	uint16_t len = getLength();
+
+	if (_block == NULL || _count == 0)
+		return 0;
+
+	mc11s_log_put16(&_block[0], len);
+	mc11s_log_put16(&_block[2], _count);
+	mc11s_log_put16(&_block[len - 2], mc11s_crc16(_block, len - 2));
+	_full = true;
+
+	return len;
+}
+
+uint16_t MC11S_LogEncoder::getCount(void) {
+	return _count;
+}
+
+uint16_t MC11S_LogEncoder::getLength(void) {
+	return (uint16_t)((_bitPos + 7) / 8 + 2);
+}
+
+MC11S_LogDecoder::MC11S_LogDecoder(void) :
+	_block{NULL}, _length{0}, _count{0}, _read{0}, _bitPos{0}, _bitEnd{0}, _prevStep{0}
+{
+	memset(&_prev, 0, sizeof(_prev));
+}
+
+/**
+ * @brief  			Checks a block and rewinds to its first sample
+ * @param	block	Block as written by MC11S_LogEncoder::finish()
+ * @param	size	Bytes available at block (e.g. the page size)
+ * @retval  		Error code (0 -> no Error, -1 -> not a valid block)
+ */
+int32_t MC11S_LogDecoder::begin(const uint8_t *block, uint16_t size) {
+	uint16_t len;
+
+	_block = NULL;
+	_count = 0;
+	_read = 0;
+
+	if (block == NULL || size < MC11S_LOG_MIN_BLOCK)
+		return -1;
+
+	len = mc11s_log_get16(&block[0]);
+	if (len < MC11S_LOG_MIN_BLOCK || len > size || mc11s_log_get16(&block[2]) == 0 ||
+		mc11s_crc16(block, len - 2) != mc11s_log_get16(&block[len - 2]))
+		return -1;
+
+	_block = block;
+	_length = len;
+	_count = mc11s_log_get16(&block[2]);
+	_bitPos = (uint32_t)MC11S_LOG_HEADER_LEN * 8;
+	_bitEnd = (uint32_t)(len - 2) * 8;
+
+	return 0;
+}
+
+bool MC11S_LogDecoder::getBits(uint8_t bits, uint32_t *value) {
+	if (_bitPos + bits > _bitEnd)
+		return false;
+
+	*value = 0;
+	while (bits--) {
+		*value = (*value << 1) | ((_block[_bitPos >> 3] >> (7 - (_bitPos & 7))) & 1);
+		_bitPos++;
+	}
+
+	return true;
+}
+
+bool MC11S_LogDecoder::getVarint(uint32_t *value) {
+	uint32_t group;
+	uint8_t shift = 0;
+
+	*value = 0;
+	do {
+		if (shift > 28 || !getBits(5, &group))
+			return false;
+		*value |= (group & 0x0F) << shift;
+		shift += 4;
+	} while (group & 0x10);
+
+	return true;
+}
+
+/**
+ * @brief  			Reads the next sample of the block
+ * @param	sample	Next sample
+ * @retval  		true when there was one; false at the end of the block, or
+ * 					when the bit stream is damaged
+ */
+bool MC11S_LogDecoder::next(mc11s_sample_t *sample) {
+	static const uint8_t widths[5] = { 0, 7, 9, 12, 32 };
+	mc11s_sample_t s;
+	uint32_t v, prefix = 0;
+	int32_t dod;
+	uint8_t width, status, i;
+
+	if (_block == NULL || _read >= _count)
+		return false;
+
+	if (_read == 0) {
+		memset(&s, 0, sizeof(s));
+		s.seq = mc11s_log_get32(&_block[4]);
+		s.timestamp = mc11s_log_get32(&_block[8]);
+		s.ch0 = mc11s_log_get16(&_block[12]);
+		s.ch1 = mc11s_log_get16(&_block[14]);
+		memcpy(&s.status, &_block[16], 1);
+		_prevStep = 0;
+	} else {
+		s = _prev;
+
+		if (!getBits(1, &v))
+			return false;
+		if (v == 0) {
+			s.seq++;
+		} else {
+			if (!getBits(MC11S_LOG_SEQ_BITS, &v))
+				return false;
+			s.seq += v + 1;
+		}
+
+		if (!getBits(1, &v))
+			return false;
+		if (v != 0) {
+			if (!getBits(8, &v))
+				return false;
+			status = (uint8_t)v;
+			memcpy(&s.status, &status, 1);
+		}
+
+		// Count the 1s of the prefix, up to four
+		for (i = 0; i < 4; i++) {
+			if (!getBits(1, &v))
+				return false;
+			if (v == 0)
+				break;
+			prefix++;
+		}
+
+		width = widths[prefix];
+		dod = 0;
+		if (width != 0) {
+			if (!getBits(width, &v))
+				return false;
+			// Sign extend
+			dod = (width == 32) ? (int32_t)v : (int32_t)(v << (32 - width)) >> (32 - width);
+		}
+		_prevStep = (int32_t)((uint32_t)_prevStep + (uint32_t)dod);
+		s.timestamp += (uint32_t)_prevStep;
+
+		if (!getVarint(&v))
+			return false;
+		s.ch0 = (uint16_t)(s.ch0 + mc11s_log_unzigzag(v));
+		if (!getVarint(&v))
+			return false;
+		s.ch1 = (uint16_t)(s.ch1 + mc11s_log_unzigzag(v));
+	}
+
+	_prev = s;
+	_read++;
+	*sample = s;
+	return true;
+}
+
+uint16_t MC11S_LogDecoder::getCount(void) {
+	return _count;
+}
+
+uint16_t MC11S_LogDecoder::getLength(void) {
+	return _length;
+}
@@ -0,0 +1,93 @@
+/******************************************************************************
+This file defines the sample log compressor: local history kept on a node
+while its uplink is down, packed so that flash lasts many times longer than
+with raw samples. MC11S_LogEncoder fills a block the caller provides (a
+flash page, an EEPROM area, an SD sector); MC11S_LogDecoder reads one back
+a sample at a time.
+
+Each block stands on its own. It starts with its first sample in full and
+is followed by a bit stream in the manner of Gorilla (Facebook's in-memory
+time series store), one entry per sample:
+
+    seq         '0' for the next conversion, '1' + 16 bits (step - 1)
+                after missed ones
+    status      '0' unchanged, '1' + 8 bits
+    timestamp   delta of delta: the step minus the previous step, in us
+                  '0'                          0
+                  '10'   + 7 bits              -64 .. 63
+                  '110'  + 9 bits              -256 .. 255
+                  '1110' + 12 bits             -2048 .. 2047
+                  '1111' + 32 bits             anything else
+    ch0, ch1    zigzag of the step from the previous count, as a varint of
+                4 bit groups each behind a continuation bit
+
+so a steady stream costs a bit or two for seq and status, a few bits for
+the timestamp jitter and 5-10 bits per channel for the noise. Block layout,
+little-endian:
+
+    u16 length, u16 count, u32 seq, u32 timestamp, u16 ch0, u16 ch1,
+    u8 status, bit stream (MSB first), u16 CRC-16/CCITT-FALSE of all of it
+
+add() returns false when the sample doesn't fit (or seq jumps by more than
+16 bits can say); finish() the block, store it and start the next one with
+that sample. The working set is the block and a few words of state on
+either side, whatever the length of the log.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Compress_H__
+#define __MC11S_Compress_H__
+
+#include "MC11S_Sampler.h"
+
+#define MC11S_LOG_HEADER_LEN		17
+#define MC11S_LOG_MIN_BLOCK			(MC11S_LOG_HEADER_LEN + 2)
+
+class MC11S_LogEncoder {
+	public:
+		MC11S_LogEncoder(void);
+
+		void begin(uint8_t *block, uint16_t size);	// Starts an empty block (size >= MC11S_LOG_MIN_BLOCK)
+		bool add(const mc11s_sample_t &sample);		// false -> block full, finish() and begin() another
+		uint16_t finish(void);						// Writes length, count and CRC, returns the length
+
+		uint16_t getCount(void);					// Samples in the block
+		uint16_t getLength(void);					// Bytes the block takes when finished now
+
+	private:
+		bool putBits(uint32_t value, uint8_t bits);
+		bool putVarint(uint32_t value);
+
+		uint8_t *_block;
+		uint16_t _size;
+		uint32_t _bitPos;
+		uint16_t _count;
+		bool _full;
+		mc11s_sample_t _prev;
+		int32_t _prevStep;
+};
+
+class MC11S_LogDecoder {
+	public:
+		MC11S_LogDecoder(void);
+
+		int32_t begin(const uint8_t *block, uint16_t size);	// Checks the block, size may be larger than it
+		bool next(mc11s_sample_t *sample);					// false -> no more samples in the block
+
+		uint16_t getCount(void);
+		uint16_t getLength(void);
+
+	private:
+		bool getBits(uint8_t bits, uint32_t *value);
+		bool getVarint(uint32_t *value);
+
+		const uint8_t *_block;
+		uint16_t _length, _count, _read;
+		uint32_t _bitPos, _bitEnd;
+		mc11s_sample_t _prev;
+		int32_t _prevStep;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "MC11S_Crc.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define MC11S_CRC_TABLE(i)		pgm_read_word(&mc11s_crc16_table[i])
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#define MC11S_CRC_TABLE(i)		mc11s_crc16_table[i]
+#endif
+
+static const uint16_t mc11s_crc16_table[16] PROGMEM = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/**
+ * @brief  			CRC-16/CCITT-FALSE of a block, a nibble at a time
+ * @param	data	Bytes
+ * @param	len		Number of bytes
+ * @param	crc		MC11S_CRC16_INIT, or the result over the blocks before
+ * @retval  		CRC
+ */
+uint16_t mc11s_crc16(const uint8_t *data, size_t len, uint16_t crc) {
+	while (len--) {
+		uint8_t b = *data++;
+
+		crc = (uint16_t)((crc << 4) ^ MC11S_CRC_TABLE((crc >> 12) ^ (b >> 4)));
+		crc = (uint16_t)((crc << 4) ^ MC11S_CRC_TABLE((crc >> 12) ^ (b & 0x0F)));
+	}
+
+	return crc;
+}
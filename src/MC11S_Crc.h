@@ -0,0 +1,26 @@
+/******************************************************************************
+This file defines the CRC used wherever the library stores or sends a block
+of bytes (calibration images, serialized samples, streams): CRC-16/CCITT-FALSE,
+polynomial 0x1021, initial value 0xFFFF, no reflection, no final XOR. The
+check value of "123456789" is 0x29B1.
+
+It runs a nibble at a time from a 16 entry table, which is a good trade
+between speed and size on AVR. The table is defined once (MC11S_Crc.cpp)
+and kept in flash with PROGMEM on AVR, so it costs 32 bytes of flash and no
+RAM. Pass the previous result as crc to continue over several buffers.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Crc_H__
+#define __MC11S_Crc_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MC11S_CRC16_INIT		0xFFFF
+
+uint16_t mc11s_crc16(const uint8_t *data, size_t len, uint16_t crc = MC11S_CRC16_INIT);
+
+#endif
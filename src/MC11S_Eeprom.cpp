@@ -0,0 +1,59 @@
+#include "MC11S_Eeprom.h"
+
+#if MC11S_HAS_EEPROM
+#include <EEPROM.h>
+#endif
+
+/**
+ * @brief  			Writes a block to EEPROM, only the bytes that changed
+ * @param	address	First EEPROM byte
+ * @param	buf		Data
+ * @param	len		Bytes
+ * @retval  		Error code (0 -> no Error, -1 -> doesn't fit or no EEPROM)
+ */
+int32_t mc11s_eeprom_write(int address, const uint8_t *buf, uint16_t len) {
+#if MC11S_HAS_EEPROM
+	uint16_t i;
+
+	if (address < 0 || (uint32_t)address + len > EEPROM.length())
+		return -1;
+
+	for (i = 0; i < len; i++)
+		EEPROM.update(address + i, buf[i]);
+
+	return 0;
+#else
+	(void)address;
+	(void)buf;
+	(void)len;
+	return -1;
+#endif
+}
+
+/**
+ * @brief  			Reads a block from EEPROM, up to its end
+ * @param	address	First EEPROM byte
+ * @param	buf		Data
+ * @param	len		Bytes wanted
+ * @retval  		Bytes read (-1 -> address outside or no EEPROM)
+ */
+int32_t mc11s_eeprom_read(int address, uint8_t *buf, uint16_t len) {
+#if MC11S_HAS_EEPROM
+	uint16_t i;
+
+	if (address < 0 || (uint32_t)address >= EEPROM.length())
+		return -1;
+	if ((uint32_t)address + len > EEPROM.length())
+		len = EEPROM.length() - address;
+
+	for (i = 0; i < len; i++)
+		buf[i] = EEPROM.read(address + i);
+
+	return len;
+#else
+	(void)address;
+	(void)buf;
+	(void)len;
+	return -1;
+#endif
+}
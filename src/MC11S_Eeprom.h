@@ -0,0 +1,30 @@
+/******************************************************************************
+This file defines the byte store behind the save()/load() of the calibration
+and tank geometry images: the EEPROM library of the AVR cores (Uno, Mega,
+Nano Every), written with EEPROM.update() so unchanged bytes cost no wear.
+
+Other cores either have no EEPROM library (SAMD, RP2040, most ARM) or one
+without update() that needs a commit() (ESP8266, ESP32), so there
+MC11S_HAS_EEPROM is 0 and both calls fail with -1. Keep the image from
+pack() wherever the board stores data instead (flash, a file, a server)
+and give it back to unpack().
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Eeprom_H__
+#define __MC11S_Eeprom_H__
+
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_AVR) || defined(ARDUINO_ARCH_MEGAAVR)
+#define MC11S_HAS_EEPROM		1
+#else
+#define MC11S_HAS_EEPROM		0
+#endif
+
+int32_t mc11s_eeprom_write(int address, const uint8_t *buf, uint16_t len);	// 0 -> written, -1 -> no room or no EEPROM
+int32_t mc11s_eeprom_read(int address, uint8_t *buf, uint16_t len);		// Bytes read, fewer at the end of the EEPROM, -1 -> none
+
+#endif
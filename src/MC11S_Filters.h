@@ -0,0 +1,428 @@
+/******************************************************************************
+This file defines the streaming filter stages used to smooth the raw MC11S
+channel counts before they are turned into capacitance.
+
+Every stage is a small class template on the sample type (and its size where
+it needs history). None of them allocate: all state lives inside the object,
+so a filter can be a global, a member or a local like any other value.
+
+All stages share the same interface:
+
+    bool push(sample_t in, sample_t *out);  // true when *out holds a new output
+    void reset(void);                       // forget all history
+
+Stages are chained at compile time with MC11S_Pipeline, and a pipeline is
+run on both channels with MC11S_DualFilter, e.g.
+
+    MC11S_DualFilter<MC11S_Pipeline<MC11S_Median<uint16_t, 5>,
+                                    MC11S_MovingAverage<uint16_t, 8> > > filter;
+
+    mySensor.getData(&raw0, &raw1);
+    if (filter.push(raw0, raw1, &ch0, &ch1))
+        mySensor.calcCapacitance(ch0, ch1, &Csensor, &Cref);
+
+Development environment specifics:
+    IDE: Arduino 2.1.0
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Filters_H__
+#define __MC11S_Filters_H__
+
+#include <stdint.h>
+
+// Accumulator wide enough to sum a window of samples. Integer samples also get
+// an unsigned accumulator that is allowed to wrap (used by the CIC stage) and
+// one that holds a sample times a 16 bit factor (the Hampel limit).
+template <typename T> struct MC11S_FilterAcc { typedef T type; typedef T wide_t; };
+template <> struct MC11S_FilterAcc<uint8_t>  { typedef uint16_t type; typedef uint16_t wrap_t; typedef uint32_t wide_t; };
+template <> struct MC11S_FilterAcc<int8_t>   { typedef int16_t  type; typedef uint16_t wrap_t; typedef uint32_t wide_t; };
+template <> struct MC11S_FilterAcc<uint16_t> { typedef uint32_t type; typedef uint32_t wrap_t; typedef uint32_t wide_t; };
+template <> struct MC11S_FilterAcc<int16_t>  { typedef int32_t  type; typedef uint32_t wrap_t; typedef uint32_t wide_t; };
+template <> struct MC11S_FilterAcc<uint32_t> { typedef uint64_t type; typedef uint64_t wrap_t; typedef uint64_t wide_t; };
+template <> struct MC11S_FilterAcc<int32_t>  { typedef int64_t  type; typedef uint64_t wrap_t; typedef uint64_t wide_t; };
+
+/**
+ * @brief  Pass-through stage, useful as a placeholder in a pipeline.
+ */
+template <typename T>
+class MC11S_NoFilter {
+	public:
+		typedef T sample_t;
+
+		bool push(T in, T *out) { *out = in; return true; }
+		void reset(void) { }
+};
+
+/**
+ * @brief  Boxcar average over the last N samples. The window sum is kept
+ *         running, so each sample costs one add and one subtract regardless
+ *         of N. Until N samples have been seen the average of what is there
+ *         is returned.
+ */
+template <typename T, uint8_t N>
+class MC11S_MovingAverage {
+		static_assert(N > 0, "MC11S_MovingAverage needs a window of at least one sample");
+	public:
+		typedef T sample_t;
+		typedef typename MC11S_FilterAcc<T>::type acc_t;
+
+		MC11S_MovingAverage(void) { reset(); }
+
+		void reset(void) {
+			for (uint8_t i = 0; i < N; i++)
+				_buf[i] = 0;
+			_sum = 0;
+			_idx = 0;
+			_count = 0;
+		}
+
+		bool push(T in, T *out) {
+			_sum -= _buf[_idx];
+			_sum += in;
+			_buf[_idx] = in;
+			_idx = (_idx + 1 == N) ? 0 : _idx + 1;
+
+			if (_count < N)
+				_count++;
+
+			*out = (T)(_sum / (acc_t)_count);
+			return true;
+		}
+
+	private:
+		T _buf[N];
+		acc_t _sum;
+		uint8_t _idx;
+		uint8_t _count;
+};
+
+/**
+ * @brief  Single pole low-pass y += (x - y) / 2^SHIFT. The state is kept
+ *         scaled by 2^SHIFT so integer samples don't lose the fraction; the
+ *         divide is a shift for unsigned types. The first sample primes it.
+ */
+template <typename T, uint8_t SHIFT>
+class MC11S_ExpIIR {
+		static_assert(SHIFT < 16, "MC11S_ExpIIR shift out of range");
+	public:
+		typedef T sample_t;
+		typedef typename MC11S_FilterAcc<T>::type acc_t;
+
+		MC11S_ExpIIR(void) { reset(); }
+
+		void reset(void) {
+			_state = 0;
+			_primed = false;
+		}
+
+		bool push(T in, T *out) {
+			const acc_t k = (acc_t)(1UL << SHIFT);
+
+			if (!_primed) {
+				_state = (acc_t)in * k;
+				_primed = true;
+			} else {
+				_state = _state - _state / k + (acc_t)in;
+			}
+
+			*out = (T)(_state / k);
+			return true;
+		}
+
+	private:
+		acc_t _state;
+		bool _primed;
+};
+
+/**
+ * @brief  Window of the last N samples kept in arrival order and in sorted
+ *         order side by side, so the median (and any other order statistic)
+ *         is available without sorting: each insert is one removal and one
+ *         insertion into an N element array.
+ */
+template <typename T, uint8_t N>
+class MC11S_SortedWindow {
+	public:
+		MC11S_SortedWindow(void) { reset(); }
+
+		void reset(void) {
+			_idx = 0;
+			_count = 0;
+		}
+
+		void insert(T in) {
+			uint8_t i;
+
+			if (_count == N) {
+				// Drop the oldest sample from the sorted window
+				for (i = 0; i + 1 < _count && _sorted[i] != _ring[_idx]; i++)
+					;
+				for (; i + 1 < _count; i++)
+					_sorted[i] = _sorted[i + 1];
+				_count--;
+			}
+
+			// Insert the new one keeping the window sorted
+			for (i = _count; i > 0 && _sorted[i - 1] > in; i--)
+				_sorted[i] = _sorted[i - 1];
+			_sorted[i] = in;
+			_count++;
+
+			_ring[_idx] = in;
+			_idx = (_idx + 1 == N) ? 0 : _idx + 1;
+		}
+
+		uint8_t count(void) { return _count; }
+		T at(uint8_t rank) { return _sorted[rank]; }
+		T median(void) { return _sorted[_count / 2]; }
+
+		/**
+		 * @brief  Median absolute deviation around m = median(). The deviations
+		 *         of the sorted window grow outwards from the median index, so
+		 *         walking both sides in merge order reaches the middle one in
+		 *         count/2 steps.
+		 */
+		T mad(void) {
+			uint8_t mid = _count / 2;
+			uint8_t lo = mid;			// next candidate below is lo - 1
+			uint8_t hi = mid + 1;		// next candidate above is hi
+			T m = _sorted[mid];
+			T dev = 0;
+
+			for (uint8_t k = 0; k < mid; k++) {
+				if (hi >= _count || (lo > 0 && (T)(m - _sorted[lo - 1]) <= (T)(_sorted[hi] - m))) {
+					lo--;
+					dev = (T)(m - _sorted[lo]);
+				} else {
+					dev = (T)(_sorted[hi] - m);
+					hi++;
+				}
+			}
+
+			return dev;
+		}
+
+	private:
+		T _ring[N];
+		T _sorted[N];
+		uint8_t _idx;
+		uint8_t _count;
+};
+
+/**
+ * @brief  Running median of the last N samples (N odd).
+ */
+template <typename T, uint8_t N>
+class MC11S_Median {
+		static_assert(N % 2 == 1, "MC11S_Median needs an odd window");
+	public:
+		typedef T sample_t;
+
+		void reset(void) { _window.reset(); }
+
+		bool push(T in, T *out) {
+			_window.insert(in);
+			*out = _window.median();
+			return true;
+		}
+
+	private:
+		MC11S_SortedWindow<T, N> _window;
+};
+
+/**
+ * @brief  Hampel outlier rejector. Each sample is compared with the median m
+ *         of the last N samples (itself included); if it lies further than
+ *         k * 1.4826 * MAD from m it is counted as rejected and m is passed on
+ *         in its place, otherwise the sample goes through untouched. Being
+ *         causal it adds no delay to genuine steps once they fill half the
+ *         window, while single sample spikes never get through.
+ *
+ *         setMinDeviation() puts a floor under the MAD, 1 count by default, so
+ *         a one count step on a perfectly flat stretch (MAD 0) isn't treated as
+ *         an outlier.
+ */
+template <typename T, uint8_t N>
+class MC11S_Hampel {
+		static_assert(N % 2 == 1 && N >= 3, "MC11S_Hampel needs an odd window of at least 3");
+	public:
+		typedef T sample_t;
+		typedef typename MC11S_FilterAcc<T>::wide_t wide_t;
+
+		MC11S_Hampel(void) : _sigmas{3}, _minDev{1}, _rejected{0} { }
+
+		void setSigmas(uint8_t k) { _sigmas = k; }				// Threshold in (robust) standard deviations
+		void setMinDeviation(T dev) { _minDev = dev; }			// Floor for the MAD (default 1 count)
+		uint32_t getRejected(void) { return _rejected; }		// Samples replaced since the last reset
+
+		void reset(void) {
+			_window.reset();
+			_rejected = 0;
+		}
+
+		bool push(T in, T *out) {
+			_window.insert(in);
+
+			T m = _window.median();
+			T mad = _window.mad();
+			wide_t dev, limit;
+
+			if (mad < _minDev)
+				mad = _minDev;
+
+			dev = (in > m) ? (wide_t)(in - m) : (wide_t)(m - in);
+			// 1.4826 ~= 95 / 64 scales the MAD to a standard deviation
+			limit = (wide_t)mad * _sigmas * 95 / 64;
+
+			if (_window.count() == N && dev > limit) {
+				_rejected++;
+				*out = m;
+			} else {
+				*out = in;
+			}
+
+			return true;
+		}
+
+	private:
+		MC11S_SortedWindow<T, N> _window;
+		uint8_t _sigmas;
+		T _minDev;
+		uint32_t _rejected;
+};
+
+/**
+ * @brief  Cascaded integrator-comb decimator: M integrator stages at the
+ *         input rate, M combs at 1/R of it, output normalised by the R^M gain.
+ *         Only every R-th push produces an output. Integer samples only; the
+ *         integrators wrap by design, R^M * max|x| has to fit the accumulator.
+ */
+template <typename T, uint8_t R, uint8_t M>
+class MC11S_CIC {
+		static_assert(R > 1 && M > 0, "MC11S_CIC needs R > 1 and at least one stage");
+	public:
+		typedef T sample_t;
+		typedef typename MC11S_FilterAcc<T>::type acc_t;
+		typedef typename MC11S_FilterAcc<T>::wrap_t wrap_t;
+
+		static constexpr wrap_t gain(uint8_t stages = M) {
+			return stages == 0 ? 1 : (wrap_t)R * gain(stages - 1);
+		}
+
+		MC11S_CIC(void) { reset(); }
+
+		void reset(void) {
+			for (uint8_t i = 0; i < M; i++) {
+				_integ[i] = 0;
+				_comb[i] = 0;
+			}
+			_phase = 0;
+		}
+
+		bool push(T in, T *out) {
+			wrap_t v = (wrap_t)(acc_t)in;
+			uint8_t i;
+
+			for (i = 0; i < M; i++) {
+				_integ[i] += v;
+				v = _integ[i];
+			}
+
+			if (++_phase < R)
+				return false;
+			_phase = 0;
+
+			for (i = 0; i < M; i++) {
+				wrap_t prev = _comb[i];
+				_comb[i] = v;
+				v -= prev;
+			}
+
+			*out = (T)((acc_t)v / (acc_t)gain());
+			return true;
+		}
+
+	private:
+		wrap_t _integ[M];
+		wrap_t _comb[M];
+		uint8_t _phase;
+};
+
+/**
+ * @brief  Compile-time chain of stages. Samples run through the stages in
+ *         order; a stage that holds back its output (decimator) stops the
+ *         sample there. All stages must share the same sample type.
+ */
+template <class... Stages>
+class MC11S_Pipeline;
+
+template <class Last>
+class MC11S_Pipeline<Last> {
+	public:
+		typedef typename Last::sample_t sample_t;
+
+		bool push(sample_t in, sample_t *out) { return _stage.push(in, out); }
+		void reset(void) { _stage.reset(); }
+
+		Last &stage(void) { return _stage; }
+
+	private:
+		Last _stage;
+};
+
+template <class First, class Second, class... Rest>
+class MC11S_Pipeline<First, Second, Rest...> {
+	public:
+		typedef typename First::sample_t sample_t;
+
+		bool push(sample_t in, sample_t *out) {
+			sample_t mid;
+
+			if (!_stage.push(in, &mid))
+				return false;
+			return _next.push(mid, out);
+		}
+
+		void reset(void) {
+			_stage.reset();
+			_next.reset();
+		}
+
+		First &stage(void) { return _stage; }
+		MC11S_Pipeline<Second, Rest...> &next(void) { return _next; }
+
+	private:
+		First _stage;
+		MC11S_Pipeline<Second, Rest...> _next;
+};
+
+/**
+ * @brief  Runs one filter (stage or pipeline) per MC11S channel. Both copies
+ *         see the same sample cadence, so they produce outputs together.
+ */
+template <class Filter>
+class MC11S_DualFilter {
+	public:
+		typedef typename Filter::sample_t sample_t;
+
+		bool push(sample_t ch0, sample_t ch1, sample_t *out0, sample_t *out1) {
+			bool ready0 = _ch0.push(ch0, out0);
+			bool ready1 = _ch1.push(ch1, out1);
+
+			return ready0 && ready1;
+		}
+
+		void reset(void) {
+			_ch0.reset();
+			_ch1.reset();
+		}
+
+		Filter &ch0(void) { return _ch0; }
+		Filter &ch1(void) { return _ch1; }
+
+	private:
+		Filter _ch0;
+		Filter _ch1;
+};
+
+#endif
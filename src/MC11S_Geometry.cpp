@@ -0,0 +1,305 @@
+#include "MC11S_Geometry.h"
+#include "MC11S_Crc.h"
+#include "MC11S_Eeprom.h"
+#include <math.h>
+
+#define MC11S_GEOM_PI		3.14159265f
+
+MC11S_TankGeometry::MC11S_TankGeometry(void) :
+	_volumes{NULL}, _points{0}, _heightQ16{0}, _scale{0}, _shift{0}
+{
+}
+
+// Grid of points levels from 0 to height, all but the table itself
+int32_t MC11S_TankGeometry::setGrid(uint8_t points, float height) {
+	float scale;
+
+	_points = 0;
+	if (points < 2 || height <= 0 || height >= 32767.0f)
+		return -1;
+
+	_heightQ16 = (int32_t)(height * 65536.0f + 0.5f);
+
+	// pos (Q16.16 grid steps) = level (Q16.16) * scale >> shift, scale < 2^31
+	scale = (points - 1) / height;
+	for (_shift = 0; _shift < 48 && scale * (float)(1ULL << (_shift + 1)) < 2147483648.0f; _shift++)
+		;
+	_scale = (uint32_t)(scale * (float)(1ULL << _shift) + 0.5f);
+
+	_points = points;
+	return 0;
+}
+
+/**
+ * @brief  			Uses a table the caller keeps, e.g. a const array generated on a
+ * 					host. It is not copied, so it must outlive this object.
+ * @param	volumes	Volume at level 0, height / (points - 1), ... height
+ * @param	points	Entries, at least 2
+ * @param	height	Level of the last entry
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_TankGeometry::setTable(const uint32_t *volumes, uint8_t points, float height) {
+	if (volumes == NULL || setGrid(points, height) != 0)
+		return -1;
+
+	_volumes = volumes;
+	return 0;
+}
+
+/**
+ * @brief  			Upright cylinder, volume = pi * d^2 / 4 * level
+ * @param	diameter	mm
+ * @param	height		mm
+ * @param	points		Table entries
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_TankGeometry::verticalCylinder(float diameter, float height, uint8_t points) {
+	return rectangular(MC11S_GEOM_PI * diameter / 4, diameter, height, points);
+}
+
+/**
+ * @brief  			Cylinder lying on its side, level measured from the bottom:
+ * 					volume = L * (r^2 * acos((r - h) / r) - (r - h) * sqrt(2 * r * h - h^2))
+ * @param	diameter	mm, also the height of the table
+ * @param	length		mm
+ * @param	points		Table entries
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_TankGeometry::horizontalCylinder(float diameter, float length, uint8_t points) {
+	float r = diameter / 2;
+	uint8_t i;
+
+	if (points > MC11S_GEOM_MAX_POINTS || length <= 0 || setGrid(points, diameter) != 0)
+		return -1;
+
+	for (i = 0; i < points; i++) {
+		float h = diameter * i / (points - 1);
+		float c = (r - h) / r;
+		float area = r * r * acosf(c < -1 ? -1 : c > 1 ? 1 : c) - (r - h) * sqrtf(fmaxf(0, 2 * r * h - h * h));
+
+		// mm^3 -> ml
+		_table[i] = (uint32_t)(area * length / 1000 + 0.5f);
+	}
+
+	_volumes = _table;
+	return 0;
+}
+
+/**
+ * @brief  			Box, volume = width * depth * level
+ * @param	width		mm
+ * @param	depth		mm
+ * @param	height		mm
+ * @param	points		Table entries
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_TankGeometry::rectangular(float width, float depth, float height, uint8_t points) {
+	uint8_t i;
+
+	if (points > MC11S_GEOM_MAX_POINTS || width <= 0 || depth <= 0 || setGrid(points, height) != 0)
+		return -1;
+
+	for (i = 0; i < points; i++)
+		_table[i] = (uint32_t)(width * depth * (height * i / (points - 1)) / 1000 + 0.5f);
+
+	_volumes = _table;
+	return 0;
+}
+
+/**
+ * @brief  			Builds the grid from a strapping table: (level, volume) pairs
+ * 					in rising level order at any spacing. The grid runs from 0 to the
+ * 					last level; between pairs volume is interpolated linearly, below
+ * 					the first pair it is the first volume.
+ * @param	levels	Rising levels
+ * @param	volumes	Volume at each level
+ * @param	n		Pairs, at least 2
+ * @param	points	Table entries
+ * @retval  		Error code (0 -> no Error, -1 -> levels not rising)
+ */
+int32_t MC11S_TankGeometry::resample(const float *levels, const float *volumes, uint8_t n, uint8_t points) {
+	uint8_t i, j = 0;
+
+	if (n < 2 || points > MC11S_GEOM_MAX_POINTS)
+		return -1;
+	for (i = 1; i < n; i++)
+		if (levels[i] <= levels[i - 1])
+			return -1;
+	if (setGrid(points, levels[n - 1]) != 0)
+		return -1;
+
+	for (i = 0; i < points; i++) {
+		float h = levels[n - 1] * i / (points - 1);
+		float v;
+
+		while (j + 2 < n && levels[j + 1] < h)
+			j++;
+
+		if (h <= levels[0])
+			v = volumes[0];
+		else
+			v = volumes[j] + (volumes[j + 1] - volumes[j]) * (h - levels[j]) / (levels[j + 1] - levels[j]);
+
+		_table[i] = (v <= 0) ? 0 : (uint32_t)(v + 0.5f);
+	}
+
+	_volumes = _table;
+	return 0;
+}
+
+bool MC11S_TankGeometry::isValid(void) {
+	return _volumes != NULL && _points >= 2;
+}
+
+uint8_t MC11S_TankGeometry::getPointCount(void) {
+	return _points;
+}
+
+float MC11S_TankGeometry::getHeight(void) {
+	return _heightQ16 / 65536.0f;
+}
+
+uint32_t MC11S_TankGeometry::getCapacity(void) {
+	return isValid() ? _volumes[_points - 1] : 0;
+}
+
+/**
+ * @brief  			Volume at a level, integer math only: one multiply finds the
+ * 					cell, one interpolates in it
+ * @param	levelQ16	Level, Q16.16 (e.g. from MC11S_Calibration)
+ * @retval  		Volume in table units (0 if there is no table)
+ */
+uint32_t MC11S_TankGeometry::volumeQ16(int32_t levelQ16) {
+	uint32_t pos, lo, hi;
+	uint8_t i;
+
+	if (!isValid())
+		return 0;
+
+	if (levelQ16 <= 0)
+		return _volumes[0];
+	if (levelQ16 >= _heightQ16)
+		return _volumes[_points - 1];
+
+	pos = (uint32_t)(((uint64_t)levelQ16 * _scale) >> _shift);
+	i = (uint8_t)(pos >> 16);
+	if (i >= _points - 1)
+		return _volumes[_points - 1];
+
+	lo = _volumes[i];
+	hi = _volumes[i + 1];
+
+	if (hi >= lo)
+		return lo + (uint32_t)(((uint64_t)(hi - lo) * (pos & 0xFFFF)) >> 16);
+	return lo - (uint32_t)(((uint64_t)(lo - hi) * (pos & 0xFFFF)) >> 16);
+}
+
+float MC11S_TankGeometry::volume(float level) {
+	if (level >= 32767.0f)
+		level = 32767.0f;
+	return (float)volumeQ16((int32_t)(level * 65536.0f));
+}
+
+static void putLe32(uint8_t *p, uint32_t val) {
+	p[0] = (uint8_t)val;
+	p[1] = (uint8_t)(val >> 8);
+	p[2] = (uint8_t)(val >> 16);
+	p[3] = (uint8_t)(val >> 24);
+}
+
+static uint32_t getLe32(const uint8_t *p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief  			Writes the table as an image: 'M' 'G' version points,
+ * 					height (Q16.16), volumes, then the CRC-16 of all of it,
+ * 					little-endian throughout
+ * @param	buf		Destination, MC11S_GEOM_IMAGE_MAX bytes is always enough
+ * @param	len		Size of buf
+ * @retval  		Bytes written, -1 if there is no table or buf is too small
+ */
+int32_t MC11S_TankGeometry::pack(uint8_t *buf, uint16_t len) {
+	uint16_t size = 9 + 4 * _points, crc;
+	uint8_t i;
+
+	if (!isValid() || len < size + 2)
+		return -1;
+
+	buf[0] = 'M';
+	buf[1] = 'G';
+	buf[2] = MC11S_GEOM_VERSION;
+	buf[3] = 0;
+	buf[4] = _points;
+	putLe32(&buf[5], (uint32_t)_heightQ16);
+	for (i = 0; i < _points; i++)
+		putLe32(&buf[9 + 4 * i], _volumes[i]);
+
+	crc = mc11s_crc16(buf, size);
+	buf[size] = (uint8_t)crc;
+	buf[size + 1] = (uint8_t)(crc >> 8);
+
+	return size + 2;
+}
+
+/**
+ * @brief  			Loads a table written by pack() into this object
+ * @param	buf		Image
+ * @param	len		Bytes available in buf (may be more than the image)
+ * @retval  		Error code (0 -> loaded, -1 -> wrong format or version, bad CRC)
+ */
+int32_t MC11S_TankGeometry::unpack(const uint8_t *buf, uint16_t len) {
+	uint16_t size;
+	uint8_t i, points;
+
+	if (len < 11 || buf[0] != 'M' || buf[1] != 'G' || buf[2] != MC11S_GEOM_VERSION)
+		return -1;
+
+	points = buf[4];
+	size = 9 + 4 * points;
+	if (points < 2 || points > MC11S_GEOM_MAX_POINTS || len < size + 2 ||
+		mc11s_crc16(buf, size) != (uint16_t)(buf[size] | (buf[size + 1] << 8)))
+		return -1;
+
+	if (setGrid(points, (int32_t)getLe32(&buf[5]) / 65536.0f) != 0)
+		return -1;
+
+	// Exactly the stored height, not its round trip through float
+	_heightQ16 = (int32_t)getLe32(&buf[5]);
+
+	for (i = 0; i < points; i++)
+		_table[i] = getLe32(&buf[9 + 4 * i]);
+
+	_volumes = _table;
+	return 0;
+}
+
+/**
+ * @brief  			Stores the table in EEPROM (only changed bytes are written)
+ * @param	address	First EEPROM byte, MC11S_GEOM_IMAGE_MAX bytes are reserved from it
+ * @retval  		Error code (0 -> no Error, -1 -> no table, no room or no EEPROM)
+ */
+int32_t MC11S_TankGeometry::save(int address) {
+	uint8_t buf[MC11S_GEOM_IMAGE_MAX];
+	int32_t len = pack(buf, sizeof(buf));
+
+	if (len < 0)
+		return -1;
+
+	return mc11s_eeprom_write(address, buf, (uint16_t)len);
+}
+
+/**
+ * @brief  			Loads a table stored by save()
+ * @param	address	First EEPROM byte
+ * @retval  		Error code (0 -> loaded, -1 -> none stored, corrupt or no EEPROM)
+ */
+int32_t MC11S_TankGeometry::load(int address) {
+	uint8_t buf[MC11S_GEOM_IMAGE_MAX];
+	int32_t len = mc11s_eeprom_read(address, buf, sizeof(buf));
+
+	if (len < 0)
+		return -1;
+
+	return unpack(buf, (uint16_t)len);
+}
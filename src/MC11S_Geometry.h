@@ -0,0 +1,82 @@
+/******************************************************************************
+This file defines the tank geometry model: the lookup from a calibrated level
+(MC11S_Calibration, Q16.16 level units) to the volume it holds. Most tanks
+are not prisms, a horizontal cylinder holds little near the bottom and top
+and most in the middle, so volume has to come from the shape.
+
+The shape is a table of volumes on a uniform level grid, from level 0 to the
+tank height in (points - 1) equal steps. Finding the cell is one multiply
+(no search, no division), interpolating in it another, so every lookup
+costs the same. volumeQ16() does it in integer math for AVR, volume() is
+the float wrapper.
+
+The table can come from:
+
+    setTable()              a const array in flash or RAM, e.g. generated
+                            on a host and compiled in (not copied)
+    verticalCylinder()      generators for the common shapes, filled once
+    horizontalCylinder()    at start-up with float math; lengths in mm,
+    rectangular()           volumes in ml
+    resample()              a strapping table of (level, volume) pairs at
+                            any spacing, e.g. a sump measured by filling it
+                            in buckets, interpolated onto the grid
+    load()                  EEPROM, stored by save() as a versioned image
+                            with a CRC-16 (MC11S_Crc.h); AVR only, elsewhere
+                            keep the pack() image and give it to unpack()
+
+Levels below 0 give the first entry, above the height the last.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Geometry_H__
+#define __MC11S_Geometry_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef MC11S_GEOM_MAX_POINTS
+#define MC11S_GEOM_MAX_POINTS		33
+#endif
+
+#define MC11S_GEOM_VERSION			1
+
+// Largest image pack() writes: header, height, volumes, CRC
+#define MC11S_GEOM_IMAGE_MAX		(9 + 4 * MC11S_GEOM_MAX_POINTS + 2)
+
+class MC11S_TankGeometry {
+	public:
+		MC11S_TankGeometry(void);
+
+		int32_t setTable(const uint32_t *volumes, uint8_t points, float height);	// Caller's table, kept by pointer
+		int32_t verticalCylinder(float diameter, float height, uint8_t points = MC11S_GEOM_MAX_POINTS);
+		int32_t horizontalCylinder(float diameter, float length, uint8_t points = MC11S_GEOM_MAX_POINTS);
+		int32_t rectangular(float width, float depth, float height, uint8_t points = MC11S_GEOM_MAX_POINTS);
+		int32_t resample(const float *levels, const float *volumes, uint8_t n, uint8_t points = MC11S_GEOM_MAX_POINTS);
+
+		bool isValid(void);
+		uint8_t getPointCount(void);
+		float getHeight(void);
+		uint32_t getCapacity(void);						// Volume when full
+
+		uint32_t volumeQ16(int32_t levelQ16);			// Integer only
+		float volume(float level);
+
+		int32_t pack(uint8_t *buf, uint16_t len);		// Bytes written, -1 if no table or too small
+		int32_t unpack(const uint8_t *buf, uint16_t len);	// 0 -> loaded, -1 -> bad image
+		int32_t save(int address);						// EEPROM on AVR (MC11S_Eeprom.h), -1 elsewhere
+		int32_t load(int address);
+
+	private:
+		int32_t setGrid(uint8_t points, float height);
+
+		uint32_t _table[MC11S_GEOM_MAX_POINTS];		// Generated or loaded tables live here
+		const uint32_t *_volumes;
+		uint8_t _points;
+		int32_t _heightQ16;
+		uint32_t _scale;							// Grid steps per level unit, scaled by 2^_shift
+		uint8_t _shift;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "MC11S_Kalman.h"
+#include <math.h>
+
+// Riccati iterations used to reach the steady state gains
+#define kSolveIterations 500
+
+static int32_t toQ16(float val) {
+	return (int32_t)(val * 65536.0f + (val < 0 ? -0.5f : 0.5f));
+}
+
+// Q16.16 multiply with a 64 bit intermediate, rounded so small corrections don't all lean negative
+static int32_t mulQ16(int32_t a, int32_t b) {
+	return (int32_t)(((int64_t)a * b + 0x8000) >> 16);
+}
+
+MC11S_LevelKalmanFixed::MC11S_LevelKalmanFixed(void) : _q{1e-4f}, _r{1.0f}, _dt{1.0f}, _gainsValid{false}, _level{0}, _rate{0}, _trip{0}, _release{0}, _state{MC11S_RATE_STEADY}, _primed{false}
+{
+
+}
+
+/**
+ * @brief  			Sets process (rate random walk) and measurement noise
+ * @param	processNoise		q in units^2/s^3
+ * @param	measurementNoise	r in units^2
+ */
+void MC11S_LevelKalmanFixed::setNoise(float processNoise, float measurementNoise) {
+	_q = processNoise;
+	_r = measurementNoise;
+	_gainsValid = false;
+}
+
+/**
+ * @brief  			Sets the time between samples, i.e. the conversion period
+ * @param	dt		seconds
+ */
+void MC11S_LevelKalmanFixed::setPeriod(float dt) {
+	_dt = dt;
+	_gainsValid = false;
+}
+
+/**
+ * @brief  			Sets the rate alarm levels
+ * @param	trip	|rate| above which the alarm trips, units/s (0 -> alarm off)
+ * @param	release	|rate| below which it releases again, units/s
+ */
+void MC11S_LevelKalmanFixed::setRateAlarm(float trip, float release) {
+	_trip = toQ16(trip);
+	_release = toQ16(release);
+}
+
+/**
+ * @brief  			Restarts the filter at a known level with zero rate
+ * @param	level	units
+ */
+void MC11S_LevelKalmanFixed::reset(int32_t level) {
+	_level = level * 65536L;
+	_rate = 0;
+	_state = MC11S_RATE_STEADY;
+	_primed = true;
+}
+
+/**
+ * @brief  			Predicts one period ahead and corrects with a measurement. The
+ * 					first call after setNoise()/setPeriod() solves the gains first.
+ * @param	z		measurement, whole units (scale fractional streams up first)
+ * @retval  		true when the rate alarm state changed
+ */
+bool MC11S_LevelKalmanFixed::update(int32_t z) {
+	int32_t y;
+
+	if (!_gainsValid)
+		solveGains();
+
+	if (!_primed) {
+		reset(z);
+		return false;
+	}
+
+	_level += mulQ16(_rate, _dtQ16);
+
+	y = z * 65536L - _level;
+	_level += mulQ16(y, _k0);
+	_rate += mulQ16(y, _k1);
+
+	if (_trip <= 0)
+		return false;
+
+	return mc11s_rate_alarm_update<int32_t>(&_state, _rate, _trip, _release);
+}
+
+int32_t MC11S_LevelKalmanFixed::getLevel(void) {
+	return (_level + 0x8000L) >> 16;
+}
+
+int32_t MC11S_LevelKalmanFixed::getLevelQ16(void) {
+	return _level;
+}
+
+int32_t MC11S_LevelKalmanFixed::getRateQ16(void) {
+	return _rate;
+}
+
+float MC11S_LevelKalmanFixed::getRate(void) {
+	return _rate / 65536.0f;
+}
+
+mc11s_rate_state_t MC11S_LevelKalmanFixed::getRateState(void) {
+	return _state;
+}
+
+/**
+ * @brief  	Runs the covariance recursion of the float filter until the gains
+ * 			settle; with constant q, r and dt those are the gains the full
+ * 			filter converges to after its start-up transient.
+ */
+void MC11S_LevelKalmanFixed::solveGains(void) {
+	float p00 = _r, p01 = 0, p11 = _r;
+	float k0 = 0, k1 = 0;
+	float dt = _dt;
+
+	// The gains can repeat from one step to the next while the covariance
+	// still moves (from P = r I they do), so the rate variance has to settle too
+	for (uint16_t i = 0; i < kSolveIterations; i++) {
+		float a00 = p00 + 2 * dt * p01 + dt * dt * p11 + _q * dt * dt * dt / 3;
+		float a01 = p01 + dt * p11 + _q * dt * dt / 2;
+		float a11 = p11 + _q * dt;
+		float s = a00 + _r;
+
+		float prev0 = k0, prev1 = k1, prevP = p11;
+
+		k0 = a00 / s;
+		k1 = a01 / s;
+
+		p00 = (1 - k0) * a00;
+		p01 = (1 - k0) * a01;
+		p11 = a11 - k1 * a01;
+
+		if (i > 0 && fabsf(k0 - prev0) <= 1e-6f * k0 && fabsf(k1 - prev1) <= 1e-6f * fabsf(k1) &&
+			fabsf(p11 - prevP) <= 1e-6f * p11)
+			break;
+	}
+
+	_k0 = toQ16(k0);
+	_k1 = toQ16(k1);
+	_dtQ16 = toQ16(dt);
+	_gainsValid = true;
+}
@@ -0,0 +1,214 @@
+/******************************************************************************
+This file defines the level-and-rate estimator used for leak detection. It is
+a two state Kalman filter (constant velocity model) on top of any scalar
+stream coming out of the MC11S: capacitance, the channel ratio, or a
+calibrated level.
+
+    state       x = [level, rate]        rate in units per second
+    process     white noise on the rate, spectral density q (units^2 / s^3)
+    measurement z = level + v,            variance r (units^2)
+
+Two flavours are provided:
+
+  MC11S_LevelKalman<T>     full covariance recursion in T (double on host,
+                           float where that is fast enough)
+  MC11S_LevelKalmanFixed   the same filter run in Q16.16 integer math with
+                           its steady state gains, for AVR. Per sample it
+                           costs two 64 bit multiplies and a handful of
+                           adds. The gains are solved in float by the first
+                           update() after the noise or the sample period
+                           changed: up to 500 steps of the covariance
+                           recursion (it usually settles far sooner), so
+                           set both before sampling starts, not per sample.
+                           Measurements are whole units in +/-32767, and
+                           the rate resolves to 1/65536 unit/s: scale a
+                           fractional stream into that range first, e.g.
+                           the Csensor / Cref ratio times 10000 (0.9 ->
+                           9000 units), and give q, r and the alarm levels
+                           in the scaled units.
+
+Both drive a rate-of-change alarm with hysteresis: the state goes to RISING
+or FALLING when |rate| exceeds the trip level and returns to STEADY only once
+it drops below the release level. The alarm is off (the state stays STEADY)
+until setRateAlarm() gives it a trip level above 0.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Kalman_H__
+#define __MC11S_Kalman_H__
+
+#include <stdint.h>
+
+typedef enum {
+  MC11S_RATE_STEADY   = 0x0,
+  MC11S_RATE_RISING   = 0x1,
+  MC11S_RATE_FALLING  = 0x2,
+} mc11s_rate_state_t;
+
+/**
+ * @brief  One step of the rate alarm state machine.
+ * @retval true when the state changed
+ */
+template <typename T>
+bool mc11s_rate_alarm_update(mc11s_rate_state_t *state, T rate, T trip, T release) {
+	mc11s_rate_state_t next = *state;
+
+	switch (*state) {
+		case MC11S_RATE_RISING:
+			if (rate < release)
+				next = MC11S_RATE_STEADY;
+			break;
+
+		case MC11S_RATE_FALLING:
+			if (rate > -release)
+				next = MC11S_RATE_STEADY;
+			break;
+
+		default:
+			if (rate > trip)
+				next = MC11S_RATE_RISING;
+			else if (rate < -trip)
+				next = MC11S_RATE_FALLING;
+			break;
+	}
+
+	// A rate that swings straight across the band re-trips on the far side
+	if (next == MC11S_RATE_STEADY && *state != MC11S_RATE_STEADY) {
+		if (rate > trip)
+			next = MC11S_RATE_RISING;
+		else if (rate < -trip)
+			next = MC11S_RATE_FALLING;
+	}
+
+	if (next == *state)
+		return false;
+
+	*state = next;
+	return true;
+}
+
+template <typename T>
+class MC11S_LevelKalman {
+	public:
+		MC11S_LevelKalman(void) : _q{(T)1e-4}, _r{(T)1}, _dt{(T)1}, _trip{(T)0}, _release{(T)0} {
+			reset((T)0);
+			_primed = false;
+		}
+
+		void setNoise(T processNoise, T measurementNoise) {		// q (units^2/s^3) and r (units^2)
+			_q = processNoise;
+			_r = measurementNoise;
+		}
+
+		void setPeriod(T dt) { _dt = dt; }						// Seconds between samples
+
+		void setRateAlarm(T trip, T release) {					// |rate| thresholds in units/s, release < trip (0 -> off)
+			_trip = trip;
+			_release = release;
+		}
+
+		/**
+		 * @brief  Restarts the filter at a known level. Both variances start
+		 *         at the measurement variance; the first few samples settle them.
+		 */
+		void reset(T level, T rate = 0) {
+			_x[0] = level;
+			_x[1] = rate;
+			_P[0][0] = _r;
+			_P[0][1] = 0;
+			_P[1][0] = 0;
+			_P[1][1] = _r;
+			_state = MC11S_RATE_STEADY;
+			_primed = true;
+		}
+
+		/**
+		 * @brief  Predicts one period ahead and corrects with measurement z.
+		 * @retval true when the rate alarm state changed
+		 */
+		bool update(T z) {
+			T dt = _dt;
+			T p00, p01, p11, s, k0, k1, y;
+
+			if (!_primed) {
+				reset(z);
+				return false;
+			}
+
+			// Predict: x = F x, P = F P F' + Q
+			_x[0] += dt * _x[1];
+
+			p00 = _P[0][0] + dt * (_P[0][1] + _P[1][0]) + dt * dt * _P[1][1] + _q * dt * dt * dt / 3;
+			p01 = _P[0][1] + dt * _P[1][1] + _q * dt * dt / 2;
+			p11 = _P[1][1] + _q * dt;
+
+			// Correct
+			s = p00 + _r;
+			k0 = p00 / s;
+			k1 = p01 / s;
+			y = z - _x[0];
+
+			_x[0] += k0 * y;
+			_x[1] += k1 * y;
+
+			_P[0][0] = (1 - k0) * p00;
+			_P[0][1] = (1 - k0) * p01;
+			_P[1][0] = _P[0][1];
+			_P[1][1] = p11 - k1 * p01;
+
+			// Don't alarm on the start-up transient, while the rate is still
+			// less certain than the trip level itself
+			if (_trip <= 0 || _P[1][1] > _trip * _trip)
+				return false;
+
+			return mc11s_rate_alarm_update<T>(&_state, _x[1], _trip, _release);
+		}
+
+		T getLevel(void) { return _x[0]; }
+		T getRate(void) { return _x[1]; }
+		T getLevelVariance(void) { return _P[0][0]; }
+		T getRateVariance(void) { return _P[1][1]; }
+		mc11s_rate_state_t getRateState(void) { return _state; }
+
+	private:
+		T _x[2];
+		T _P[2][2];
+		T _q, _r, _dt;
+		T _trip, _release;
+		mc11s_rate_state_t _state;
+		bool _primed;
+};
+
+class MC11S_LevelKalmanFixed {
+	public:
+		MC11S_LevelKalmanFixed(void);
+
+		void setNoise(float processNoise, float measurementNoise);	// q (units^2/s^3) and r (units^2)
+		void setPeriod(float dt);									// Seconds between samples
+		void setRateAlarm(float trip, float release);				// |rate| thresholds in units/s (0 -> off)
+
+		void reset(int32_t level);
+		bool update(int32_t z);			// Whole (scaled) units; true when the rate alarm state changed
+
+		int32_t getLevel(void);			// Rounded to whole units
+		int32_t getLevelQ16(void);		// Units, Q16.16
+		int32_t getRateQ16(void);		// Units per second, Q16.16
+		float getRate(void);
+		mc11s_rate_state_t getRateState(void);
+
+	private:
+		void solveGains(void);
+
+		float _q, _r, _dt;
+		int32_t _dtQ16;
+		int32_t _k0, _k1;				// Steady state gains, Q16.16 (k1 in 1/s)
+		bool _gainsValid;				// Solved for the current q, r and dt
+		int32_t _level, _rate;
+		int32_t _trip, _release;
+		mc11s_rate_state_t _state;
+		bool _primed;
+};
+
+#endif
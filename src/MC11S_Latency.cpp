@@ -0,0 +1,272 @@
+#include "MC11S_Latency.h"
+#include "MC11S_Time.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+// Stamps in _marks
+#define MC11S_LAT_MARK_EDGE			0x01
+#define MC11S_LAT_MARK_ISR			0x02
+#define MC11S_LAT_MARK_DISPATCH		0x04
+#define MC11S_LAT_MARK_TRANSFER		0x08
+
+MC11S_LatencyHistogram::MC11S_LatencyHistogram(void) {
+	reset();
+}
+
+void MC11S_LatencyHistogram::reset(void) {
+	uint8_t i;
+
+	for (i = 0; i < MC11S_LAT_BUCKETS; i++)
+		_buckets[i] = 0;
+	_count = 0;
+	_min = 0;
+	_max = 0;
+	_sum = 0;
+}
+
+void MC11S_LatencyHistogram::add(uint32_t us) {
+	uint8_t i = 0;
+
+	// Bucket = bit length of us
+	while (us >> i && i < MC11S_LAT_BUCKETS - 1)
+		i++;
+
+	if (_buckets[i] != 0xFFFF)
+		_buckets[i]++;
+
+	if (_count == 0 || us < _min)
+		_min = us;
+	if (_count == 0 || us > _max)
+		_max = us;
+	_count++;
+	_sum += us;
+}
+
+uint32_t MC11S_LatencyHistogram::getCount(void) {
+	return _count;
+}
+
+uint32_t MC11S_LatencyHistogram::getMin(void) {
+	return _min;
+}
+
+uint32_t MC11S_LatencyHistogram::getMax(void) {
+	return _max;
+}
+
+float MC11S_LatencyHistogram::getMean(void) {
+	return _count ? (float)_sum / _count : 0;
+}
+
+uint16_t MC11S_LatencyHistogram::getBucket(uint8_t i) {
+	return (i < MC11S_LAT_BUCKETS) ? _buckets[i] : 0;
+}
+
+uint32_t MC11S_LatencyHistogram::bucketLow(uint8_t i) {
+	return (i == 0) ? 0 : 1UL << (i - 1);
+}
+
+/**
+ * @brief  			Latency that at least the given fraction of the samples stayed
+ * 					within, to the resolution of the buckets: the top of the bucket
+ * 					the percentile falls into, or the maximum if that is lower
+ * @param	fraction	e.g. 0.99
+ * @retval  		Latency bound in us (0 with no samples)
+ */
+uint32_t MC11S_LatencyHistogram::getPercentile(float fraction) {
+	uint32_t need, seen = 0;
+	uint8_t i;
+
+	if (_count == 0)
+		return 0;
+
+	need = (uint32_t)(fraction * _count + 0.999f);
+	for (i = 0; i < MC11S_LAT_BUCKETS - 1; i++) {
+		seen += _buckets[i];
+		if (seen >= need)
+			return (bucketLow(i + 1) - 1 < _max) ? bucketLow(i + 1) - 1 : _max;
+	}
+
+	return _max;
+}
+
+static size_t mc11s_lat_pad(Print &out, uint32_t val, uint8_t width) {
+	size_t n = 0;
+	uint32_t v = val;
+	uint8_t digits = 1;
+
+	while (v >= 10) {
+		v /= 10;
+		digits++;
+	}
+	while (digits++ < width)
+		n += out.print(' ');
+
+	return n + out.print((unsigned long)val);
+}
+
+/**
+ * @brief  			Prints the summary line and every bucket that has samples:
+ * 					"label: n N, min A, mean B, max C, 99% <= D us" then
+ * 					"    lo -    hi us  count" per bucket
+ * @param	out		Destination
+ * @param	label	Name of the histogram
+ * @retval  		Bytes written
+ */
+size_t MC11S_LatencyHistogram::report(Print &out, const char *label) {
+	size_t n = 0;
+	uint8_t i;
+
+	n += out.print(label);
+	n += out.print(": n ");
+	n += out.print((unsigned long)_count);
+	if (_count != 0) {
+		n += out.print(", min ");
+		n += out.print((unsigned long)_min);
+		n += out.print(", mean ");
+		n += out.print(getMean(), 1);
+		n += out.print(", max ");
+		n += out.print((unsigned long)_max);
+		n += out.print(", 99% <= ");
+		n += out.print((unsigned long)getPercentile(0.99f));
+		n += out.print(" us");
+	}
+	n += out.println();
+
+	for (i = 0; i < MC11S_LAT_BUCKETS; i++) {
+		if (_buckets[i] == 0)
+			continue;
+
+		n += mc11s_lat_pad(out, bucketLow(i), 10);
+		if (i == MC11S_LAT_BUCKETS - 1) {
+			n += out.print(" and up ");
+		} else {
+			n += out.print(" -");
+			n += mc11s_lat_pad(out, bucketLow(i + 1) - 1, 6);
+		}
+		n += out.print(" us ");
+		n += mc11s_lat_pad(out, _buckets[i], 6);
+		n += out.println();
+	}
+
+	return n;
+}
+
+MC11S_LatencyProbe::MC11S_LatencyProbe(void) :
+#if MC11S_HAS_MICROS
+	_timebase{mc11s_micros},
+#else
+	_timebase{NULL},
+#endif
+	_edgeUs{0}, _isrUs{0}, _marks{0}, _dispatchEdgeUs{0}, _dispatchIsrUs{0}, _dispatchMarks{0},
+	_dispatchUs{0}, _transferUs{0}
+{
+}
+
+void MC11S_LatencyProbe::setTimebase(unsigned long (*us)(void)) {
+	_timebase = us;
+}
+
+uint32_t MC11S_LatencyProbe::now(void) {
+	return _timebase ? _timebase() : 0;
+}
+
+/**
+ * @brief  			Time the INTB edge happened, on the timebase of the probe.
+ * 					Starts a new measurement.
+ * @param	us		Edge time
+ */
+void MC11S_LatencyProbe::edge(uint32_t us) {
+	_edgeUs = us;
+	_marks = MC11S_LAT_MARK_EDGE;
+}
+
+// From the ISR: a measurement without a known edge starts here
+void MC11S_LatencyProbe::isrEntry(void) {
+	_isrUs = now();
+	_marks = (_marks & MC11S_LAT_MARK_EDGE) | MC11S_LAT_MARK_ISR;
+}
+
+void MC11S_LatencyProbe::observed(void) {
+	_isrUs = now();
+	_marks = MC11S_LAT_MARK_ISR;
+}
+
+/**
+ * @brief  			Stamps the start of the deferred work and takes over the
+ * 					interrupt side stamps, so an INTB that fires while the work
+ * 					runs starts the next measurement instead of corrupting this one
+ */
+void MC11S_LatencyProbe::dispatch(void) {
+	uint32_t t = now();
+
+#if defined(ARDUINO)
+	noInterrupts();
+#endif
+	_dispatchEdgeUs = _edgeUs;
+	_dispatchIsrUs = _isrUs;
+	_dispatchMarks = (_marks & (MC11S_LAT_MARK_EDGE | MC11S_LAT_MARK_ISR)) | MC11S_LAT_MARK_DISPATCH;
+	_marks = 0;
+#if defined(ARDUINO)
+	interrupts();
+#endif
+
+	_dispatchUs = t;
+}
+
+void MC11S_LatencyProbe::transferred(void) {
+	_transferUs = now();
+	_dispatchMarks |= MC11S_LAT_MARK_TRANSFER;
+}
+
+/**
+ * @brief  			Stamps the result as delivered and records every stage that has
+ * 					both its stamps
+ */
+void MC11S_LatencyProbe::consumed(void) {
+	uint32_t t = now(), first;
+	uint8_t m = _dispatchMarks;
+
+	if (!(m & MC11S_LAT_MARK_DISPATCH))
+		return;
+
+	if ((m & MC11S_LAT_MARK_EDGE) && (m & MC11S_LAT_MARK_ISR))
+		_stages[MC11S_LAT_ISR].add(_dispatchIsrUs - _dispatchEdgeUs);
+	if (m & MC11S_LAT_MARK_ISR)
+		_stages[MC11S_LAT_DISPATCH].add(_dispatchUs - _dispatchIsrUs);
+	if (m & MC11S_LAT_MARK_TRANSFER) {
+		_stages[MC11S_LAT_TRANSFER].add(_transferUs - _dispatchUs);
+		_stages[MC11S_LAT_COMPUTE].add(t - _transferUs);
+	}
+
+	first = (m & MC11S_LAT_MARK_EDGE) ? _dispatchEdgeUs : (m & MC11S_LAT_MARK_ISR) ? _dispatchIsrUs : _dispatchUs;
+	_stages[MC11S_LAT_TOTAL].add(t - first);
+
+	_dispatchMarks = 0;
+}
+
+MC11S_LatencyHistogram &MC11S_LatencyProbe::get(mc11s_lat_stage_t stage) {
+	return _stages[(stage < MC11S_LAT_STAGES) ? stage : MC11S_LAT_TOTAL];
+}
+
+void MC11S_LatencyProbe::reset(void) {
+	uint8_t i;
+
+	for (i = 0; i < MC11S_LAT_STAGES; i++)
+		_stages[i].reset();
+	_marks = 0;
+	_dispatchMarks = 0;
+}
+
+size_t MC11S_LatencyProbe::report(Print &out) {
+	static const char *const labels[MC11S_LAT_STAGES] = { "isr", "dispatch", "transfer", "compute", "total" };
+	size_t n = 0;
+	uint8_t i;
+
+	for (i = 0; i < MC11S_LAT_STAGES; i++)
+		n += _stages[i].report(out, labels[i]);
+
+	return n;
+}
@@ -0,0 +1,110 @@
+/******************************************************************************
+This file defines the latency instrumentation: how long it takes from the
+MC11S finishing a conversion to its result reaching the code that acts on
+it, stage by stage. The path is stamped at five points
+
+    edge(us)        INTB fell, when the time is known: a timer input
+                    capture on the board, the simulator on a host
+    isrEntry()      first thing in the INTB interrupt handler
+    observed()      instead of both when polling: DRDY was seen set
+    dispatch()      loop() picks up the work the handler deferred
+    transferred()   STATUS and data have been read over the bus
+    consumed()      the result has been delivered (alarm raised, level
+                    logged, ...); the stages are recorded now
+
+and each stage goes into its own histogram:
+
+    isr         edge -> handler entry
+    dispatch    handler entry -> deferred work starts
+    transfer    bus transfer
+    compute     data -> result delivered
+    total       first stamp -> result delivered
+
+Stages with a stamp missing at either end are skipped, so an edge that
+isn't known leaves isr empty and total counted from the handler entry.
+
+The histograms have MC11S_LAT_BUCKETS power of two buckets (below 1 us,
+1 us, 2-3 us, 4-7 us, ..., the last one open ended) plus the exact count,
+minimum, mean and maximum. getPercentile() gives a bound that is never
+below the true percentile: the top of its bucket, or the maximum.
+report() prints all of it to any Print (Serial, a file, a host stream).
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Latency_H__
+#define __MC11S_Latency_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "MC11S_Print.h"
+
+#ifndef MC11S_LAT_BUCKETS
+#define MC11S_LAT_BUCKETS		16
+#endif
+
+#define MC11S_LAT_STAGES		5
+
+typedef enum {
+	MC11S_LAT_ISR = 0x0,
+	MC11S_LAT_DISPATCH = 0x1,
+	MC11S_LAT_TRANSFER = 0x2,
+	MC11S_LAT_COMPUTE = 0x3,
+	MC11S_LAT_TOTAL = 0x4,
+} mc11s_lat_stage_t;
+
+class MC11S_LatencyHistogram {
+	public:
+		MC11S_LatencyHistogram(void);
+
+		void reset(void);
+		void add(uint32_t us);
+
+		uint32_t getCount(void);
+		uint32_t getMin(void);
+		uint32_t getMax(void);
+		float getMean(void);
+		uint16_t getBucket(uint8_t i);				// Saturates at 0xFFFF
+		uint32_t getPercentile(float fraction);		// Bound on the fraction-th latency, us
+
+		static uint32_t bucketLow(uint8_t i);		// Smallest latency in bucket i, us
+
+		size_t report(Print &out, const char *label);
+
+	private:
+		uint16_t _buckets[MC11S_LAT_BUCKETS];
+		uint32_t _count, _min, _max;
+		uint64_t _sum;
+};
+
+class MC11S_LatencyProbe {
+	public:
+		MC11S_LatencyProbe(void);
+
+		void setTimebase(unsigned long (*us)(void));	// e.g. micros (default mc11s_micros on Arduino and Linux)
+
+		void edge(uint32_t us);			// INTB edge time, from the ISR or the simulator
+		void isrEntry(void);			// From the ISR
+		void observed(void);			// DRDY seen by a poll
+		void dispatch(void);
+		void transferred(void);
+		void consumed(void);
+
+		MC11S_LatencyHistogram &get(mc11s_lat_stage_t stage);
+		void reset(void);
+		size_t report(Print &out);
+
+	private:
+		uint32_t now(void);
+
+		unsigned long (*_timebase)(void);
+		volatile uint32_t _edgeUs, _isrUs;
+		volatile uint8_t _marks;			// Stamps taken by the interrupt side
+		uint32_t _dispatchEdgeUs, _dispatchIsrUs;	// Taken over by dispatch()
+		uint8_t _dispatchMarks;
+		uint32_t _dispatchUs, _transferUs;
+		MC11S_LatencyHistogram _stages[MC11S_LAT_STAGES];
+};
+
+#endif
@@ -0,0 +1,185 @@
+/******************************************************************************
+This file defines the latest-value cell: one sample published by the code
+that acquires it and read by any number of consumers, without a consumer
+ever seeing ch0 of one conversion next to ch1 of another.
+
+MC11S_Seqlock<T> is a sequence lock around a copy of T:
+
+    publish()   the writer makes the sequence odd, copies the value in and
+                makes it even again. It never waits and never fails, so it
+                can run in an interrupt handler.
+    read()      the reader copies the value out and checks that the
+                sequence was even and the same before and after; otherwise
+                the writer got in between and the copy is taken again.
+    tryRead()   one attempt only, false when the writer was in between
+
+There is one writer at a time. Readers don't write anything, so they never
+hold up the writer or each other; on a host any number of threads can poll
+the cell with no mutex. A reader that can interrupt the writer (an ISR
+reading a cell loop() publishes) must use tryRead(): read() would wait for
+a writer that can't run until the ISR returns.
+
+On AVR the sequence is one byte, which the CPU loads and stores in one
+instruction, and the copy is volatile; elsewhere the sequence and the copy
+use the GCC __atomic builtins with acquire/release ordering, so it holds on
+multi-core hosts and ARM/ESP32 boards as well.
+
+MC11S_LatestSample is the cell for an mc11s_sample_t (ch0, ch1, status,
+timestamp, seq) from MC11S_Sampler.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Latest_H__
+#define __MC11S_Latest_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "MC11S_Sampler.h"
+
+#if defined(__AVR__)
+typedef uint8_t mc11s_seq_t;			// Single byte: loaded and stored atomically
+typedef uint8_t mc11s_seq_word_t;
+#else
+typedef uint32_t mc11s_seq_t;
+typedef uint32_t mc11s_seq_word_t;
+#endif
+
+template <typename T>
+class MC11S_Seqlock {
+	public:
+		MC11S_Seqlock(void) : _seq{0}
+		{
+			for (size_t i = 0; i < WORDS; i++)
+				_data[i] = 0;
+		}
+
+		/**
+		 * @brief  Publishes a new value. Wait-free; one writer at a time.
+		 */
+		void publish(const T &value) {
+			mc11s_seq_word_t buf[WORDS];
+			mc11s_seq_t s = loadSeq();
+			mc11s_seq_t next = s + 2;
+
+			buf[WORDS - 1] = 0;
+			memcpy(buf, &value, sizeof(T));
+
+			// 0 stays "nothing published" when the sequence wraps
+			if (next == 0)
+				next = 2;
+
+			storeSeq(s + 1);
+			fenceRelease();
+			for (size_t i = 0; i < WORDS; i++)
+				storeWord(&_data[i], buf[i]);
+			storeSeq(next);
+		}
+
+		/**
+		 * @brief  Copies the latest value out, taking it again for as long as
+		 *         the writer gets in between.
+		 * @param  value  Latest value
+		 * @retval false when nothing has been published yet
+		 */
+		bool read(T *value) {
+			mc11s_seq_word_t buf[WORDS];
+			mc11s_seq_t s;
+
+			while (!snapshot(buf, &s))
+				;
+			if (s == 0)
+				return false;
+
+			memcpy(value, buf, sizeof(T));
+			return true;
+		}
+
+		/**
+		 * @brief  Copies the latest value out in a single attempt.
+		 * @param  value  Latest value, only when true is returned
+		 * @retval false when the writer was in between or nothing has been
+		 *         published yet
+		 */
+		bool tryRead(T *value) {
+			mc11s_seq_word_t buf[WORDS];
+			mc11s_seq_t s;
+
+			if (!snapshot(buf, &s) || s == 0)
+				return false;
+
+			memcpy(value, buf, sizeof(T));
+			return true;
+		}
+
+		/**
+		 * @brief  Copies the value out when it was published after the one
+		 *         the caller saw last.
+		 * @param  value  Latest value, only when true is returned
+		 * @param  seen   Version seen last (0 initially), updated
+		 * @retval true when there is a new value
+		 */
+		bool readNew(T *value, mc11s_seq_t *seen) {
+			mc11s_seq_word_t buf[WORDS];
+			mc11s_seq_t s;
+
+			while (!snapshot(buf, &s))
+				;
+			if (s == *seen)
+				return false;
+
+			memcpy(value, buf, sizeof(T));
+			*seen = s;
+			return true;
+		}
+
+		// Changes with every publish(), 0 before the first; wraps (after 128 on AVR)
+		mc11s_seq_t getVersion(void) { return loadSeqAcquire(); }
+
+	private:
+		static const size_t WORDS = (sizeof(T) + sizeof(mc11s_seq_word_t) - 1) / sizeof(mc11s_seq_word_t);
+
+		// One attempt: even sequence, unchanged across the copy
+		bool snapshot(mc11s_seq_word_t *buf, mc11s_seq_t *seq) {
+			mc11s_seq_t s = loadSeqAcquire();
+
+			if (s & 1)
+				return false;
+			for (size_t i = 0; i < WORDS; i++)
+				buf[i] = loadWord(&_data[i]);
+			fenceAcquire();
+			if (loadSeq() != s)
+				return false;
+
+			*seq = s;
+			return true;
+		}
+
+#if defined(__AVR__)
+		// One core and in-order volatile accesses: only the compiler has to be held back
+		mc11s_seq_t loadSeq(void) { return _seq; }
+		mc11s_seq_t loadSeqAcquire(void) { return _seq; }
+		void storeSeq(mc11s_seq_t s) { _seq = s; }
+		static mc11s_seq_word_t loadWord(volatile mc11s_seq_word_t *w) { return *w; }
+		static void storeWord(volatile mc11s_seq_word_t *w, mc11s_seq_word_t v) { *w = v; }
+		static void fenceRelease(void) { __asm__ __volatile__("" ::: "memory"); }
+		static void fenceAcquire(void) { __asm__ __volatile__("" ::: "memory"); }
+#else
+		mc11s_seq_t loadSeq(void) { return __atomic_load_n(&_seq, __ATOMIC_RELAXED); }
+		mc11s_seq_t loadSeqAcquire(void) { return __atomic_load_n(&_seq, __ATOMIC_ACQUIRE); }
+		void storeSeq(mc11s_seq_t s) { __atomic_store_n(&_seq, s, __ATOMIC_RELEASE); }
+		static mc11s_seq_word_t loadWord(volatile mc11s_seq_word_t *w) { return __atomic_load_n(w, __ATOMIC_RELAXED); }
+		static void storeWord(volatile mc11s_seq_word_t *w, mc11s_seq_word_t v) { __atomic_store_n(w, v, __ATOMIC_RELAXED); }
+		static void fenceRelease(void) { __atomic_thread_fence(__ATOMIC_RELEASE); }
+		static void fenceAcquire(void) { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+#endif
+
+		volatile mc11s_seq_t _seq;
+		volatile mc11s_seq_word_t _data[WORDS];
+};
+
+typedef MC11S_Seqlock<mc11s_sample_t> MC11S_LatestSample;
+
+#endif
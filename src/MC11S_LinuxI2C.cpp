@@ -0,0 +1,179 @@
+#include "MC11S_LinuxI2C.h"
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#ifndef I2C_RDWR_IOCTL_MAX_MSGS
+#define I2C_RDWR_IOCTL_MAX_MSGS 42
+#endif
+
+// Register writes are staged behind the register address in one message
+#define kMaxWriteBuffer 128
+
+MC11S_LinuxI2C::MC11S_LinuxI2C(void) : _fd{-1}, deviceAddress{MC11S_I2C_ADDRESS}, _maxTransfer{MC11S_LINUX_I2C_MAX_MSG_LEN}, _transfers{0}
+{
+
+}
+
+MC11S_LinuxI2C::~MC11S_LinuxI2C(void)
+{
+    end();
+}
+
+bool MC11S_LinuxI2C::begin(const char *devPath, uint8_t devAddr)
+{
+    unsigned long funcs = 0;
+
+    end();
+
+    _fd = open(devPath, O_RDWR);
+    if (_fd < 0)
+        return false;
+
+    // Combined transactions need a real I2C adapter, SMBus-only ones can't do them
+    if (ioctl(_fd, I2C_FUNCS, &funcs) < 0 || !(funcs & I2C_FUNC_I2C))
+    {
+        end();
+        return false;
+    }
+
+    sensor.read_reg = MC11S_LinuxI2C::read;
+    sensor.write_reg = MC11S_LinuxI2C::write;
+    sensor.handle = this;
+    deviceAddress = devAddr;
+
+    // call super class begin -- it returns 0 on no error
+    return MC11S::begin() == 0;
+}
+
+void MC11S_LinuxI2C::end(void)
+{
+    if (_fd >= 0)
+        close(_fd);
+    _fd = -1;
+}
+
+void MC11S_LinuxI2C::setMaxTransfer(uint16_t len)
+{
+    // A register write needs room for the address plus one data byte
+    if (len < 2)
+        len = 2;
+    if (len > MC11S_LINUX_I2C_MAX_MSG_LEN)
+        len = MC11S_LINUX_I2C_MAX_MSG_LEN;
+    _maxTransfer = len;
+}
+
+uint16_t MC11S_LinuxI2C::getMaxTransfer(void)
+{
+    return _maxTransfer;
+}
+
+uint32_t MC11S_LinuxI2C::getTransferCount(void)
+{
+    return _transfers;
+}
+
+void MC11S_LinuxI2C::clearTransferCount(void)
+{
+    _transfers = 0;
+}
+
+int32_t MC11S_LinuxI2C::read(void* device, uint8_t addr, uint8_t* data, uint16_t numData)
+{
+    MC11S_LinuxI2C *dev = (MC11S_LinuxI2C*)device;
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    uint8_t regs[I2C_RDWR_IOCTL_MAX_MSGS / 2];
+    struct i2c_rdwr_ioctl_data xfer;
+
+    if (dev->_fd < 0)
+        return -1;
+
+    while (numData > 0)
+    {
+        uint32_t nMsgs = 0;
+
+        // Pack as many register-write + repeated-start-read pairs into the
+        // ioctl as the kernel allows; bursts longer than the adapter limit are
+        // split into chunks that each restart at their own register address
+        while (numData > 0 && nMsgs + 2 <= I2C_RDWR_IOCTL_MAX_MSGS)
+        {
+            uint16_t nChunk = numData > dev->_maxTransfer ? dev->_maxTransfer : numData;
+
+            regs[nMsgs / 2] = addr;
+
+            msgs[nMsgs].addr = dev->deviceAddress;
+            msgs[nMsgs].flags = 0;
+            msgs[nMsgs].len = 1;
+            msgs[nMsgs].buf = &regs[nMsgs / 2];
+
+            msgs[nMsgs + 1].addr = dev->deviceAddress;
+            msgs[nMsgs + 1].flags = I2C_M_RD;
+            msgs[nMsgs + 1].len = nChunk;
+            msgs[nMsgs + 1].buf = data;
+
+            nMsgs += 2;
+            addr += nChunk;
+            data += nChunk;
+            numData -= nChunk;
+        }
+
+        xfer.msgs = msgs;
+        xfer.nmsgs = nMsgs;
+
+        dev->_transfers++;
+        if (ioctl(dev->_fd, I2C_RDWR, &xfer) != (int)nMsgs)
+            return -1; // error with the combined transaction
+    }
+
+    return 0; // Success
+}
+
+int32_t MC11S_LinuxI2C::write(void* device, uint8_t addr, const uint8_t* data, uint16_t numData)
+{
+    MC11S_LinuxI2C *dev = (MC11S_LinuxI2C*)device;
+    uint8_t buff[kMaxWriteBuffer + 1];
+    struct i2c_msg msg;
+    struct i2c_rdwr_ioctl_data xfer;
+
+    if (dev->_fd < 0)
+        return -1;
+
+    do
+    {
+        uint16_t nChunk = numData;
+
+        if (nChunk > kMaxWriteBuffer)
+            nChunk = kMaxWriteBuffer;
+        if (nChunk > dev->_maxTransfer - 1)
+            nChunk = dev->_maxTransfer - 1;
+
+        buff[0] = addr;
+        memcpy(&buff[1], data, nChunk);
+
+        msg.addr = dev->deviceAddress;
+        msg.flags = 0;
+        msg.len = nChunk + 1;
+        msg.buf = buff;
+
+        xfer.msgs = &msg;
+        xfer.nmsgs = 1;
+
+        dev->_transfers++;
+        if (ioctl(dev->_fd, I2C_RDWR, &xfer) != 1)
+            return -1; // -1 = error, 0 = success
+
+        addr += nChunk;
+        data += nChunk;
+        numData -= nChunk;
+    } while (numData > 0);
+
+    return 0;
+}
+
+#endif /* __linux__ && !ARDUINO */
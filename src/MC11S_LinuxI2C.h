@@ -0,0 +1,52 @@
+/******************************************************************************
+This file defines the Linux i2c-dev transport for the MC11S. It lets the same
+MC11S class run on gateways (Raspberry Pi, BeagleBone, ...) that talk to the
+sensor through /dev/i2c-N instead of the Arduino Wire library.
+
+Every register read is issued as a single I2C_RDWR ioctl: a one byte register
+write followed by a repeated-start read, so the bus is never released between
+the address and the data phase and only one syscall is made per access.
+extras/i2c has an LD_PRELOAD interposer that puts a simulated MC11S behind
+an i2c-dev path, and a benchmark of the syscalls per operation.
+
+Development environment specifics:
+    Toolchain: g++ (C++11), Linux kernel headers
+    Hardware Platform: Raspberry Pi 4
+    MC11S Breakout Version: 1.0.0
+******************************************************************************/
+#ifndef __MC11S_LinuxI2C_H__
+#define __MC11S_LinuxI2C_H__
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include "MC11S_class.h"
+
+// Largest single message accepted by the i2c-dev I2C_RDWR ioctl
+#define MC11S_LINUX_I2C_MAX_MSG_LEN		8192
+
+class MC11S_LinuxI2C : public MC11S
+{
+    public:
+        MC11S_LinuxI2C(void);
+        ~MC11S_LinuxI2C(void);
+
+        bool begin(const char *devPath = "/dev/i2c-1", uint8_t devAddr = MC11S_I2C_ADDRESS);
+        void end(void);
+
+        void setMaxTransfer(uint16_t len);		// Limits the bytes moved per message (adapter quirks)
+        uint16_t getMaxTransfer(void);
+        uint32_t getTransferCount(void);		// Number of I2C_RDWR ioctls issued so far
+        void clearTransferCount(void);
+
+        static int32_t read(void *, uint8_t, uint8_t *, uint16_t);
+        static int32_t write(void *, uint8_t, const uint8_t *, uint16_t);
+    private:
+        int _fd;
+        uint8_t deviceAddress;
+        uint16_t _maxTransfer;
+        uint32_t _transfers;
+};
+
+#endif /* __linux__ && !ARDUINO */
+
+#endif
@@ -0,0 +1,262 @@
+#include "MC11S_LowPower.h"
+
+MC11S_WakeOnAlert::MC11S_WakeOnAlert(void) : _sensor{nullptr}, _wakes{0}, _followConv{false}
+{
+	_last.ch0 = 0;
+	_last.ch1 = 0;
+	*(uint8_t *)&_last.status = 0;
+}
+
+/**
+ * @brief  			Puts the MC11S into wake-on-alert operation: INTB enabled in
+ * 					alarm mode and continuous conversions every period. TRH/TRL
+ * 					(setAlarmRatio()) may be programmed before or after.
+ * @param	sensor	Device to run
+ * @param	period	Time between conversions; the longer, the less the chip draws
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_WakeOnAlert::begin(MC11S *sensor, mc11s_conv_time_status_t period) {
+	int32_t ret;
+
+	_sensor = sensor;
+	_wakes = 0;
+	_followConv = false;
+	*(uint8_t *)&_last.status = 0;
+
+	// Step 1: Stop Conversion while the configuration changes
+	ret = _sensor->setConvMode(MC11S_STOP_CONV);
+
+	// Step 2: INTB follows ALERT
+	ret += _sensor->setIntbStatus(MC11S_INTB_ENABLE);
+	ret += _sensor->setIntbMode(MC11S_INTB_ALARM);
+
+	// Step 3: Conversion period
+	ret += _sensor->setConvTime(period);
+
+	// Step 4: Start Continuous conversion
+	ret += _sensor->setConvMode(MC11S_CONT_CONV);
+
+	return ret;
+}
+
+/**
+ * @brief  	Leaves wake-on-alert operation: conversions stop and INTB is released
+ * @retval  Error code (0 -> no Error)
+ */
+int32_t MC11S_WakeOnAlert::end(void) {
+	int32_t ret;
+
+	if (_sensor == nullptr)
+		return -1;
+
+	ret = _sensor->setConvMode(MC11S_STOP_CONV);
+	ret += _sensor->setIntbStatus(MC11S_INTB_DISABLE);
+	ret += _sensor->setIntbMode(MC11S_INTB_ALARM);
+	_followConv = false;
+
+	return ret;
+}
+
+/**
+ * @brief  			Call once per wake-up: reads STATUS and both channels. When
+ * 					ALERT has just set or cleared it also switches INTB between
+ * 					the conversion and the alarm mode, one more write.
+ * @param	sample	Counts and STATUS that raised INTB
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_WakeOnAlert::service(mc11s_wake_sample_t *sample) {
+	int32_t ret;
+
+	if (_sensor == nullptr)
+		return -1;
+
+	ret = _sensor->getStatusData(&_last.status, &_last.ch0, &_last.ch1);
+	_wakes++;
+
+	// In alarm mode INTB would stay low until ALERT clears: wake once per conversion instead
+	if (ret == 0 && (_last.status.alert != 0) != _followConv) {
+		_followConv = !_followConv;
+		ret = _sensor->setIntbMode(_followConv ? MC11S_INTB_CONV : MC11S_INTB_ALARM);
+	}
+
+	*sample = _last;
+
+	return ret;
+}
+
+bool MC11S_WakeOnAlert::inAlarm(void) {
+	return _last.status.alert != 0;
+}
+
+uint32_t MC11S_WakeOnAlert::getWakeCount(void) {
+	return _wakes;
+}
+
+MC11S_EnergyModel::MC11S_EnergyModel(void)
+{
+	setChipCurrent(100.0f, 1.0f);
+	setMcuCurrent(5000.0f, 5.0f);
+	setBus(100000, 700.0f);		// 3.3 V over 4.7 kOhm
+	setClock(MC11S_INT_CLK_HZ);
+	setConversion(MC11S_CONV_60S, MC11S_DRIVE_I_200uA, 1024, 0x20, 0);
+	setWakeups(0, 0, 0, 0);
+}
+
+void MC11S_EnergyModel::setChipCurrent(float activeUA, float standbyUA) {
+	_chipActive = activeUA;
+	_chipStandby = standbyUA;
+}
+
+void MC11S_EnergyModel::setMcuCurrent(float activeUA, float sleepUA) {
+	_mcuActive = activeUA;
+	_mcuSleep = sleepUA;
+}
+
+void MC11S_EnergyModel::setBus(uint32_t sclHz, float pullupUA) {
+	_scl = sclHz ? sclHz : 1;
+	_pullup = pullupUA;
+}
+
+void MC11S_EnergyModel::setClock(uint32_t fclkHz) {
+	_fclk = fclkHz ? fclkHz : 1;
+}
+
+/**
+ * @brief  			Conversion settings the estimate is made for
+ * @param	period		CR, time between conversions
+ * @param	drive		Sensor drive current
+ * @param	rcnt		RCNT
+ * @param	scnt		SCNT
+ * @param	frefDiv		FREF_DIV register value (divider - 1)
+ * @param	channels	Channels enabled
+ */
+void MC11S_EnergyModel::setConversion(mc11s_conv_time_status_t period, mc11s_drive_i_status_t drive,
+									  uint16_t rcnt, uint8_t scnt, uint8_t frefDiv, uint8_t channels) {
+	mc11s_conv_time_ms_get(period, &_periodMs);
+	mc11s_drive_i_ua_get(drive, &_driveUA);
+	_rcnt = rcnt;
+	_scnt = scnt;
+	_frefDiv = frefDiv;
+	_channels = channels;
+}
+
+/**
+ * @brief  			Reads CR, DRIVE_I, RCNT, SCNT, FREF_DIV and CH_EN from the device
+ * @param	sensor	Device to model
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_EnergyModel::readConversion(MC11S *sensor) {
+	mc11s_conv_time_status_t period;
+	mc11s_drive_i_status_t drive;
+	mc11s_ch_en_status_t ch0, ch1;
+	uint16_t rcnt;
+	uint8_t scnt, frefDiv;
+	int32_t ret;
+
+	ret = sensor->getConvTime(&period);
+	ret += sensor->getDriveCurrent(&drive);
+	ret += sensor->getRcnt(&rcnt);
+	ret += sensor->getScnt(&scnt);
+	ret += sensor->getFrefDiv(&frefDiv);
+	ret += sensor->getCh0En(&ch0);
+	ret += sensor->getCh1En(&ch1);
+
+	if (ret == 0) {
+		setClock(sensor->getRefClock());
+		setConversion(period, drive, rcnt, scnt, frefDiv, (ch0 == MC11S_CH_ENABLE) + (ch1 == MC11S_CH_ENABLE));
+	}
+
+	return ret;
+}
+
+/**
+ * @brief  			How often the MCU wakes up and what it does on the bus each time.
+ * 					Wake-on-alert: alerts per hour, MC11S_WAKE_READS reads of
+ * 					MC11S_WAKE_READ_BYTES in all. Polling: conversions per hour and
+ * 					whatever the loop reads per sample.
+ * @param	perHour			Wake-ups per hour
+ * @param	transactions	I2C transactions per wake-up
+ * @param	bytes			Data bytes moved per wake-up
+ * @param	awakeSeconds	Time awake per wake-up besides the bus (start-up, processing)
+ */
+void MC11S_EnergyModel::setWakeups(float perHour, uint8_t transactions, uint16_t bytes, float awakeSeconds) {
+	_wakesPerHour = perHour;
+	_transactions = transactions;
+	_bytes = bytes;
+	_awake = awakeSeconds;
+}
+
+/**
+ * @brief  	Time the MC11S spends converting per conversion: each enabled channel
+ * 			settles for SCNT and counts for RCNT reference periods,
+ * 			Fref = Fclk / (FREF_DIV + 1)
+ * @retval  Seconds
+ */
+float MC11S_EnergyModel::getActiveTime(void) {
+	return (float)_channels * ((float)_rcnt + _scnt) * (_frefDiv + 1) / _fclk;
+}
+
+/**
+ * @brief  	Charge one conversion draws on top of standby: core and drive
+ * 			current while converting
+ * @retval  uA*s
+ */
+float MC11S_EnergyModel::getConversionCharge(void) {
+	return getActiveTime() * (_chipActive + _driveUA - _chipStandby);
+}
+
+/**
+ * @brief  			Charge of one bus transaction on top of sleep: pull-ups and the
+ * 					MCU awake for its duration. Used for reconfiguration writes.
+ * @param	bytes	Data bytes moved
+ * @retval  		uA*s
+ */
+float MC11S_EnergyModel::getTransactionCharge(uint16_t bytes) {
+	return busTime(1, bytes) * (_pullup + _mcuActive - _mcuSleep);
+}
+
+/**
+ * @brief  	Charge of one wake-up as described by setWakeups() on top of sleep
+ * @retval  uA*s
+ */
+float MC11S_EnergyModel::getWakeCharge(void) {
+	float t = busTime(_transactions, _bytes);
+
+	return t * _pullup + (t + _awake) * (_mcuActive - _mcuSleep);
+}
+
+/**
+ * @brief  			Charge drawn per hour, split by where it goes
+ * @param	charge	uAh per hour for each contributor and the total
+ */
+void MC11S_EnergyModel::estimate(mc11s_charge_t *charge) {
+	float convPerHour, activeFraction, busSeconds, awakeFraction;
+
+	convPerHour = _periodMs ? 3600000.0f / _periodMs : 0;
+	activeFraction = convPerHour * getActiveTime() / 3600.0f;
+	if (activeFraction > 1.0f)
+		activeFraction = 1.0f;
+
+	busSeconds = busTime(_transactions, _bytes);
+
+	awakeFraction = _wakesPerHour * (busSeconds + _awake) / 3600.0f;
+	if (awakeFraction > 1.0f)
+		awakeFraction = 1.0f;
+
+	charge->convert = _chipActive * activeFraction;
+	charge->drive = _driveUA * activeFraction;
+	charge->standby = _chipStandby * (1.0f - activeFraction);
+	// SCL and SDA are each low about half the time, so one pull-up's worth flows
+	charge->bus = _pullup * _wakesPerHour * busSeconds / 3600.0f;
+	charge->mcu = _mcuActive * awakeFraction + _mcuSleep * (1.0f - awakeFraction);
+	charge->total = charge->convert + charge->drive + charge->standby + charge->bus + charge->mcu;
+}
+
+/**
+ * @brief  	Time on the bus: a transaction is the address, register and repeated
+ * 			start address bytes plus the data, 9 clocks each, and about 2 for
+ * 			START/STOP
+ */
+float MC11S_EnergyModel::busTime(uint8_t transactions, uint16_t bytes) {
+	return ((float)transactions * (3 * 9 + 2) + (float)bytes * 9) / _scl;
+}
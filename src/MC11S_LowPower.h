@@ -0,0 +1,117 @@
+/******************************************************************************
+This file defines the wake-on-alert power mode and the energy model used to
+size batteries for it.
+
+In wake-on-alert mode the MC11S does the detection on its own: it converts
+every CR period (MC11S_CONV_*) in continuous mode, compares each result with
+TRH/TRL and pulls INTB low only when ALERT is set (MC11S_INTB_ALARM). The MCU
+sleeps until INTB fires, reads STATUS and both channels, acts on it and goes
+back to sleep. Nothing touches the bus while the level is normal.
+
+  MC11S_WakeOnAlert    puts the sensor into that mode and services a wake-up
+  MC11S_EnergyModel    estimates the charge drawn per hour from the
+                       conversion period, the drive current, the time the
+                       MC11S spends converting and the bus transactions the
+                       MCU makes, so polling and wake-on-alert can be compared
+                       before anything is built
+
+The model's default currents are round numbers of the right order, not
+datasheet figures: replace them with the ones measured on your board.
+
+INTB is a level output in alarm mode and stays low for as long as ALERT is
+set. So that the MCU can keep sleeping through an alarm, service() switches
+INTB to the conversion mode (MC11S_INTB_CONV) when ALERT sets: INTB then
+goes low once per conversion and is released by the STATUS read of the next
+service(). It goes back to alarm mode once ALERT clears. Either way the MCU
+sleeps until INTB is low and calls service() on every wake-up (see
+Example4_WakeOnAlert).
+
+Development environment specifics:
+    IDE: Arduino 2.1.0
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_LowPower_H__
+#define __MC11S_LowPower_H__
+
+#include "MC11S_class.h"
+
+// Bus reads on every wake-up: STATUS (1 byte), then both channels (4 bytes)
+#define MC11S_WAKE_READS			2
+#define MC11S_WAKE_READ_BYTES		5
+
+typedef struct {
+	uint16_t ch0;
+	uint16_t ch1;
+	mc11s_status_t status;
+} mc11s_wake_sample_t;
+
+class MC11S_WakeOnAlert {
+	public:
+		MC11S_WakeOnAlert(void);
+
+		int32_t begin(MC11S *sensor, mc11s_conv_time_status_t period = MC11S_CONV_60S);	// Starts alarm-mode conversions
+		int32_t end(void);									// Stops conversions and disables INTB
+
+		int32_t service(mc11s_wake_sample_t *sample);		// Reads the sample after INTB woke the MCU
+		bool inAlarm(void);									// ALERT as of the last service()
+		uint32_t getWakeCount(void);
+
+	private:
+		MC11S *_sensor;
+		mc11s_wake_sample_t _last;
+		uint32_t _wakes;
+		bool _followConv;									// INTB in conversion mode while ALERT holds
+};
+
+typedef struct {
+	float convert;		// MC11S core while converting
+	float drive;		// Sensor drive current while converting
+	float standby;		// MC11S between conversions
+	float bus;			// I2C pull-ups during transactions
+	float mcu;			// MCU awake and asleep
+	float total;
+} mc11s_charge_t;		// All in uAh per hour, i.e. average uA
+
+class MC11S_EnergyModel {
+	public:
+		MC11S_EnergyModel(void);
+
+		void setChipCurrent(float activeUA, float standbyUA);	// MC11S supply current converting / idle
+		void setMcuCurrent(float activeUA, float sleepUA);		// MCU supply current awake / asleep
+		void setBus(uint32_t sclHz, float pullupUA);			// SCL rate, current through one pull-up when low
+		void setClock(uint32_t fclkHz);							// MC11S reference clock
+
+		void setConversion(mc11s_conv_time_status_t period, mc11s_drive_i_status_t drive,
+						   uint16_t rcnt, uint8_t scnt, uint8_t frefDiv, uint8_t channels = 2);
+		int32_t readConversion(MC11S *sensor);					// Takes the conversion settings from the device
+
+		// MCU wake-ups per hour, bus transactions and bytes per wake-up, time awake besides the bus
+		void setWakeups(float perHour, uint8_t transactions, uint16_t bytes, float awakeSeconds = 0.002f);
+
+		float getActiveTime(void);								// Seconds converting per conversion
+		float getConversionCharge(void);						// uA*s drawn by one conversion
+		float getTransactionCharge(uint16_t bytes);				// uA*s for one bus transaction, MCU included
+		float getWakeCharge(void);								// uA*s for one wake-up as set by setWakeups()
+		void estimate(mc11s_charge_t *charge);
+
+	private:
+		float busTime(uint8_t transactions, uint16_t bytes);
+
+		float _chipActive, _chipStandby;
+		float _mcuActive, _mcuSleep;
+		uint32_t _scl;
+		float _pullup;
+		uint32_t _fclk;
+
+		uint32_t _periodMs;
+		uint16_t _driveUA;
+		uint16_t _rcnt;
+		uint8_t _scnt, _frefDiv, _channels;
+
+		float _wakesPerHour;
+		uint8_t _transactions;
+		uint16_t _bytes;
+		float _awake;
+};
+
+#endif
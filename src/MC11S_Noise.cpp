@@ -0,0 +1,297 @@
+#include "MC11S_Noise.h"
+#include "MC11S_Stats.h"
+#include "MC11S_Time.h"
+#include <math.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+MC11S_NoiseSweep::MC11S_NoiseSweep(void) :
+	_rcnt{NULL}, _finDiv{NULL}, _drive{NULL},
+	_rcntCount{0}, _finDivCount{0}, _driveCount{0},
+	_glitchBoth{false}, _samples{64}, _format{MC11S_SWEEP_CSV},
+#if MC11S_HAS_MICROS
+	_timebase{mc11s_micros},
+#else
+	_timebase{NULL},
+#endif
+	_maxConvUs{0}, _bestValid{false}
+{
+}
+
+void MC11S_NoiseSweep::setRcnt(const uint16_t *values, uint8_t count) {
+	_rcnt = values;
+	_rcntCount = values ? count : 0;
+}
+
+void MC11S_NoiseSweep::setFinDiv(const mc11s_fin_div_val_t *values, uint8_t count) {
+	_finDiv = values;
+	_finDivCount = values ? count : 0;
+}
+
+void MC11S_NoiseSweep::setDrive(const mc11s_drive_i_status_t *values, uint8_t count) {
+	_drive = values;
+	_driveCount = values ? count : 0;
+}
+
+void MC11S_NoiseSweep::setGlitchSweep(bool both) {
+	_glitchBoth = both;
+}
+
+void MC11S_NoiseSweep::setSamples(uint16_t n) {
+	_samples = n ? n : 1;
+}
+
+void MC11S_NoiseSweep::setFormat(mc11s_sweep_format_t format) {
+	_format = format;
+}
+
+void MC11S_NoiseSweep::setTimebase(unsigned long (*us)(void)) {
+	_timebase = us;
+}
+
+void MC11S_NoiseSweep::setMaxConvTime(uint32_t us) {
+	_maxConvUs = us;
+}
+
+uint16_t MC11S_NoiseSweep::getPointCount(void) {
+	return (uint16_t)(_rcntCount ? _rcntCount : 1) * (_finDivCount ? _finDivCount : 1) *
+		   (_driveCount ? _driveCount : 1) * (_glitchBoth ? 2 : 1);
+}
+
+/**
+ * @brief  			Characterises the current settings: drops one conversion, then
+ * 					takes the configured number of single conversions and works out
+ * 					the noise and throughput
+ * @param	sensor	Device, at a steady input
+ * @param	point	Settings and results
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_NoiseSweep::measure(MC11S *sensor, mc11s_noise_point_t *point) {
+	MC11S_RunningStats<uint16_t> stats[2];
+	mc11s_ch_en_status_t en0, en1;
+	mc11s_status_t status;
+	uint16_t ch[2], n;
+	uint8_t scnt, frefDiv, channels, i;
+	unsigned long start = 0;
+	int32_t ret;
+
+	ret = sensor->getRcnt(&point->rcnt);
+	ret += sensor->getFinDiv(&point->fin_div);
+	ret += sensor->getDriveCurrent(&point->drive);
+	ret += sensor->getGlitchFilter(&point->glitch);
+	ret += sensor->getScnt(&scnt);
+	ret += sensor->getFrefDiv(&frefDiv);
+	ret += sensor->getCh0En(&en0);
+	ret += sensor->getCh1En(&en1);
+	if (ret != 0)
+		return ret;
+
+	channels = (en0 == MC11S_CH_ENABLE) + (en1 == MC11S_CH_ENABLE);
+	point->conv_us = (uint32_t)(channels * ((float)scnt + point->rcnt) * (frefDiv + 1) * 1e6f / sensor->getRefClock());
+	point->overflows = 0;
+
+	// The first conversion after a change of settings is still settling, as in calibrateClock()
+	ret = sensor->singleConversion(&ch[0], &ch[1], &status);
+	if (ret != 0)
+		return ret;
+
+	if (_timebase)
+		start = _timebase();
+
+	for (n = 0; n < _samples; n++) {
+		if (sensor->singleConversion(&ch[0], &ch[1], &status) != 0 ||
+			ch[0] == 0xFFFF || ch[1] == 0xFFFF) {
+			point->overflows++;
+			continue;
+		}
+
+		stats[0].add(ch[0]);
+		stats[1].add(ch[1]);
+	}
+
+	point->sample_us = _timebase ? (uint32_t)(_timebase() - start) / _samples : 0;
+	point->samples = (uint16_t)stats[0].getCount();
+
+	for (i = 0; i < 2; i++) {
+		// Quantisation alone leaves 1/sqrt(12) counts of noise
+		float sd = stats[i].getStdDev();
+		float qNoise = 0.28867513f;
+
+		point->mean[i] = stats[i].getMean();
+		point->sd[i] = sd;
+		point->pp[i] = stats[i].getPeakToPeak();
+		point->enob[i] = (point->mean[i] >= 1.0f) ?
+						 log2f(point->mean[i] / ((sd > qNoise ? sd : qNoise) * 3.4641016f)) : 0;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief  			Measures every point of the sweep and writes the table
+ * @param	sensor	Device, at a steady input
+ * @param	out		Where the header and one row per point go
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_NoiseSweep::run(MC11S *sensor, Print &out) {
+	mc11s_conv_mode_status_t mode;
+	mc11s_noise_point_t point;
+	uint16_t rcnt;
+	mc11s_fin_div_val_t finDiv;
+	mc11s_drive_i_status_t drive;
+	mc11s_glitch_filter_status_t glitch;
+	uint8_t r, f, d, g;
+	int32_t ret;
+
+	ret = sensor->getConvMode(&mode);
+	ret += sensor->getRcnt(&rcnt);
+	ret += sensor->getFinDiv(&finDiv);
+	ret += sensor->getDriveCurrent(&drive);
+	ret += sensor->getGlitchFilter(&glitch);
+	if (ret != 0)
+		return ret;
+
+	_bestValid = false;
+	writeHeader(out, _format);
+
+	ret = sensor->setConvMode(MC11S_STOP_CONV);
+
+	for (r = 0; r < (_rcntCount ? _rcntCount : 1) && ret == 0; r++) {
+		for (f = 0; f < (_finDivCount ? _finDivCount : 1) && ret == 0; f++) {
+			for (d = 0; d < (_driveCount ? _driveCount : 1) && ret == 0; d++) {
+				for (g = 0; g < (_glitchBoth ? 2 : 1) && ret == 0; g++) {
+					ret = sensor->setRcnt(_rcntCount ? _rcnt[r] : rcnt);
+					ret += sensor->setFinDiv(_finDivCount ? _finDiv[f] : finDiv);
+					ret += sensor->setDriveCurrent(_driveCount ? _drive[d] : drive);
+					ret += sensor->setGlitchFilter(_glitchBoth ? (mc11s_glitch_filter_status_t)g : glitch);
+					ret += measure(sensor, &point);
+					if (ret != 0)
+						break;
+
+					writePoint(out, _format, point);
+
+					if (point.samples == 0 || (_maxConvUs && point.conv_us > _maxConvUs))
+						continue;
+
+					float worst = point.enob[0] < point.enob[1] ? point.enob[0] : point.enob[1];
+					bool better = !_bestValid;
+
+					if (_bestValid) {
+						float bestWorst = _best.enob[0] < _best.enob[1] ? _best.enob[0] : _best.enob[1];
+
+						// More bits wins, within 0.05 bits the faster one
+						better = worst > bestWorst + 0.05f ||
+								 (worst > bestWorst - 0.05f && point.conv_us < _best.conv_us);
+					}
+
+					if (better) {
+						_best = point;
+						_bestValid = true;
+					}
+				}
+			}
+		}
+	}
+
+	ret += sensor->setRcnt(rcnt);
+	ret += sensor->setFinDiv(finDiv);
+	ret += sensor->setDriveCurrent(drive);
+	ret += sensor->setGlitchFilter(glitch);
+	ret += sensor->setConvMode(mode);
+
+	return ret;
+}
+
+/**
+ * @brief  			Best point of the last run(): the most effective bits on the
+ * 					worse channel within the conversion time budget, the faster
+ * 					setting when two are within 0.05 bits
+ * @param	best	Settings and results
+ * @retval  		false if no point qualified
+ */
+bool MC11S_NoiseSweep::getBest(mc11s_noise_point_t *best) {
+	if (_bestValid)
+		*best = _best;
+	return _bestValid;
+}
+
+static size_t mc11s_sweep_put16(Print &out, uint16_t v) {
+	uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+	return out.write(b, 2);
+}
+
+static size_t mc11s_sweep_put32(Print &out, uint32_t v) {
+	uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+	return out.write(b, 4);
+}
+
+static uint16_t mc11s_sweep_fixed(float v, float scale, uint16_t max) {
+	v = v * scale + 0.5f;
+	return (v <= 0) ? 0 : (v >= max) ? max : (uint16_t)v;
+}
+
+size_t MC11S_NoiseSweep::writeHeader(Print &out, mc11s_sweep_format_t format) {
+	if (format == MC11S_SWEEP_BINARY) {
+		const uint8_t header[5] = { 'M', 'N', 'S', MC11S_SWEEP_VERSION, MC11S_SWEEP_RECORD_LEN };
+		return out.write(header, sizeof(header));
+	}
+
+	return out.println("rcnt,fin_div,drive_ua,glitch,samples,overflows,"
+					   "mean0,sd0,pp0,enob0,mean1,sd1,pp1,enob1,conv_us,sample_us");
+}
+
+size_t MC11S_NoiseSweep::writePoint(Print &out, mc11s_sweep_format_t format, const mc11s_noise_point_t &point) {
+	size_t n = 0;
+	uint16_t Idrv;
+	uint8_t i;
+
+	if (format == MC11S_SWEEP_BINARY) {
+		n += mc11s_sweep_put16(out, point.rcnt);
+		n += out.write((uint8_t)point.fin_div);
+		n += out.write((uint8_t)point.drive);
+		n += out.write((uint8_t)point.glitch);
+		n += mc11s_sweep_put16(out, point.samples);
+		n += mc11s_sweep_put16(out, point.overflows);
+		for (i = 0; i < 2; i++) {
+			n += mc11s_sweep_put16(out, mc11s_sweep_fixed(point.mean[i], 1, 0xFFFF));
+			n += mc11s_sweep_put16(out, mc11s_sweep_fixed(point.sd[i], 256, 0xFFFF));
+			n += mc11s_sweep_put16(out, point.pp[i]);
+			n += out.write((uint8_t)mc11s_sweep_fixed(point.enob[i], 16, 0xFF));
+		}
+		n += mc11s_sweep_put32(out, point.conv_us);
+		n += mc11s_sweep_put32(out, point.sample_us);
+		return n;
+	}
+
+	mc11s_drive_i_ua_get(point.drive, &Idrv);
+
+	n += out.print(point.rcnt);
+	n += out.print(',');
+	n += out.print(1UL << point.fin_div);
+	n += out.print(',');
+	n += out.print(Idrv);
+	n += out.print(',');
+	n += out.print((uint8_t)point.glitch);
+	n += out.print(',');
+	n += out.print(point.samples);
+	n += out.print(',');
+	n += out.print(point.overflows);
+	for (i = 0; i < 2; i++) {
+		n += out.print(',');
+		n += out.print(point.mean[i], 1);
+		n += out.print(',');
+		n += out.print(point.sd[i], 2);
+		n += out.print(',');
+		n += out.print(point.pp[i]);
+		n += out.print(',');
+		n += out.print(point.enob[i], 2);
+	}
+	n += out.print(',');
+	n += out.print(point.conv_us);
+	n += out.print(',');
+	n += out.println(point.sample_us);
+
+	return n;
+}
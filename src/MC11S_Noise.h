@@ -0,0 +1,105 @@
+/******************************************************************************
+This file defines the noise characterisation sweep. It steps the MC11S
+through every combination of the RCNT, FIN_DIV, drive current and glitch
+filter settings it is given, takes N single conversions at each point and
+reports per channel:
+
+    mean, sd, pp   mean, standard deviation and peak-to-peak of the counts
+    enob           effective bits, log2(mean / (sd * sqrt(12))): the bits a
+                   noiseless converter with the same spread of quantisation
+                   error would resolve. sd is floored at the quantisation
+                   noise 1/sqrt(12), so a perfectly steady count gives
+                   log2(mean).
+
+and the throughput: the predicted conversion time and, with a timebase, the
+measured time per sample (bus traffic and polling included).
+
+The results are written as they are measured, one row per point, either as
+CSV or as a compact little-endian binary table:
+
+    header   'M' 'N' 'S' version record_length
+    record   u16 rcnt, u8 fin_div, u8 drive, u8 glitch, u16 samples,
+             u16 overflows, per channel { u16 mean, u16 sd (Q8.8),
+             u16 pp, u8 enob (Q4.4) }, u32 conv_us, u32 sample_us
+
+Conversions that saturate (0xFFFF) or time out are counted as overflows and
+left out of the statistics. The sensor settings are restored afterwards.
+
+Run it with a probe at a fixed level against real hardware, or against
+MC11S_Sim with setNoise() on a host; getBest() then gives the setting with
+the most effective bits within a conversion time budget, which is the
+data-driven default for that probe.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Noise_H__
+#define __MC11S_Noise_H__
+
+#include "MC11S_class.h"
+#include "MC11S_Print.h"
+
+#define MC11S_SWEEP_VERSION			1
+#define MC11S_SWEEP_RECORD_LEN		31
+
+typedef enum {
+	MC11S_SWEEP_CSV = 0,
+	MC11S_SWEEP_BINARY = 1,
+} mc11s_sweep_format_t;
+
+typedef struct {
+	uint16_t rcnt;
+	mc11s_fin_div_val_t fin_div;
+	mc11s_drive_i_status_t drive;
+	mc11s_glitch_filter_status_t glitch;
+	uint16_t samples;		// Conversions in the statistics
+	uint16_t overflows;		// Conversions that saturated or timed out
+	float mean[2];
+	float sd[2];
+	uint16_t pp[2];
+	float enob[2];
+	uint32_t conv_us;		// Predicted conversion time of the enabled channels
+	uint32_t sample_us;		// Measured time per sample (0 -> no timebase)
+} mc11s_noise_point_t;
+
+class MC11S_NoiseSweep {
+	public:
+		MC11S_NoiseSweep(void);
+
+		// Values to step through, an empty list keeps the device's setting
+		void setRcnt(const uint16_t *values, uint8_t count);
+		void setFinDiv(const mc11s_fin_div_val_t *values, uint8_t count);
+		void setDrive(const mc11s_drive_i_status_t *values, uint8_t count);
+		void setGlitchSweep(bool both);					// true -> every point with the filter off and on
+
+		void setSamples(uint16_t n);					// Conversions per point
+		void setFormat(mc11s_sweep_format_t format);
+		void setTimebase(unsigned long (*us)(void));	// e.g. micros (default mc11s_micros on Arduino and Linux), NULL -> none
+		void setMaxConvTime(uint32_t us);				// Budget for getBest() (0 -> any)
+
+		uint16_t getPointCount(void);
+
+		int32_t measure(MC11S *sensor, mc11s_noise_point_t *point);	// One point at the current settings
+		int32_t run(MC11S *sensor, Print &out);			// The whole sweep, reported to out
+		bool getBest(mc11s_noise_point_t *best);		// Most effective bits on the worse channel
+
+		static size_t writeHeader(Print &out, mc11s_sweep_format_t format);
+		static size_t writePoint(Print &out, mc11s_sweep_format_t format, const mc11s_noise_point_t &point);
+
+	private:
+		const uint16_t *_rcnt;
+		const mc11s_fin_div_val_t *_finDiv;
+		const mc11s_drive_i_status_t *_drive;
+		uint8_t _rcntCount, _finDivCount, _driveCount;
+		bool _glitchBoth;
+		uint16_t _samples;
+		mc11s_sweep_format_t _format;
+		unsigned long (*_timebase)(void);
+		uint32_t _maxConvUs;
+
+		mc11s_noise_point_t _best;
+		bool _bestValid;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "MC11S_Planner.h"
+
+/**
+ * @brief  			Runs the planner over every drive current, FIN_DIV and FREF_DIV and
+ * 					returns the n best plans that meet the request, best first
+ * @param	req		What the probe needs
+ * @param	plans	Room for n plans
+ * @param	n		Number of plans wanted
+ * @retval  		Number of plans returned
+ */
+uint8_t mc11s_plan_rank(const mc11s_plan_req_t &req, mc11s_plan_t *plans, uint8_t n) {
+	uint8_t count = 0;
+	uint16_t frefDiv;
+	uint8_t finDiv, drive, i;
+
+	if (n == 0 || plans == NULL)
+		return 0;
+
+	for (frefDiv = 0; frefDiv <= 0xFF; frefDiv++) {
+		for (finDiv = MC11S_FIN_DIV_2; finDiv <= MC11S_FIN_DIV_256; finDiv++) {
+			for (drive = MC11S_DRIVE_I_200uA; drive <= MC11S_DRIVE_I_3mA2_1; drive++) {
+				mc11s_plan_t plan = mc11s_plan_for(req, (mc11s_drive_i_status_t)drive,
+												   (mc11s_fin_div_val_t)finDiv, (uint8_t)frefDiv);
+
+				if (!mc11s_plan_valid(req, plan))
+					continue;
+
+				// Insertion into the sorted list, dropping the worst when full
+				if (count == n && !mc11s_plan_better(plan, plans[n - 1]))
+					continue;
+				if (count < n)
+					count++;
+
+				for (i = count - 1; i > 0 && mc11s_plan_better(plan, plans[i - 1]); i--)
+					plans[i] = plans[i - 1];
+				plans[i] = plan;
+			}
+		}
+	}
+
+	return count;
+}
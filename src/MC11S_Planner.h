@@ -0,0 +1,176 @@
+/******************************************************************************
+This file defines the resolution/latency planner. Given what a probe needs
+(sample period, counts per sample, the range of capacitance it will see and
+its settle count) it works out which combinations of drive current,
+FIN_DIV, FREF_DIV and RCNT can deliver it, and predicts for each one:
+
+    conv_time    seconds for one conversion of the enabled channels
+    counts_min   counts at the largest capacitance, i.e. the resolution
+    counts_max   counts at the smallest capacitance, must stay below 0xFFFF
+    current      average supply current over the sample period, in uA:
+                 drive current plus the core current while converting
+
+from the same relations the driver converts with:
+
+    Fsensor = K * Idrv / C               (Idrv in uA, C in pF -> MHz)
+    counts  = Fsensor / FIN_DIV * RCNT / Fref,  Fref = Fclk / (FREF_DIV + 1)
+    time    = channels * (SCNT + RCNT) / Fref
+
+For each drive/FIN_DIV/FREF_DIV the shortest RCNT that meets the resolution
+is used. Plans are ranked by current, then by conversion time.
+
+SCNT is not searched: it doesn't change the counts, and any SCNT above what
+the probe needs to settle only lengthens the conversion and adds current.
+So the best plan always uses exactly the settle count given in the request.
+Note that SCNT counts Fref periods, so a larger FREF_DIV settles longer for
+the same SCNT.
+
+Everything except mc11s_plan_rank() is C++11 constexpr, so a fixed profile
+can be checked when the sketch is compiled:
+
+    constexpr mc11s_plan_req_t tank = { 1.0f, 20000, 80, 160, 0x20, 2, MC11S_INT_CLK_HZ, 100 };
+    constexpr mc11s_plan_t plan = mc11s_plan_for(tank, MC11S_DRIVE_I_3mA2_1, MC11S_FIN_DIV_4, 0);
+    static_assert(mc11s_plan_valid(tank, plan), "tank profile can't reach 20000 counts");
+
+and mc11s_plan_best() searches all of them at compile time. The same
+functions run on the board or in host tools.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Planner_H__
+#define __MC11S_Planner_H__
+
+#include "mc11s_api/mc11s_reg.h"
+
+typedef struct {
+	float period;			// Seconds between samples
+	float min_counts;		// Counts required at the largest capacitance
+	float c_min;			// Smallest capacitance on either channel, pF
+	float c_max;			// Largest capacitance on either channel, pF
+	uint8_t scnt;			// Settle count the probe needs
+	uint8_t channels;		// Channels enabled
+	uint32_t fclk;			// Reference clock, Hz
+	float core;				// MC11S supply current while converting, uA (0 -> drive only)
+} mc11s_plan_req_t;
+
+typedef struct {
+	mc11s_drive_i_status_t drive;
+	mc11s_fin_div_val_t fin_div;
+	uint8_t fref_div;
+	uint8_t scnt;
+	uint16_t rcnt;			// 0 -> no RCNT meets the request
+	float conv_time;
+	float counts_min;
+	float counts_max;
+	float current;
+} mc11s_plan_t;
+
+constexpr uint16_t mc11s_plan_drive_ua(mc11s_drive_i_status_t drive) {
+	return drive == MC11S_DRIVE_I_200uA ? 200 :
+		   drive == MC11S_DRIVE_I_400uA ? 400 :
+		   drive == MC11S_DRIVE_I_800uA ? 800 :
+		   drive == MC11S_DRIVE_I_1mA6 ? 1600 :
+		   drive == MC11S_DRIVE_I_2mA4 ? 2400 : 3200;
+}
+
+constexpr float mc11s_plan_fref(const mc11s_plan_req_t &req, uint8_t frefDiv) {
+	return (float)req.fclk / (frefDiv + 1);
+}
+
+// Counts one RCNT period adds at capacitance c
+constexpr float mc11s_plan_counts_per_rcnt(const mc11s_plan_req_t &req, float c, mc11s_drive_i_status_t drive,
+										   mc11s_fin_div_val_t finDiv, uint8_t frefDiv) {
+	return (float)K * mc11s_plan_drive_ua(drive) / c * 1e6f / (float)(1UL << finDiv) / mc11s_plan_fref(req, frefDiv);
+}
+
+constexpr uint32_t mc11s_plan_ceil(float x) {
+	return (uint32_t)x + (((float)(uint32_t)x < x) ? 1 : 0);
+}
+
+// Shortest RCNT that reaches min_counts, 0 if none fits in 15 bits
+constexpr uint16_t mc11s_plan_rcnt(const mc11s_plan_req_t &req, mc11s_drive_i_status_t drive,
+								   mc11s_fin_div_val_t finDiv, uint8_t frefDiv) {
+	return (req.min_counts / mc11s_plan_counts_per_rcnt(req, req.c_max, drive, finDiv, frefDiv) > 0x7FFF) ? 0 :
+		   (req.min_counts < 1) ? 1 :
+		   (uint16_t)mc11s_plan_ceil(req.min_counts / mc11s_plan_counts_per_rcnt(req, req.c_max, drive, finDiv, frefDiv));
+}
+
+constexpr float mc11s_plan_conv_time(const mc11s_plan_req_t &req, uint8_t frefDiv, uint16_t rcnt) {
+	return req.channels * ((float)req.scnt + rcnt) / mc11s_plan_fref(req, frefDiv);
+}
+
+/**
+ * @brief  Predictions for one setting with a given RCNT.
+ */
+constexpr mc11s_plan_t mc11s_plan_eval(const mc11s_plan_req_t &req, mc11s_drive_i_status_t drive,
+									   mc11s_fin_div_val_t finDiv, uint8_t frefDiv, uint16_t rcnt) {
+	return mc11s_plan_t{
+		drive, finDiv, frefDiv, req.scnt, rcnt,
+		mc11s_plan_conv_time(req, frefDiv, rcnt),
+		rcnt * mc11s_plan_counts_per_rcnt(req, req.c_max, drive, finDiv, frefDiv),
+		rcnt * mc11s_plan_counts_per_rcnt(req, req.c_min, drive, finDiv, frefDiv),
+		(mc11s_plan_drive_ua(drive) + req.core) * mc11s_plan_conv_time(req, frefDiv, rcnt) / req.period
+	};
+}
+
+/**
+ * @brief  Predictions for one setting with the shortest RCNT that meets the request.
+ */
+constexpr mc11s_plan_t mc11s_plan_for(const mc11s_plan_req_t &req, mc11s_drive_i_status_t drive,
+									  mc11s_fin_div_val_t finDiv, uint8_t frefDiv) {
+	return mc11s_plan_eval(req, drive, finDiv, frefDiv, mc11s_plan_rcnt(req, drive, finDiv, frefDiv));
+}
+
+constexpr bool mc11s_plan_valid(const mc11s_plan_req_t &req, const mc11s_plan_t &plan) {
+	return plan.rcnt != 0 && plan.rcnt <= 0x7FFF &&
+		   plan.counts_min >= req.min_counts &&
+		   plan.counts_max < 65535.0f &&
+		   plan.conv_time <= req.period;
+}
+
+// Lower current first (within 0.1%), then the shorter conversion
+constexpr bool mc11s_plan_better(const mc11s_plan_t &a, const mc11s_plan_t &b) {
+	return a.current < b.current * 0.999f ||
+		   (a.current <= b.current * 1.001f && a.conv_time < b.conv_time);
+}
+
+constexpr mc11s_plan_t mc11s_plan_pick(const mc11s_plan_req_t &req, const mc11s_plan_t &a, const mc11s_plan_t &b) {
+	return !mc11s_plan_valid(req, b) ? a :
+		   !mc11s_plan_valid(req, a) ? b :
+		   mc11s_plan_better(b, a) ? b : a;
+}
+
+constexpr mc11s_plan_t mc11s_plan_none(const mc11s_plan_req_t &req) {
+	return mc11s_plan_eval(req, MC11S_DRIVE_I_200uA, MC11S_FIN_DIV_256, 0, 0);
+}
+
+constexpr mc11s_plan_t mc11s_plan_best_drive(const mc11s_plan_req_t &req, mc11s_fin_div_val_t finDiv, uint8_t frefDiv, uint8_t drive) {
+	return drive > MC11S_DRIVE_I_3mA2_1 ? mc11s_plan_none(req) :
+		   mc11s_plan_pick(req, mc11s_plan_for(req, (mc11s_drive_i_status_t)drive, finDiv, frefDiv),
+						   mc11s_plan_best_drive(req, finDiv, frefDiv, drive + 1));
+}
+
+constexpr mc11s_plan_t mc11s_plan_best_fin(const mc11s_plan_req_t &req, uint8_t frefDiv, uint8_t finDiv) {
+	return finDiv > MC11S_FIN_DIV_256 ? mc11s_plan_none(req) :
+		   mc11s_plan_pick(req, mc11s_plan_best_drive(req, (mc11s_fin_div_val_t)finDiv, frefDiv, MC11S_DRIVE_I_200uA),
+						   mc11s_plan_best_fin(req, frefDiv, finDiv + 1));
+}
+
+constexpr mc11s_plan_t mc11s_plan_best_fref(const mc11s_plan_req_t &req, uint16_t frefDiv) {
+	return frefDiv > 0xFF ? mc11s_plan_none(req) :
+		   mc11s_plan_pick(req, mc11s_plan_best_fin(req, (uint8_t)frefDiv, MC11S_FIN_DIV_2),
+						   mc11s_plan_best_fref(req, frefDiv + 1));
+}
+
+/**
+ * @brief  Best plan over every setting (rcnt == 0 when nothing meets the request).
+ */
+constexpr mc11s_plan_t mc11s_plan_best(const mc11s_plan_req_t &req) {
+	return mc11s_plan_best_fref(req, 0);
+}
+
+uint8_t mc11s_plan_rank(const mc11s_plan_req_t &req, mc11s_plan_t *plans, uint8_t n);
+
+#endif
@@ -0,0 +1,79 @@
+/******************************************************************************
+This file makes the Arduino Print class available to the reporting code
+(characterisation tables, histograms, serializers) wherever the library is
+built. On Arduino it is the core's own Print, so Serial, an SD File or a
+network client can be passed in. Elsewhere (host tools, the Linux transport)
+a minimal stand-in with the same write()/print()/println() calls is defined;
+derive from it and implement write(uint8_t) to send the output anywhere.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Print_H__
+#define __MC11S_Print_H__
+
+#if defined(ARDUINO)
+
+#include <Print.h>
+
+#else
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+class Print {
+	public:
+		virtual ~Print(void) { }
+
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t *buffer, size_t size) {
+			size_t n = 0;
+			while (size--)
+				n += write(*buffer++);
+			return n;
+		}
+		size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+
+		size_t print(const char *s) { return write(s); }
+		size_t print(char c) { return write((uint8_t)c); }
+		size_t print(unsigned char v, int base = 10) { return print((unsigned long)v, base); }
+		size_t print(int v, int base = 10) { return print((long)v, base); }
+		size_t print(unsigned int v, int base = 10) { return print((unsigned long)v, base); }
+		size_t print(long v, int base = 10) {
+			if (base == 10 && v < 0)
+				return print('-') + print((unsigned long)-v, base);
+			return print((unsigned long)v, base);
+		}
+		size_t print(unsigned long v, int base = 10) {
+			char buf[8 * sizeof(long) + 1];
+			char *p = &buf[sizeof(buf) - 1];
+
+			if (base < 2)
+				base = 10;
+			*p = '\0';
+			do {
+				uint8_t d = v % base;
+				*--p = d < 10 ? '0' + d : 'A' + d - 10;
+				v /= base;
+			} while (v);
+			return write(p);
+		}
+		size_t print(double v, int digits = 2) {
+			char buf[40];
+			snprintf(buf, sizeof(buf), "%.*f", digits, v);
+			return write(buf);
+		}
+
+		size_t println(void) { return write("\r\n"); }
+		template <typename T>
+		size_t println(T v) { return print(v) + println(); }
+		template <typename T>
+		size_t println(T v, int format) { return print(v, format) + println(); }
+};
+
+#endif
+
+#endif
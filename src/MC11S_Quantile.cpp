@@ -0,0 +1,124 @@
+#include "MC11S_Quantile.h"
+
+MC11S_P2Quantile::MC11S_P2Quantile(float p)
+{
+	setQuantile(p);
+}
+
+/**
+ * @brief  			Selects the quantile to track and restarts the estimator
+ * @param	p		quantile, 0 < p < 1 (0.5 -> median)
+ */
+void MC11S_P2Quantile::setQuantile(float p) {
+	if (p <= 0.0f)
+		p = 0.01f;
+	if (p >= 1.0f)
+		p = 0.99f;
+	_p = p;
+	reset();
+}
+
+/**
+ * @brief  	Forgets all samples
+ */
+void MC11S_P2Quantile::reset(void) {
+	for (uint8_t i = 0; i < 5; i++) {
+		_q[i] = 0;
+		_n[i] = i;
+	}
+
+	_np[0] = 0;
+	_np[1] = 2 * _p;
+	_np[2] = 4 * _p;
+	_np[3] = 2 + 2 * _p;
+	_np[4] = 4;
+
+	_count = 0;
+}
+
+/**
+ * @brief  			Adds a sample
+ * @param	x		sample value
+ */
+void MC11S_P2Quantile::add(float x) {
+	int8_t i, k;
+
+	// The first five samples become the markers, kept sorted
+	if (_count < 5) {
+		for (i = _count; i > 0 && _q[i - 1] > x; i--)
+			_q[i] = _q[i - 1];
+		_q[i] = x;
+		_count++;
+		return;
+	}
+
+	// Find the cell the sample falls in, stretching the extremes if needed
+	if (x < _q[0]) {
+		_q[0] = x;
+		k = 0;
+	} else if (x >= _q[4]) {
+		_q[4] = x;
+		k = 3;
+	} else {
+		for (k = 0; k < 3 && x >= _q[k + 1]; k++)
+			;
+	}
+
+	for (i = k + 1; i < 5; i++)
+		_n[i]++;
+
+	_np[1] += _p / 2;
+	_np[2] += _p;
+	_np[3] += (1 + _p) / 2;
+	_np[4] += 1;
+
+	// Move the middle markers towards their desired positions
+	for (i = 1; i < 4; i++) {
+		float d = _np[i] - _n[i];
+
+		if ((d >= 1 && _n[i + 1] - _n[i] > 1) || (d <= -1 && _n[i - 1] - _n[i] < -1)) {
+			int8_t s = d > 0 ? 1 : -1;
+			float q = parabolic(i, s);
+
+			if (!(_q[i - 1] < q && q < _q[i + 1]))
+				q = linear(i, s);
+
+			_q[i] = q;
+			_n[i] += s;
+		}
+	}
+
+	_count++;
+}
+
+/**
+ * @brief  	Current estimate of the quantile
+ * @retval  Estimate; exact order statistic while fewer than 5 samples were seen
+ */
+float MC11S_P2Quantile::get(void) {
+	if (_count == 0)
+		return 0;
+
+	if (_count < 5) {
+		uint8_t idx = (uint8_t)(_p * (_count - 1) + 0.5f);
+		return _q[idx];
+	}
+
+	return _q[2];
+}
+
+uint32_t MC11S_P2Quantile::getCount(void) {
+	return _count;
+}
+
+float MC11S_P2Quantile::parabolic(int8_t i, int8_t d) {
+	float n0 = _n[i - 1], n1 = _n[i], n2 = _n[i + 1];
+
+	return _q[i] + d / (n2 - n0) *
+		((n1 - n0 + d) * (_q[i + 1] - _q[i]) / (n2 - n1) +
+		 (n2 - n1 - d) * (_q[i] - _q[i - 1]) / (n1 - n0));
+}
+
+float MC11S_P2Quantile::linear(int8_t i, int8_t d) {
+	return _q[i] + d * (_q[i + d] - _q[i]) / (_n[i + d] - _n[i]);
+}
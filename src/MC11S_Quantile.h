@@ -0,0 +1,245 @@
+/******************************************************************************
+This file defines the streaming quantile estimators used for percentile
+reporting (p5/p50/p95 of a day of MC11S samples) on boards that can't buffer
+the samples themselves. Both use a fixed amount of memory however many
+samples are fed in.
+
+  MC11S_P2Quantile            P-square estimator (Jain & Chlamtac) for one
+                              quantile: five markers, 68 bytes, very accurate
+                              on smooth distributions. Use one per quantile.
+                              Not mergeable.
+
+  MC11S_QuantileHistogram<B>  B bins of power-of-two width whose range adapts
+                              to the data: when a sample lands outside, the
+                              bins are coarsened (pairs merged) until it fits.
+                              Any quantile can be read back, the error is at
+                              most one bin width, and two histograms can be
+                              merged exactly, so a gateway can combine the
+                              sketches of many nodes. pack()/unpack() move a
+                              sketch over the wire.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Quantile_H__
+#define __MC11S_Quantile_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+class MC11S_P2Quantile {
+	public:
+		MC11S_P2Quantile(float p = 0.5f);
+
+		void setQuantile(float p);		// 0 < p < 1
+		void reset(void);
+		void add(float x);
+		float get(void);				// Current estimate (exact while fewer than 5 samples)
+		uint32_t getCount(void);
+
+	private:
+		float parabolic(int8_t i, int8_t d);
+		float linear(int8_t i, int8_t d);
+
+		float _p;
+		float _q[5];		// Marker heights
+		float _np[5];		// Desired marker positions
+		int32_t _n[5];		// Actual marker positions
+		uint32_t _count;
+};
+
+template <uint8_t B>
+class MC11S_QuantileHistogram {
+		static_assert(B >= 4, "MC11S_QuantileHistogram needs at least four bins");
+	public:
+		MC11S_QuantileHistogram(void) : _minShift{0} { reset(); }
+
+		void setResolution(uint8_t shift) { _minShift = shift; }	// Finest bin width, 2^shift
+
+		void reset(void) {
+			for (uint8_t i = 0; i < B; i++)
+				_bins[i] = 0;
+			_lo = 0;
+			_shift = _minShift;
+			_min = 0;
+			_max = 0;
+			_total = 0;
+		}
+
+		void add(int32_t x) {
+			if (_total == 0) {
+				// Centre the grid on the first sample
+				_shift = _minShift;
+				_lo = floorAlign(x - ((int32_t)(B / 2) << _shift), _shift);
+				_min = _max = x;
+			}
+
+			if (x < _min)
+				_min = x;
+			if (x > _max)
+				_max = x;
+
+			if (x < _lo || ((x - _lo) >> _shift) >= B)
+				grow(_shift);
+
+			_bins[(x - _lo) >> _shift]++;
+			_total++;
+		}
+
+		/**
+		 * @brief  Combines another sketch into this one. The result is exactly
+		 *         the histogram of both sample streams at the coarser of the two
+		 *         resolutions (or coarser still if the ranges need it).
+		 */
+		void merge(MC11S_QuantileHistogram<B> &other) {
+			if (other._total == 0)
+				return;
+
+			if (_total == 0) {
+				*this = other;
+				return;
+			}
+
+			if (other._min < _min)
+				_min = other._min;
+			if (other._max > _max)
+				_max = other._max;
+
+			grow(other._shift > _shift ? other._shift : _shift);
+
+			for (uint8_t i = 0; i < B; i++) {
+				if (other._bins[i])
+					_bins[(other.binStart(i) - _lo) >> _shift] += other._bins[i];
+			}
+			_total += other._total;
+		}
+
+		/**
+		 * @brief  Value below which a fraction q of the samples lie, linearly
+		 *         interpolated inside the bin and clamped to the seen range.
+		 */
+		float quantile(float q) {
+			float target, cum = 0;
+
+			if (_total == 0)
+				return 0;
+
+			target = q * _total;
+
+			for (uint8_t i = 0; i < B; i++) {
+				if (_bins[i] && cum + _bins[i] >= target) {
+					float v = binStart(i) + (target - cum) / _bins[i] * ((int32_t)1 << _shift);
+
+					if (v < _min)
+						v = _min;
+					if (v > _max)
+						v = _max;
+					return v;
+				}
+				cum += _bins[i];
+			}
+
+			return _max;
+		}
+
+		uint32_t getCount(void) { return _total; }
+		int32_t getMin(void) { return _min; }
+		int32_t getMax(void) { return _max; }
+		int32_t getBinWidth(void) { return (int32_t)1 << _shift; }
+
+		// Wire format: lo, min, max (int32), shift (u8), then B counts (u32), little endian
+		static const size_t kPackedSize = 13 + 4 * B;
+
+		size_t pack(uint8_t *buf, size_t len) {
+			if (len < kPackedSize)
+				return 0;
+
+			putU32(buf, (uint32_t)_lo);
+			putU32(buf + 4, (uint32_t)_min);
+			putU32(buf + 8, (uint32_t)_max);
+			buf[12] = _shift;
+			for (uint8_t i = 0; i < B; i++)
+				putU32(buf + 13 + 4 * i, _bins[i]);
+
+			return kPackedSize;
+		}
+
+		bool unpack(const uint8_t *buf, size_t len) {
+			if (len < kPackedSize || buf[12] > 30)
+				return false;
+
+			_lo = (int32_t)getU32(buf);
+			_min = (int32_t)getU32(buf + 4);
+			_max = (int32_t)getU32(buf + 8);
+			_shift = buf[12];
+			_total = 0;
+			for (uint8_t i = 0; i < B; i++) {
+				_bins[i] = getU32(buf + 13 + 4 * i);
+				_total += _bins[i];
+			}
+
+			return true;
+		}
+
+	private:
+		static int32_t floorAlign(int32_t v, uint8_t shift) {
+			// Floor (not truncation) so negative values align downwards too
+			return (int32_t)((uint32_t)v & ~(((uint32_t)1 << shift) - 1));
+		}
+
+		int32_t binStart(uint8_t i) { return _lo + ((int32_t)i << _shift); }
+
+		/**
+		 * @brief  Rebins onto the finest grid of width >= 2^shift that covers
+		 *         [_min, _max]. Every old bin lands whole in one new bin since
+		 *         the new grid is aligned to its (power of two) width.
+		 */
+		void grow(uint8_t shift) {
+			uint32_t old[B];
+			int32_t oldLo = _lo;
+			uint8_t oldShift = _shift;
+			uint8_t i;
+
+			for (;;) {
+				_lo = floorAlign(_min, shift);
+				if (((_max - _lo) >> shift) < B)
+					break;
+				shift++;
+			}
+
+			if (shift == oldShift && _lo == oldLo)
+				return;
+
+			for (i = 0; i < B; i++) {
+				old[i] = _bins[i];
+				_bins[i] = 0;
+			}
+			_shift = shift;
+
+			for (i = 0; i < B; i++) {
+				if (old[i])
+					_bins[(oldLo + ((int32_t)i << oldShift) - _lo) >> _shift] += old[i];
+			}
+		}
+
+		static void putU32(uint8_t *buf, uint32_t v) {
+			buf[0] = (uint8_t)v;
+			buf[1] = (uint8_t)(v >> 8);
+			buf[2] = (uint8_t)(v >> 16);
+			buf[3] = (uint8_t)(v >> 24);
+		}
+
+		static uint32_t getU32(const uint8_t *buf) {
+			return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+		}
+
+		uint32_t _bins[B];
+		int32_t _lo;
+		int32_t _min, _max;
+		uint32_t _total;
+		uint8_t _shift;
+		uint8_t _minShift;
+};
+
+#endif
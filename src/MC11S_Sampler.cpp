@@ -0,0 +1,169 @@
+#include "MC11S_Sampler.h"
+#include "MC11S_Time.h"
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#endif
+
+MC11S_Sampler::MC11S_Sampler(void) :
+	_sensor{NULL},
+#if MC11S_HAS_MICROS
+	_timebase{mc11s_micros},
+#else
+	_timebase{NULL},
+#endif
+	_periodUs{0}, _lateUs{0}, _intbUs{0}, _intbPending{false},
+	_started{false}, _lastUs{0}, _seq{0}, _samples{0}, _missed{0}, _late{0}
+{
+}
+
+/**
+ * @brief  			Starts sampling a sensor: the period is CR as set on the chip,
+ * 					scaled by the clock correction of its internal oscillator
+ * @param	sensor	MC11S to read
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_Sampler::begin(MC11S *sensor) {
+	mc11s_conv_time_status_t cr;
+	uint32_t ms;
+	int32_t ret;
+
+	if (sensor == NULL)
+		return -1;
+
+	_sensor = sensor;
+	_intbPending = false;
+	_started = false;
+	_seq = 0;
+	resetStats();
+
+	ret = sensor->getConvTime(&cr);
+	ret += mc11s_conv_time_ms_get(cr, &ms);
+	if (ret != 0)
+		return ret;
+
+	// A fast oscillator makes the period short
+	setPeriod((uint32_t)(ms * 1000.0f / sensor->getClockCorrection() + 0.5f));
+	return 0;
+}
+
+void MC11S_Sampler::setPeriod(uint32_t us) {
+	_periodUs = us;
+	_lateUs = us / 4;
+}
+
+uint32_t MC11S_Sampler::getPeriod(void) {
+	return _periodUs;
+}
+
+void MC11S_Sampler::setLateThreshold(uint32_t us) {
+	_lateUs = us;
+}
+
+void MC11S_Sampler::setTimebase(unsigned long (*us)(void)) {
+	_timebase = us;
+}
+
+/**
+ * @brief  			Timestamps the INTB edge; the next poll() uses it as the capture
+ * 					time. Call it first thing in the interrupt handler.
+ */
+void MC11S_Sampler::markIntb(void) {
+	_intbUs = _timebase ? _timebase() : 0;
+	_intbPending = true;
+}
+
+/**
+ * @brief  			Reads STATUS and, once the conversion is complete, both channels
+ * 					(one burst), and stamps the sample
+ * @param	sample	Filled in when fresh
+ * @param	fresh	true when a new conversion was read, false when it isn't ready yet
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_Sampler::poll(mc11s_sample_t *sample, bool *fresh) {
+	uint32_t now, interval, n;
+	int32_t jitter;
+	int32_t ret;
+
+	*fresh = false;
+	if (_sensor == NULL)
+		return -1;
+
+	now = _timebase ? _timebase() : 0;
+
+	// The INTB edge is closer to the end of the conversion than the poll. It
+	// is taken before STATUS is read: an edge that comes in during the reads
+	// is the next conversion's and stays pending for the next poll.
+#if defined(ARDUINO)
+	noInterrupts();
+#endif
+	if (_intbPending) {
+		now = _intbUs;
+		_intbPending = false;
+	}
+#if defined(ARDUINO)
+	interrupts();
+#endif
+
+	ret = _sensor->getStatus(&sample->status);
+	if (ret != 0 || !_sensor->isDataReady(sample->status))
+		return ret;
+
+	ret = _sensor->getData(&sample->ch0, &sample->ch1);
+	if (ret != 0)
+		return ret;
+
+	if (_started) {
+		interval = now - _lastUs;
+		n = 1;
+		if (_periodUs != 0) {
+			n = (interval + _periodUs / 2) / _periodUs;
+			if (n == 0)
+				n = 1;
+
+			jitter = (int32_t)(interval - n * _periodUs);
+			_jitter.add(jitter);
+			if (jitter > (int32_t)_lateUs)
+				_late++;
+		}
+
+		_missed += n - 1;
+		_seq += n;
+	}
+
+	_started = true;
+	_lastUs = now;
+	_samples++;
+
+	sample->timestamp = now;
+	sample->seq = _seq;
+	*fresh = true;
+
+	return 0;
+}
+
+uint32_t MC11S_Sampler::getSampleCount(void) {
+	return _samples;
+}
+
+uint32_t MC11S_Sampler::getMissedCount(void) {
+	return _missed;
+}
+
+uint32_t MC11S_Sampler::getLateCount(void) {
+	return _late;
+}
+
+MC11S_RunningStats<int32_t> &MC11S_Sampler::getJitter(void) {
+	return _jitter;
+}
+
+/**
+ * @brief  			Clears the counters and the jitter statistics; seq carries on
+ */
+void MC11S_Sampler::resetStats(void) {
+	_samples = 0;
+	_missed = 0;
+	_late = 0;
+	_jitter.reset();
+}
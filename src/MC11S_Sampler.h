@@ -0,0 +1,81 @@
+/******************************************************************************
+This file defines the timestamped sample acquisition. getData() returns bare
+counts; MC11S_Sampler returns each conversion as an mc11s_sample_t with the
+time it was captured and its conversion number, and keeps track of the
+conversions that were never read.
+
+    timestamp   MCU microseconds (setTimebase(), mc11s_micros() by default) of the
+                INTB edge when markIntb() is called from the INTB interrupt,
+                otherwise of the poll that found DRDY set
+    seq         conversion number since begin(): it advances by the number
+                of CR periods since the previous sample, so a gap in seq is
+                a conversion that was overwritten before it was read
+
+In continuous mode the chip converts every CR period (setConvTime()), timed
+by its internal oscillator, so the period is taken from CR and the clock
+correction (calibrateClock()) at begin(), or given with setPeriod().
+Each interval between samples is rounded to whole periods:
+
+    missed      periods skipped, n - 1 for an interval of n periods
+    late        samples whose interval is more than the late threshold
+                (default a quarter period) past n periods
+    jitter      interval - n * period in us, as running statistics (mean,
+                standard deviation, min, max). A mean away from 0 is a
+                period that is off, the spread is how much the capture
+                time varies: a polling interval or an interrupt latency
+                that is too long, or a bus that is busy
+
+With setPeriod(0) (single conversions) every sample counts as the next one.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Sampler_H__
+#define __MC11S_Sampler_H__
+
+#include "MC11S_class.h"
+#include "MC11S_Stats.h"
+
+typedef struct {
+	uint16_t ch0;
+	uint16_t ch1;
+	mc11s_status_t status;
+	uint32_t timestamp;		// us
+	uint32_t seq;			// Conversion number, gaps are missed conversions
+} mc11s_sample_t;
+
+class MC11S_Sampler {
+	public:
+		MC11S_Sampler(void);
+
+		int32_t begin(MC11S *sensor);				// Takes the period from CR, clears the counters
+		void setPeriod(uint32_t us);				// Conversion period (0 -> single conversions)
+		uint32_t getPeriod(void);
+		void setLateThreshold(uint32_t us);			// Default period / 4
+		void setTimebase(unsigned long (*us)(void));	// e.g. micros (default mc11s_micros on Arduino and Linux)
+
+		void markIntb(void);						// Call from the INTB interrupt
+		int32_t poll(mc11s_sample_t *sample, bool *fresh);	// fresh -> a new conversion was read
+
+		uint32_t getSampleCount(void);
+		uint32_t getMissedCount(void);
+		uint32_t getLateCount(void);
+		MC11S_RunningStats<int32_t> &getJitter(void);	// Interval - n * period, us
+		void resetStats(void);
+
+	private:
+		MC11S *_sensor;
+		unsigned long (*_timebase)(void);
+		uint32_t _periodUs, _lateUs;
+
+		volatile uint32_t _intbUs;
+		volatile bool _intbPending;
+
+		bool _started;
+		uint32_t _lastUs, _seq;
+		uint32_t _samples, _missed, _late;
+		MC11S_RunningStats<int32_t> _jitter;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "MC11S_Scheduler.h"
+#include <math.h>
+
+MC11S_RateScheduler::MC11S_RateScheduler(void) :
+	_slowest{MC11S_CONV_60S}, _fastest{MC11S_CONV_0S25},
+	_rateActive{1.0f}, _rateQuiet{0.2f},
+	_spreadActive{10.0f}, _spreadQuiet{4.0f},
+	_quietTime{30000}, _minInterval{5000}, _tau{10.0f},
+	_driftRate{0.02f}, _driftTau{300.0f}, _driftCr{MC11S_CONV_5S}
+{
+	reset(MC11S_CONV_0S25);
+}
+
+/**
+ * @brief  			Periods the scheduler may use
+ * @param	slowest	Longest period, e.g. MC11S_CONV_60S
+ * @param	fastest	Shortest period, e.g. MC11S_CONV_0S25
+ */
+void MC11S_RateScheduler::setRange(mc11s_conv_time_status_t slowest, mc11s_conv_time_status_t fastest) {
+	// Larger CR codes convert faster
+	if (slowest > fastest) {
+		mc11s_conv_time_status_t t = slowest;
+		slowest = fastest;
+		fastest = t;
+	}
+
+	_slowest = slowest;
+	_fastest = fastest;
+
+	if (_cr < _slowest)
+		_cr = _slowest;
+	if (_cr > _fastest)
+		_cr = _fastest;
+}
+
+void MC11S_RateScheduler::setRateThresholds(float active, float quiet) {
+	_rateActive = active;
+	_rateQuiet = quiet < active ? quiet : active;
+}
+
+void MC11S_RateScheduler::setSpreadThresholds(float active, float quiet) {
+	_spreadActive = active;
+	_spreadQuiet = quiet < active ? quiet : active;
+}
+
+void MC11S_RateScheduler::setQuietTime(uint32_t ms) {
+	_quietTime = ms;
+}
+
+void MC11S_RateScheduler::setMinInterval(uint32_t ms) {
+	_minInterval = ms;
+}
+
+void MC11S_RateScheduler::setTimeConstant(uint32_t ms) {
+	_tau = ms / 1000.0f;
+}
+
+void MC11S_RateScheduler::setDriftThreshold(float rate) {
+	_driftRate = rate;
+}
+
+void MC11S_RateScheduler::setDriftWindow(uint32_t ms) {
+	_driftTau = ms ? ms / 1000.0f : 1.0f;
+}
+
+void MC11S_RateScheduler::setDriftPeriod(mc11s_conv_time_status_t cr) {
+	_driftCr = cr;
+}
+
+/**
+ * @brief  			Forgets the signal history
+ * @param	cr		Period the device is running at now
+ */
+void MC11S_RateScheduler::reset(mc11s_conv_time_status_t cr) {
+	_cr = cr;
+	if (_cr < _slowest)
+		_cr = _slowest;
+	if (_cr > _fastest)
+		_cr = _fastest;
+
+	_level = 0;
+	_rate = 0;
+	_var = 0;
+	_slow = 0;
+	_lastMs = 0;
+	_quietSince = 0;
+	_changedAt = 0;
+	_changes = 0;
+	_primed = false;
+	_active = false;
+}
+
+/**
+ * @brief  			Feeds one conversion result and decides on the period
+ * @param	x		Sample (count, ratio or level)
+ * @param	nowMs	Time of the sample, e.g. millis()
+ * @retval  		true when getConvTime() changed and should be written to the device
+ */
+bool MC11S_RateScheduler::update(float x, uint32_t nowMs) {
+	float dt, a, d, prev, spread, drift;
+	bool active, quiet, drifting;
+	uint8_t target, driftCr;
+
+	if (!_primed) {
+		_level = x;
+		_slow = x;
+		_lastMs = nowMs;
+		_quietSince = nowMs;
+		_primed = true;
+		return false;
+	}
+
+	dt = (nowMs - _lastMs) / 1000.0f;
+	if (dt <= 0.0f)
+		return false;
+
+	// Weight of this sample for the time it covers
+	a = dt / (_tau + dt);
+
+	d = x - _level;
+	prev = _level;
+	_level += a * d;
+	_var = (1.0f - a) * (_var + a * d * d);
+
+	// Slope of the smoothed level, smoothed again: noise averages out, a trend doesn't
+	_rate += a * ((_level - prev) / dt - _rate);
+
+	_lastMs = nowMs;
+
+	spread = sqrtf(_var);
+	active = fabsf(_rate) > _rateActive || spread > _spreadActive;
+	quiet = fabsf(_rate) < _rateQuiet && spread < _spreadQuiet;
+
+	if (active)
+		_active = true;
+	else if (quiet)
+		_active = false;
+
+	// Long-window slope, measured from where the level last stopped moving fast
+	if (_active)
+		_slow = _level;
+	else
+		_slow += dt / (_driftTau + dt) * (_level - _slow);
+	drift = (_level - _slow) / _driftTau;
+	drifting = _driftRate > 0 && fabsf(drift) > _driftRate;
+
+	if (drifting)
+		quiet = false;
+
+	if (!quiet)
+		_quietSince = nowMs;
+
+	driftCr = _driftCr;
+	if (driftCr < _slowest)
+		driftCr = _slowest;
+	if (driftCr > _fastest)
+		driftCr = _fastest;
+
+	target = _cr;
+	if (active)
+		target = _fastest;
+	else if (drifting && _cr < driftCr)
+		target = driftCr;
+	else if (quiet && _cr > _slowest && nowMs - _quietSince >= _quietTime)
+		target = _cr - 1;
+
+	if (target == _cr)
+		return false;
+
+	if (_changes > 0 && nowMs - _changedAt < _minInterval)
+		return false;
+
+	_cr = target;
+	_changedAt = nowMs;
+	_quietSince = nowMs;
+	_changes++;
+
+	return true;
+}
+
+/**
+ * @brief  			update() followed by writing the new period to the device
+ * @param	sensor	Device to reconfigure
+ * @param	x		Sample (count, ratio or level)
+ * @param	nowMs	Time of the sample, e.g. millis()
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_RateScheduler::service(MC11S *sensor, float x, uint32_t nowMs) {
+	if (!update(x, nowMs))
+		return 0;
+
+	return sensor->setConvTime((mc11s_conv_time_status_t)_cr);
+}
+
+mc11s_conv_time_status_t MC11S_RateScheduler::getConvTime(void) {
+	return (mc11s_conv_time_status_t)_cr;
+}
+
+float MC11S_RateScheduler::getRate(void) {
+	return _rate;
+}
+
+float MC11S_RateScheduler::getSpread(void) {
+	return sqrtf(_var);
+}
+
+float MC11S_RateScheduler::getDrift(void) {
+	return (_level - _slow) / _driftTau;
+}
+
+bool MC11S_RateScheduler::isActive(void) {
+	return _active;
+}
+
+uint32_t MC11S_RateScheduler::getChangeCount(void) {
+	return _changes;
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+This file defines the adaptive conversion-rate scheduler. It watches how much
+the signal is moving and moves the CR field (MC11S_CONV_*) with it: fast
+conversions while the level changes, long periods while it sits still, which
+is where a tank spends almost all of its time.
+
+Activity is measured on whatever scalar is fed in (a channel count, the
+channel ratio, a level) with two exponentially weighted estimates. Their
+weights follow the time between samples rather than the sample count, so
+they mean the same thing at 4 Hz as at one sample a minute:
+
+    rate     |d level / dt| of the smoothed level, in units per second
+    spread   standard deviation around the smoothed level, in units
+    drift    slope of the level over the drift window (default 5 minutes),
+             in units per second: the smoothed level against a much slower
+             average of it, which lags a steady trend by slope x window
+
+The signal is active when rate or spread exceeds its active threshold and
+quiet only when both are below their quiet thresholds and it isn't drifting;
+in between nothing changes. An active signal jumps straight to the fastest
+period, so a fill or a drain is followed at once. A quiet one steps one
+period slower each time it has stayed quiet for the quiet time. No change is
+made within the minimum interval of the previous one, which caps how often
+the device gets reconfigured.
+
+A slow leak moves the level by less than the noise from one conversion to
+the next, so rate and spread stay quiet and the scheduler would back off to
+the slowest period just when the leak starts. The drift term catches it:
+while |drift| is above the drift threshold the period is held at the drift
+period (default 5 s) or faster, which costs little next to the fastest one.
+The slow average restarts from the level whenever the signal is active, so
+a fill doesn't leave a drift behind.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Scheduler_H__
+#define __MC11S_Scheduler_H__
+
+#include "MC11S_class.h"
+
+class MC11S_RateScheduler {
+	public:
+		MC11S_RateScheduler(void);
+
+		void setRange(mc11s_conv_time_status_t slowest, mc11s_conv_time_status_t fastest);	// Periods to move between
+		void setRateThresholds(float active, float quiet);		// |rate| in units/s, quiet < active
+		void setSpreadThresholds(float active, float quiet);	// Std deviation in units, quiet < active
+		void setQuietTime(uint32_t ms);							// Quiet this long before each step slower
+		void setMinInterval(uint32_t ms);						// Minimum time between two changes
+		void setTimeConstant(uint32_t ms);						// Smoothing of level, rate and spread
+		void setDriftThreshold(float rate);						// |drift| in units/s that holds the drift period (0 -> off)
+		void setDriftWindow(uint32_t ms);						// Time the drift is measured over
+		void setDriftPeriod(mc11s_conv_time_status_t cr);		// Slowest period while drifting
+
+		void reset(mc11s_conv_time_status_t cr);
+
+		bool update(float x, uint32_t nowMs);					// Returns true when the period should change
+		int32_t service(MC11S *sensor, float x, uint32_t nowMs);	// update() and write CR if it changed
+
+		mc11s_conv_time_status_t getConvTime(void);
+		float getRate(void);
+		float getSpread(void);
+		float getDrift(void);
+		bool isActive(void);
+		uint32_t getChangeCount(void);
+
+	private:
+		uint8_t _slowest, _fastest;		// CR codes, larger is faster
+		uint8_t _cr;
+		float _rateActive, _rateQuiet;
+		float _spreadActive, _spreadQuiet;
+		uint32_t _quietTime, _minInterval;
+		float _tau;
+		float _driftRate, _driftTau;
+		uint8_t _driftCr;
+
+		float _level, _rate, _var, _slow;
+		uint32_t _lastMs, _quietSince, _changedAt;
+		uint32_t _changes;
+		bool _primed, _active;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "MC11S_Serialize.h"
+#include "MC11S_Crc.h"
+#include <string.h>
+
+// Writes v in decimal at p, returns the number of characters
+static uint8_t mc11s_ser_u32(char *p, uint32_t v) {
+	char tmp[10];
+	uint8_t n = 0, i;
+	uint16_t w;
+
+	// 16 bit division is much cheaper on AVR, and most fields fit
+	while (v > 0xFFFF) {
+		tmp[n++] = '0' + (char)(v % 10);
+		v /= 10;
+	}
+	w = (uint16_t)v;
+	do {
+		tmp[n++] = '0' + (char)(w % 10);
+		w /= 10;
+	} while (w);
+
+	for (i = 0; i < n; i++)
+		p[i] = tmp[n - 1 - i];
+
+	return n;
+}
+
+// Writes v / 1000 with three decimals
+static uint8_t mc11s_ser_milli(char *p, int32_t v) {
+	uint32_t u = (v < 0) ? (uint32_t)-v : (uint32_t)v;
+	uint16_t frac = (uint16_t)(u % 1000);
+	uint8_t n = 0;
+
+	if (v < 0)
+		p[n++] = '-';
+	n += mc11s_ser_u32(&p[n], u / 1000);
+	p[n++] = '.';
+	p[n++] = '0' + (char)(frac / 100);
+	p[n++] = '0' + (char)(frac / 10 % 10);
+	p[n++] = '0' + (char)(frac % 10);
+
+	return n;
+}
+
+static uint8_t mc11s_ser_str(char *p, const char *s) {
+	uint8_t n = 0;
+
+	while (s[n]) {
+		p[n] = s[n];
+		n++;
+	}
+
+	return n;
+}
+
+static void mc11s_ser_put16(uint8_t *p, uint16_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void mc11s_ser_put32(uint8_t *p, uint32_t v) {
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint8_t mc11s_ser_status(const mc11s_status_t &status) {
+	uint8_t raw;
+
+	memcpy(&raw, &status, 1);
+	return raw;
+}
+
+// pF to fF, rounded and clamped to the int32 range
+static int32_t mc11s_ser_femto(float pF) {
+	float f = pF * 1000.0f;
+
+	if (f >= 2147483000.0f)
+		return 2147483000L;
+	if (f <= -2147483000.0f)
+		return -2147483000L;
+	return (int32_t)(f + (f < 0 ? -0.5f : 0.5f));
+}
+
+MC11S_SampleWriter::MC11S_SampleWriter(mc11s_ser_format_t format) :
+	_format{format}
+{
+}
+
+void MC11S_SampleWriter::setFormat(mc11s_ser_format_t format) {
+	_format = format;
+}
+
+mc11s_ser_format_t MC11S_SampleWriter::getFormat(void) {
+	return _format;
+}
+
+/**
+ * @brief  			Writes the CSV column names; nothing for the other formats
+ * @param	out			Destination
+ * @param	capacitance	true when the records will carry capacitances
+ * @retval  			Bytes written
+ */
+size_t MC11S_SampleWriter::writeHeader(Print &out, bool capacitance) {
+	if (_format != MC11S_SER_CSV)
+		return 0;
+
+	if (capacitance)
+		return out.println("seq,time_us,ch0,ch1,status,c0_pf,c1_pf");
+	return out.println("seq,time_us,ch0,ch1,status");
+}
+
+/**
+ * @brief  			Writes one record in a single write() call
+ * @param	out		Destination
+ * @param	sample	Sample to write
+ * @retval  		Bytes written
+ */
+size_t MC11S_SampleWriter::write(Print &out, const mc11s_sample_t &sample) {
+	uint8_t buf[MC11S_SER_MAX_LEN];
+
+	return out.write(buf, build(buf, sample, NULL));
+}
+
+/**
+ * @brief  			Writes one record with the capacitances, in a single write() call
+ * @param	out		Destination
+ * @param	sample	Sample to write
+ * @param	c0		Channel 0 capacitance, pF (text formats only)
+ * @param	c1		Channel 1 capacitance, pF (text formats only)
+ * @retval  		Bytes written
+ */
+size_t MC11S_SampleWriter::write(Print &out, const mc11s_sample_t &sample, float c0, float c1) {
+	uint8_t buf[MC11S_SER_MAX_LEN];
+	int32_t fF[2] = { mc11s_ser_femto(c0), mc11s_ser_femto(c1) };
+
+	return out.write(buf, build(buf, sample, fF));
+}
+
+/**
+ * @brief  			Formats one record into a buffer; text is not 0 terminated
+ * @param	buf		Destination
+ * @param	len		Size of buf, MC11S_SER_MAX_LEN always fits
+ * @param	sample	Sample to format
+ * @retval  		Bytes used (0 -> buf too small, nothing written)
+ */
+size_t MC11S_SampleWriter::format(uint8_t *buf, size_t len, const mc11s_sample_t &sample) {
+	return formatInto(buf, len, sample, NULL);
+}
+
+size_t MC11S_SampleWriter::format(uint8_t *buf, size_t len, const mc11s_sample_t &sample, float c0, float c1) {
+	int32_t fF[2] = { mc11s_ser_femto(c0), mc11s_ser_femto(c1) };
+
+	return formatInto(buf, len, sample, fF);
+}
+
+size_t MC11S_SampleWriter::formatInto(uint8_t *buf, size_t len, const mc11s_sample_t &sample, const int32_t *fF) {
+	uint8_t tmp[MC11S_SER_MAX_LEN];
+	size_t n;
+
+	if (len >= MC11S_SER_MAX_LEN)
+		return build(buf, sample, fF);
+
+	n = build(tmp, sample, fF);
+	if (len < n)
+		return 0;
+	memcpy(buf, tmp, n);
+	return n;
+}
+
+// Formats into buf, which has room for MC11S_SER_MAX_LEN bytes; fF -> capacitances in fF
+size_t MC11S_SampleWriter::build(uint8_t *buf, const mc11s_sample_t &sample, const int32_t *fF) {
+	char *text = (char *)buf;
+	bool json = (_format == MC11S_SER_JSON);
+	uint8_t n = 0;
+
+	if (_format == MC11S_SER_BINARY) {
+		buf[0] = 'M';
+		buf[1] = 'S';
+		mc11s_ser_put32(&buf[2], sample.seq);
+		mc11s_ser_put32(&buf[6], sample.timestamp);
+		mc11s_ser_put16(&buf[10], sample.ch0);
+		mc11s_ser_put16(&buf[12], sample.ch1);
+		buf[14] = mc11s_ser_status(sample.status);
+		mc11s_ser_put16(&buf[15], mc11s_crc16(buf, 15));
+		return MC11S_SER_FRAME_LEN;
+	}
+
+	n += mc11s_ser_str(&text[n], json ? "{\"seq\":" : "");
+	n += mc11s_ser_u32(&text[n], sample.seq);
+	n += mc11s_ser_str(&text[n], json ? ",\"t\":" : ",");
+	n += mc11s_ser_u32(&text[n], sample.timestamp);
+	n += mc11s_ser_str(&text[n], json ? ",\"ch0\":" : ",");
+	n += mc11s_ser_u32(&text[n], sample.ch0);
+	n += mc11s_ser_str(&text[n], json ? ",\"ch1\":" : ",");
+	n += mc11s_ser_u32(&text[n], sample.ch1);
+	n += mc11s_ser_str(&text[n], json ? ",\"st\":" : ",");
+	n += mc11s_ser_u32(&text[n], mc11s_ser_status(sample.status));
+
+	if (fF != NULL) {
+		n += mc11s_ser_str(&text[n], json ? ",\"c0\":" : ",");
+		n += mc11s_ser_milli(&text[n], fF[0]);
+		n += mc11s_ser_str(&text[n], json ? ",\"c1\":" : ",");
+		n += mc11s_ser_milli(&text[n], fF[1]);
+	}
+
+	n += mc11s_ser_str(&text[n], json ? "}\r\n" : "\r\n");
+	return n;
+}
+
+/**
+ * @brief  			Checks and unpacks a binary frame
+ * @param	frame	MC11S_SER_FRAME_LEN bytes starting with 'M' 'S'
+ * @param	len		Bytes available at frame
+ * @param	sample	Unpacked sample
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S_SampleWriter::decodeFrame(const uint8_t *frame, size_t len, mc11s_sample_t *sample) {
+	uint8_t status;
+
+	if (len < MC11S_SER_FRAME_LEN || frame[0] != 'M' || frame[1] != 'S')
+		return -1;
+	if (mc11s_crc16(frame, 15) != (uint16_t)(frame[15] | (frame[16] << 8)))
+		return -1;
+
+	sample->seq = frame[2] | ((uint32_t)frame[3] << 8) | ((uint32_t)frame[4] << 16) | ((uint32_t)frame[5] << 24);
+	sample->timestamp = frame[6] | ((uint32_t)frame[7] << 8) | ((uint32_t)frame[8] << 16) | ((uint32_t)frame[9] << 24);
+	sample->ch0 = (uint16_t)(frame[10] | (frame[11] << 8));
+	sample->ch1 = (uint16_t)(frame[12] | (frame[13] << 8));
+	status = frame[14];
+	memcpy(&sample->status, &status, 1);
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+This file defines the sample serializers. MC11S_SampleWriter turns an
+mc11s_sample_t into one record of text or binary, either straight into a
+Print (Serial, an SD File, a network client) or into a caller's buffer.
+Nothing is allocated: a record is built in a small buffer on the stack and
+handed to the Print in one write(), and every number is formatted with
+integer arithmetic, so a node can log for months without touching the heap
+the way String concatenation does.
+
+    MC11S_SER_CSV       seq,time_us,ch0,ch1,status[,c0_pf,c1_pf]\r\n
+    MC11S_SER_JSON      {"seq":N,"t":N,"ch0":N,"ch1":N,"st":N[,"c0":F,"c1":F]}\r\n
+    MC11S_SER_BINARY    fixed MC11S_SER_FRAME_LEN byte frame, little-endian:
+                        'M' 'S', u32 seq, u32 timestamp, u16 ch0, u16 ch1,
+                        u8 status, u16 CRC-16/CCITT-FALSE (MC11S_Crc.h) of
+                        everything before it
+
+status is the STATUS register byte. Given the capacitances (e.g. from
+calcCapacitance()), the text formats also carry both in pF to three
+decimals, rounded to fF once and printed as fixed point. The binary frame
+always carries the counts only: the capacitances follow from them and the
+settings on the receiving side. decodeFrame() checks and unpacks a frame.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Serialize_H__
+#define __MC11S_Serialize_H__
+
+#include "MC11S_Sampler.h"
+#include "MC11S_Print.h"
+
+#define MC11S_SER_FRAME_LEN		17
+#define MC11S_SER_MAX_LEN		112		// Longest record of any format
+
+typedef enum {
+	MC11S_SER_CSV = 0,
+	MC11S_SER_JSON = 1,
+	MC11S_SER_BINARY = 2,
+} mc11s_ser_format_t;
+
+class MC11S_SampleWriter {
+	public:
+		MC11S_SampleWriter(mc11s_ser_format_t format = MC11S_SER_CSV);
+
+		void setFormat(mc11s_ser_format_t format);
+		mc11s_ser_format_t getFormat(void);
+
+		size_t writeHeader(Print &out, bool capacitance = false);	// CSV column names, nothing for the others
+		size_t write(Print &out, const mc11s_sample_t &sample);
+		size_t write(Print &out, const mc11s_sample_t &sample, float c0, float c1);	// pF
+		size_t format(uint8_t *buf, size_t len, const mc11s_sample_t &sample);	// 0 -> buf too small
+		size_t format(uint8_t *buf, size_t len, const mc11s_sample_t &sample, float c0, float c1);
+
+		static int32_t decodeFrame(const uint8_t *frame, size_t len, mc11s_sample_t *sample);
+
+	private:
+		size_t formatInto(uint8_t *buf, size_t len, const mc11s_sample_t &sample, const int32_t *fF);
+		size_t build(uint8_t *buf, const mc11s_sample_t &sample, const int32_t *fF);
+
+		mc11s_ser_format_t _format;
+};
+
+#endif
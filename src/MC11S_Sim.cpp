@@ -0,0 +1,477 @@
+#include "MC11S_Sim.h"
+#include "MC11S_Time.h"
+#include <string.h>
+#include <math.h>
+
+MC11S_Sim::MC11S_Sim(void) : _convPending{false}, _transfers{0}, _cap{0, 0},
+    _jitter{0}, _glitchRate{0}, _glitchSize{0}, _oscHz{MC11S_INT_CLK_HZ, MC11S_EXT_CLK_HZ},
+    _temp{25}, _tempRef{25}, _tempco{0, 0}, _rng{1},
+    _intbHandler{NULL}, _intbArg{NULL}, _busHz{0}, _realTime{false}, _convBusy{false},
+    _convStart{0}, _convUs{0}
+{
+    powerOn();
+}
+
+bool MC11S_Sim::begin(void)
+{
+    sensor.read_reg = MC11S_Sim::read;
+    sensor.write_reg = MC11S_Sim::write;
+    sensor.handle = this;
+
+    // call super class begin -- it returns 0 on no error
+    return MC11S::begin() == 0;
+}
+
+/**
+ * @brief  Restores the register defaults of the model. These are the values the
+ *         library relies on after reset, not a copy of the datasheet table.
+ */
+void MC11S_Sim::powerOn(void) {
+    mc11s_fin_div_t fin_div;
+    mc11s_ch_en_t ch_en;
+    mc11s_cfg_t cfg;
+
+    memset(_regs, 0, sizeof(_regs));
+
+    _regs[MC11S_RCNT_MSB] = 0x04;            // RCNT = 1024
+    _regs[MC11S_SCNT] = 0x20;
+
+    memset(&fin_div, 0, 1);
+    fin_div.fin_div = MC11S_FIN_DIV_8;
+    memcpy(&_regs[MC11S_FIN_DIV], &fin_div, 1);
+
+    memset(&cfg, 0, 1);
+    cfg.os_sd = MC11S_STOP_CONV;
+    cfg.cr = MC11S_CONV_1S;
+    memcpy(&_regs[MC11S_CFG], &cfg, 1);
+
+    memset(&ch_en, 0, 1);
+    ch_en.ch0_en = MC11S_CH_ENABLE;
+    ch_en.ch1_en = MC11S_CH_ENABLE;
+    memcpy(&_regs[MC11S_CH_EN], &ch_en, 1);
+
+    _regs[MC11S_DEVICE_ID_MSB] = (uint8_t)(MC11S_ID >> 8);
+    _regs[MC11S_DEVICE_ID_LSB] = (uint8_t)(MC11S_ID & 0xFF);
+
+    _convPending = false;
+    _convBusy = false;
+}
+
+/**
+ * @brief  Loads a conversion result into the data registers the way the
+ *         chip does at the end of a conversion: data ready flags are set,
+ *         the ratio 0x40 * DATA_D0 / DATA_D1 is compared against TRH/TRL
+ *         to update ALERT and TRH_OF_D is raised if it can't be represented.
+ * @param  ch0     Channel0 count
+ * @param  ch1     Channel1 count
+ */
+void MC11S_Sim::latchConversion(uint16_t ch0, uint16_t ch1) {
+    mc11s_status_t status;
+    uint32_t scaled;
+    bool intb = getIntb();
+
+    _regs[MC11S_DATA_CH0_MSB] = (uint8_t)(ch0 >> 8);
+    _regs[MC11S_DATA_CH0_LSB] = (uint8_t)(ch0 & 0xFF);
+    _regs[MC11S_DATA_CH1_MSB] = (uint8_t)(ch1 >> 8);
+    _regs[MC11S_DATA_CH1_LSB] = (uint8_t)(ch1 & 0xFF);
+
+    memcpy(&status, &_regs[MC11S_STATUS], 1);
+
+    status.drdy_ch0 = 1;
+    status.drdy_ch1 = 1;
+
+    // Compare 0x40 * D0 / D1 against the thresholds without dividing
+    scaled = (uint32_t)0x40 * ch0;
+    status.trh_of_d = (scaled > (uint32_t)0xFF * ch1 || ch0 == 0xFFFF || ch1 == 0xFFFF) ? 1 : 0;
+
+    // Alarm with hysteresis: trips above TRH, releases below TRL
+    if (scaled > (uint32_t)_regs[MC11S_TRH] * ch1) {
+        status.alert = 1;
+    } else if (scaled < (uint32_t)_regs[MC11S_TRL] * ch1) {
+        status.alert = 0;
+    }
+
+    memcpy(&_regs[MC11S_STATUS], &status, 1);
+
+    _convPending = true;
+
+    if (!intb && getIntb() && _intbHandler != NULL)
+        _intbHandler(_intbArg);
+}
+
+/**
+ * @brief  Level of the INTB pin as seen by the MCU.
+ * @retval true when INTB is asserted (pulled low)
+ */
+bool MC11S_Sim::getIntb(void) {
+    mc11s_status_t status;
+    mc11s_cfg_t cfg;
+
+    memcpy(&status, &_regs[MC11S_STATUS], 1);
+    memcpy(&cfg, &_regs[MC11S_CFG], 1);
+
+    if (cfg.intb_en != MC11S_INTB_ENABLE)
+        return false;
+
+    if (cfg.intb_mode == MC11S_INTB_ALARM)
+        return status.alert != 0;
+
+    return _convPending;
+}
+
+/**
+ * @brief  Sets the stand-in for the INTB interrupt
+ * @param  handler  Called with arg whenever INTB goes from released to
+ *                  asserted; like an ISR it may run in the middle of
+ *                  anything, so it should only take note and return
+ * @param  arg      Passed back to the handler
+ */
+void MC11S_Sim::setIntbHandler(void (*handler)(void *), void *arg) {
+    _intbHandler = handler;
+    _intbArg = arg;
+}
+
+void MC11S_Sim::setBusRate(uint32_t hz) {
+    _busHz = hz;
+}
+
+/**
+ * @brief  Waits as long as an I2C transaction takes at the bus rate. Without
+ *         a clock to wait on (MC11S_HAS_MICROS) transactions stay instant.
+ * @param  bytes  Bytes on the bus: device address, register address, the
+ *                repeated address of a read, the data; 9 bits each
+ */
+void MC11S_Sim::busDelay(uint32_t bytes) {
+#if MC11S_HAS_MICROS
+    uint32_t start, us;
+
+    if (_busHz == 0)
+        return;
+
+    us = (uint32_t)((uint64_t)bytes * 9 * 1000000UL / _busHz);
+    start = mc11s_micros();
+    while ((uint32_t)(mc11s_micros() - start) < us)
+        ;
+#else
+    (void)bytes;
+#endif
+}
+
+void MC11S_Sim::setCapacitance(float c0pF, float c1pF) {
+    _cap[0] = c0pF;
+    _cap[1] = c1pF;
+}
+
+/**
+ * @brief  Noise model applied by convert()
+ * @param  jitterPpm   Std deviation in ppm of the count at 200 uA, RCNT = 1024
+ * @param  glitchRate  Probability of a glitch per channel and conversion
+ * @param  glitchSize  Relative size of a glitch
+ */
+void MC11S_Sim::setNoise(float jitterPpm, float glitchRate, float glitchSize) {
+    _jitter = jitterPpm;
+    _glitchRate = glitchRate;
+    _glitchSize = glitchSize;
+    _rng = 1;
+}
+
+void MC11S_Sim::setOscillator(float intHz, float extHz) {
+    _oscHz[0] = intHz;
+    _oscHz[1] = extHz;
+}
+
+/**
+ * @brief  Single conversions take as long as on the chip. Off a board and
+ *         off Linux there is no clock to time them with and they stay instant.
+ * @param  on  true -> channels * (SCNT + RCNT) reference periods, false -> instant
+ */
+void MC11S_Sim::setRealTime(bool on) {
+#if MC11S_HAS_MICROS
+    _realTime = on;
+#else
+    (void)on;
+#endif
+    _convBusy = false;
+}
+
+/**
+ * @brief  Starts the single conversion CFG asks for. It completes at once,
+ *         or in real time after its conversion time: CFG keeps reading
+ *         SINGLE_CONV until then, like the chip's.
+ */
+void MC11S_Sim::startSingle(void) {
+    mc11s_ch_en_t ch_en;
+    mc11s_cfg_t cfg;
+    uint8_t channels;
+    uint16_t rcnt;
+
+    memcpy(&cfg, &_regs[MC11S_CFG], 1);
+
+    if (_realTime)
+    {
+        memcpy(&ch_en, &_regs[MC11S_CH_EN], 1);
+        channels = ch_en.ch0_en + ch_en.ch1_en;
+        rcnt = (uint16_t)((_regs[MC11S_RCNT_MSB] << 8) | _regs[MC11S_RCNT_LSB]);
+
+        _convUs = (uint32_t)((float)channels * (_regs[MC11S_SCNT] + rcnt) *
+                             (_regs[MC11S_FREF_DIV] + 1) * 1e6f / _oscHz[cfg.ref_clk_sel]);
+        _convStart = mc11s_micros();
+        _convBusy = true;
+        return;
+    }
+
+    convert();
+    cfg.os_sd = MC11S_STOP_CONV;
+    memcpy(&_regs[MC11S_CFG], &cfg, 1);
+}
+
+void MC11S_Sim::finishSingle(void) {
+    mc11s_cfg_t cfg;
+
+    if (!_convBusy || (uint32_t)(mc11s_micros() - _convStart) < _convUs)
+        return;
+
+    _convBusy = false;
+    memcpy(&cfg, &_regs[MC11S_CFG], 1);
+    if (cfg.os_sd != MC11S_SINGLE_CONV)
+        return;     // Stopped or switched over before it completed
+
+    convert();
+    cfg.os_sd = MC11S_STOP_CONV;
+    memcpy(&_regs[MC11S_CFG], &cfg, 1);
+}
+
+void MC11S_Sim::setTemperature(float degC) {
+    _temp = degC;
+}
+
+void MC11S_Sim::setProbeTempco(float ppm0, float ppm1, float refDegC) {
+    _tempco[0] = ppm0;
+    _tempco[1] = ppm1;
+    _tempRef = refDegC;
+}
+
+/**
+ * @brief  VT as a 10 bit, 5 V ADC would read it, from the typical transfer
+ *         V = (386.3 - T) / 560, with a uniform LSB of dither
+ * @param  handle  The MC11S_Sim
+ * @param  raw     ADC code
+ * @retval interface status (0 -> no Error)
+ */
+int32_t MC11S_Sim::readVt(void *handle, uint16_t *raw) {
+    MC11S_Sim *dev = (MC11S_Sim *)handle;
+    float code = (386.3f - dev->_temp) / 560.0f / 5.0f * 1023 + dev->uniform() - 0.5f;
+
+    *raw = (code <= 0) ? 0 : (code >= 1023) ? 1023 : (uint16_t)(code + 0.5f);
+    return 0;
+}
+
+float MC11S_Sim::uniform(void) {
+    // xorshift32, never 0
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    return ((_rng >> 8) + 1) / 16777216.0f;
+}
+
+float MC11S_Sim::gauss(void) {
+    // Box-Muller
+    float r = sqrtf(-2.0f * logf(uniform()));
+    return r * cosf(6.2831853f * uniform());
+}
+
+/**
+ * @brief  Converts the modelled capacitances with the register settings:
+ *         Fsensor = K * Idrv / C and each channel counts Fsensor / FIN_DIV
+ *         over RCNT periods of Fref = Fclk / (FREF_DIV + 1).
+ */
+void MC11S_Sim::convert(void) {
+    mc11s_drive_i_t drive;
+    mc11s_fin_div_t fin_div;
+    mc11s_glitch_filter_en_t glitch;
+    mc11s_cfg_t cfg;
+    uint16_t Idrv, rcnt, counts[2];
+    float fref, fin, sigma = 0;
+    uint8_t i;
+
+    if (_cap[0] <= 0 || _cap[1] <= 0)
+        return;
+
+    memcpy(&drive, &_regs[MC11S_DRIVE_I], 1);
+    memcpy(&fin_div, &_regs[MC11S_FIN_DIV], 1);
+    memcpy(&glitch, &_regs[MC11S_GLITCH_FILTER_EN], 1);
+    memcpy(&cfg, &_regs[MC11S_CFG], 1);
+
+    mc11s_drive_i_ua_get((mc11s_drive_i_status_t)drive.i0, &Idrv);
+    rcnt = (uint16_t)((_regs[MC11S_RCNT_MSB] << 8) | _regs[MC11S_RCNT_LSB]);
+    fref = _oscHz[cfg.ref_clk_sel] / (_regs[MC11S_FREF_DIV] + 1);
+    fin = (float)(1UL << fin_div.fin_div);
+
+    if (_jitter > 0 && rcnt > 0)
+        sigma = _jitter * 1e-6f * sqrtf(1024.0f / rcnt) * sqrtf(200.0f / Idrv);
+
+    for (i = 0; i < 2; i++) {
+        // Idrv in uA and C in pF, so Fsensor = K * Idrv / C MHz
+        float c = _cap[i] * (1.0f + _tempco[i] * 1e-6f * (_temp - _tempRef));
+        float f = (float)K * Idrv / c * 1e6f;
+        float n = f / fin * rcnt / fref;
+
+        if (_jitter > 0)
+            n += n * sigma * gauss() + uniform();
+
+        if (_glitchRate > 0 && uniform() <= _glitchRate && !glitch.filter_en)
+            n += (uniform() <= 0.5f ? -n : n) * _glitchSize;
+
+        if (n < 0)
+            n = 0;
+
+        counts[i] = (n >= 65535.0f) ? 0xFFFF : (uint16_t)n;
+    }
+
+    latchConversion(counts[0], counts[1]);
+}
+
+/**
+ * @brief  Finds the programmed trip points the way a bench test would: with
+ *         channel 1 held, channel 0 is ramped up one count at a time until
+ *         ALERT sets, then back down until it clears. Conversions go in
+ *         through latchConversion() and ALERT is read over the bus, so this
+ *         checks the whole path from setAlarmRatio() to the comparator.
+ * @param  tripRatio     Csensor / Cref at which ALERT set
+ * @param  releaseRatio  Csensor / Cref at which ALERT cleared
+ * @retval interface status (0 -> no Error, -1 -> alarm never tripped/released)
+ */
+int32_t MC11S_Sim::measureTripPoints(float *tripRatio, float *releaseRatio) {
+    const uint16_t ch1 = 4096;       // 1/64 of a comparator step per count
+    mc11s_alert_status_t alert;
+    float Coef_fix;
+    uint16_t ch0;
+    int32_t ret = 0;
+
+    latchConversion(1, ch1);
+    ret += getAlertStatus(&alert);
+    if (ret != 0 || alert.alert)
+        return -1;
+
+    for (ch0 = 1; ch0 < 0xFFFF; ch0++) {
+        latchConversion(ch0, ch1);
+        ret += getAlertStatus(&alert);
+        if (alert.alert)
+            break;
+    }
+    if (ret != 0 || !alert.alert)
+        return -1;
+
+    mc11s_coef_fix_get(&sensor, ch0, ch1, &Coef_fix);
+    *tripRatio = ((float)ch1 / ch0) * Coef_fix;
+
+    for (; ch0 > 0; ch0--) {
+        latchConversion(ch0, ch1);
+        ret += getAlertStatus(&alert);
+        if (!alert.alert)
+            break;
+    }
+    if (ret != 0 || alert.alert)
+        return -1;
+
+    mc11s_coef_fix_get(&sensor, ch0, ch1, &Coef_fix);
+    *releaseRatio = ((float)ch1 / ch0) * Coef_fix;
+
+    return 0;
+}
+
+uint8_t MC11S_Sim::peekReg(uint8_t addr) {
+    return _regs[addr % MC11S_SIM_REG_COUNT];
+}
+
+void MC11S_Sim::pokeReg(uint8_t addr, uint8_t val) {
+    _regs[addr % MC11S_SIM_REG_COUNT] = val;
+}
+
+uint32_t MC11S_Sim::getTransferCount(void) {
+    return _transfers;
+}
+
+void MC11S_Sim::clearTransferCount(void) {
+    _transfers = 0;
+}
+
+int32_t MC11S_Sim::read(void* device, uint8_t addr, uint8_t* data, uint16_t numData)
+{
+    MC11S_Sim *dev = (MC11S_Sim*)device;
+    mc11s_status_t status;
+
+    dev->_transfers++;
+    dev->busDelay(numData + 3);
+    dev->finishSingle();
+
+    while (numData > 0)
+    {
+        addr %= MC11S_SIM_REG_COUNT;
+        *data++ = dev->_regs[addr];
+
+        memcpy(&status, &dev->_regs[MC11S_STATUS], 1);
+
+        // Reading STATUS acknowledges a conversion interrupt, reading the LSB
+        // of a channel consumes its data ready flag
+        if (addr == MC11S_STATUS)
+            dev->_convPending = false;
+        else if (addr == MC11S_DATA_CH0_LSB)
+            status.drdy_ch0 = 0;
+        else if (addr == MC11S_DATA_CH1_LSB)
+            status.drdy_ch1 = 0;
+
+        memcpy(&dev->_regs[MC11S_STATUS], &status, 1);
+
+        addr++;
+        numData--;
+    }
+
+    return 0;
+}
+
+int32_t MC11S_Sim::write(void* device, uint8_t addr, const uint8_t* data, uint16_t numData)
+{
+    MC11S_Sim *dev = (MC11S_Sim*)device;
+
+    dev->_transfers++;
+    dev->busDelay(numData + 2);
+    dev->finishSingle();
+
+    while (numData > 0)
+    {
+        addr %= MC11S_SIM_REG_COUNT;
+
+        if (addr == MC11S_RESET)
+        {
+            // A software reset restores the defaults and reads back as complete
+            if (*data == MC11S_SW_RESET)
+                dev->powerOn();
+        }
+        else if (addr == MC11S_STATUS || addr == MC11S_DEVICE_ID_MSB || addr == MC11S_DEVICE_ID_LSB ||
+                 (addr >= MC11S_DATA_CH0_MSB && addr <= MC11S_DATA_CH1_LSB))
+        {
+            // read-only registers
+        }
+        else
+        {
+            dev->_regs[addr] = *data;
+
+            if (addr == MC11S_CFG)
+            {
+                mc11s_cfg_t cfg;
+
+                // A single conversion stops again when it completes
+                memcpy(&cfg, &dev->_regs[MC11S_CFG], 1);
+                if (cfg.os_sd == MC11S_SINGLE_CONV)
+                    dev->startSingle();
+            }
+        }
+
+        data++;
+        addr++;
+        numData--;
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+/******************************************************************************
+This file defines a simulated MC11S. It is a register-level model of the chip
+that plugs into the same read/write interface as the I2C transports, so the
+whole MC11S class (and everything built on top of it) can be exercised on a
+host or on a board without the sensor fitted.
+
+The model keeps the 128 byte register map, auto-increments the address on
+burst accesses, restores its power-on defaults on a software reset and
+evaluates the STATUS flags and the INTB pin whenever a conversion result is
+latched.
+
+Given the two capacitances with setCapacitance(), the model also converts by
+itself: writing MC11S_SINGLE_CONV runs one conversion with the counts the
+configured DRIVE_I, FIN_DIV, FREF_DIV and RCNT would give, saturating at
+0xFFFF, and then returns to MC11S_STOP_CONV.
+
+setNoise() adds a noise model to those conversions, so noise measurements
+can be rehearsed on a host:
+
+    jitter    Gaussian, jitterPpm of the count at 200 uA and RCNT = 1024,
+              falling with sqrt(RCNT) (longer gate) and sqrt(Idrv) (larger
+              swing). The fractional count is dithered, so the average of
+              many conversions is the exact count.
+    glitches  with probability glitchRate a channel is off by +/-glitchSize
+              of its count, unless the glitch filter is enabled.
+
+The noise comes from a fixed-seed generator, so every run is the same.
+
+The model's reference clocks run at their nominal frequencies unless
+setOscillator() puts them elsewhere. A single conversion completes the
+moment it is started, unless setRealTime() is on: then it takes as long as
+it would on the chip at those clocks (channels * (SCNT + RCNT) reference
+periods), completing at the first bus access after that, which is what
+calibrateClock() needs to measure the correction.
+
+setIntbHandler() stands in for the MCU's INTB interrupt: the handler is
+called the moment a latched conversion asserts INTB (the falling edge), so
+interrupt-driven code runs on a host unchanged. setBusRate() makes every
+bus transaction take as long as it would on an I2C bus at that clock
+(9 bits per byte, address included), for latency measurements.
+setBusRate() and setRealTime() wait on mc11s_micros() (MC11S_Time.h), so
+they only take effect on a board or on Linux; elsewhere everything stays
+instant.
+
+setTemperature() sets the die/probe temperature. The capacitances drift
+with it by the coefficients given to setProbeTempco(), and readVt() is an
+ADC hook for setTempAdc() that returns the VT voltage for it as a dithered
+10 bit code at 5 V, like an Uno's analogRead().
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Sim_H__
+#define __MC11S_Sim_H__
+
+#include "MC11S_class.h"
+
+// Size of the MC11S register map
+#define MC11S_SIM_REG_COUNT		0x80
+
+class MC11S_Sim : public MC11S
+{
+    public:
+        MC11S_Sim(void);
+
+        bool begin(void);
+        void powerOn(void);					// Restores the power-on register defaults
+
+        void latchConversion(uint16_t ch0, uint16_t ch1);	// Loads a conversion result and updates STATUS/INTB
+        bool getIntb(void);					// True while the (active low) INTB pin is asserted
+        void setIntbHandler(void (*handler)(void *), void *arg = NULL);	// Called on each INTB falling edge (NULL -> none)
+        void setBusRate(uint32_t hz);		// Bus transactions take as long as at this I2C clock (0 -> instant)
+
+        void setCapacitance(float c0pF, float c1pF);	// Capacitances the model converts (0 -> none)
+        void convert(void);					// One conversion of those at the current settings
+        void setNoise(float jitterPpm, float glitchRate = 0, float glitchSize = 0.02f);	// Noise added by convert() (0 -> none)
+        void setOscillator(float intHz, float extHz = MC11S_EXT_CLK_HZ);	// Actual reference clocks the model converts with
+        void setRealTime(bool on);			// Single conversions take their conversion time (false -> instant)
+        void setTemperature(float degC);
+        void setProbeTempco(float ppm0, float ppm1, float refDegC = 25.0f);	// Drift of the modelled capacitances
+        static int32_t readVt(void *, uint16_t *);	// ADC hook: pass with the MC11S_Sim as handle
+
+        int32_t measureTripPoints(float *tripRatio, float *releaseRatio);	// Sweeps the input to find where ALERT sets/clears
+
+        uint8_t peekReg(uint8_t addr);		// Register access that bypasses the bus and its side effects
+        void pokeReg(uint8_t addr, uint8_t val);
+
+        uint32_t getTransferCount(void);	// Number of bus transactions seen so far
+        void clearTransferCount(void);
+
+        static int32_t read(void *, uint8_t, uint8_t *, uint16_t);
+        static int32_t write(void *, uint8_t, const uint8_t *, uint16_t);
+    protected:
+        uint8_t _regs[MC11S_SIM_REG_COUNT];
+        bool _convPending;					// INTB_MODE = conversion: set on latch, cleared by a STATUS read
+        uint32_t _transfers;
+        float _cap[2];
+        float _jitter, _glitchRate, _glitchSize;
+        float _oscHz[2];					// Internal, external reference clock
+        float _temp, _tempRef;
+        float _tempco[2];
+        uint32_t _rng;
+        void (*_intbHandler)(void *);
+        void *_intbArg;
+        uint32_t _busHz;
+        bool _realTime;
+        bool _convBusy;						// A timed single conversion is running
+        uint32_t _convStart, _convUs;
+
+    private:
+        float uniform(void);				// (0, 1]
+        float gauss(void);					// Zero mean, unit variance
+        void busDelay(uint32_t bytes);		// Time a transaction of this many bytes takes on the bus
+        void startSingle(void);				// Starts a single conversion, timed or instant
+        void finishSingle(void);			// Completes a timed single conversion once it is due
+};
+
+#endif
@@ -0,0 +1,246 @@
+/******************************************************************************
+This file defines the online statistics kept per MC11S channel: count, mean,
+variance, min, max and peak-to-peak, over a tumbling window, a sliding window
+or everything since the last reset. Nothing is allocated and every query is
+O(1), so the numbers can be read at any time from loop().
+
+  MC11S_RunningStats<T>      Welford mean/variance plus min/max since reset
+  MC11S_TumblingStats<T>     consecutive blocks of n samples; the last
+                             completed block stays readable while the next
+                             one fills
+  MC11S_SlidingStats<T, N>   the most recent N samples. Integer samples only:
+                             sums are kept exactly in 64 bit so the variance
+                             never drifts however long it runs; min/max come
+                             from monotonic queues (amortised O(1) per sample)
+  MC11S_ChannelStats<N>      sliding + tumbling statistics for both channels,
+                             fed straight from MC11S::getData()
+
+The standard deviation of a quiet probe is its noise floor: use it to size
+the TRH/TRL margins, and watch it grow to spot a probe that is degrading.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0
+    Hardware Platform: Arduino Uno
+******************************************************************************/
+#ifndef __MC11S_Stats_H__
+#define __MC11S_Stats_H__
+
+#include <stdint.h>
+#include <math.h>
+
+template <typename T>
+class MC11S_RunningStats {
+	public:
+		MC11S_RunningStats(void) { reset(); }
+
+		void reset(void) {
+			_count = 0;
+			_mean = 0;
+			_m2 = 0;
+			_min = 0;
+			_max = 0;
+		}
+
+		void add(T x) {
+			float delta = (float)x - _mean;
+
+			_count++;
+			_mean += delta / _count;
+			_m2 += delta * ((float)x - _mean);
+
+			if (_count == 1 || x < _min)
+				_min = x;
+			if (_count == 1 || x > _max)
+				_max = x;
+		}
+
+		uint32_t getCount(void) { return _count; }
+		float getMean(void) { return _mean; }
+		float getVariance(void) { return _count > 1 ? _m2 / (_count - 1) : 0; }		// Sample variance
+		float getStdDev(void) { return sqrtf(getVariance()); }
+		T getMin(void) { return _count ? _min : 0; }		// 0 when empty
+		T getMax(void) { return _count ? _max : 0; }
+		T getPeakToPeak(void) { return (T)(getMax() - getMin()); }
+
+	private:
+		uint32_t _count;
+		float _mean;
+		float _m2;
+		T _min;
+		T _max;
+};
+
+template <typename T>
+class MC11S_TumblingStats {
+	public:
+		MC11S_TumblingStats(void) : _window{64} { }
+
+		void setWindow(uint32_t n) { _window = n ? n : 1; }		// Samples per block
+		uint32_t getWindow(void) { return _window; }
+
+		void reset(void) {
+			_current.reset();
+			_last.reset();
+		}
+
+		/**
+		 * @brief  Adds a sample to the current block.
+		 * @retval true when this sample completed a block (now in last())
+		 */
+		bool add(T x) {
+			_current.add(x);
+
+			if (_current.getCount() < _window)
+				return false;
+
+			_last = _current;
+			_current.reset();
+			return true;
+		}
+
+		MC11S_RunningStats<T> &current(void) { return _current; }	// Block being filled
+		MC11S_RunningStats<T> &last(void) { return _last; }			// Last completed block
+
+	private:
+		MC11S_RunningStats<T> _current;
+		MC11S_RunningStats<T> _last;
+		uint32_t _window;
+};
+
+template <typename T, uint8_t N>
+class MC11S_SlidingStats {
+		static_assert(N > 1, "MC11S_SlidingStats needs a window of at least two samples");
+	public:
+		MC11S_SlidingStats(void) { reset(); }
+
+		void reset(void) {
+			_idx = 0;
+			_count = 0;
+			_seen = 0;
+			_sum = 0;
+			_sumSq = 0;
+			_minHead = _minTail = _minLen = 0;
+			_maxHead = _maxTail = _maxLen = 0;
+		}
+
+		void add(T x) {
+			if (_count == N) {
+				T old = _ring[_idx];
+
+				_sum -= old;
+				_sumSq -= (uint64_t)((int64_t)old * old);
+				_count--;
+			}
+
+			_ring[_idx] = x;
+			_idx = (_idx + 1 == N) ? 0 : _idx + 1;
+			_sum += x;
+			_sumSq += (uint64_t)((int64_t)x * x);
+			_count++;
+
+			pushQueue(_minQ, _minHead, _minTail, _minLen, x, true);
+			pushQueue(_maxQ, _maxHead, _maxTail, _maxLen, x, false);
+			_seen++;
+		}
+
+		uint8_t getCount(void) { return _count; }
+		float getMean(void) { return _count ? (float)_sum / _count : 0; }
+
+		float getVariance(void) {
+			// n * sum(x^2) - sum(x)^2 is exact in 64 bits for 16 bit samples
+			if (_count < 2)
+				return 0;
+			int64_t num = (int64_t)_count * (int64_t)_sumSq - _sum * _sum;
+			return (float)num / ((float)_count * (_count - 1));
+		}
+
+		float getStdDev(void) { return sqrtf(getVariance()); }
+		T getMin(void) { return _minLen ? _minQ[_minHead].val : 0; }		// 0 when empty
+		T getMax(void) { return _maxLen ? _maxQ[_maxHead].val : 0; }
+		T getPeakToPeak(void) { return (T)(getMax() - getMin()); }
+
+	private:
+		struct entry_t {
+			T val;
+			uint32_t seq;		// Sample number, tells when the entry leaves the window
+		};
+
+		/**
+		 * @brief  Monotonic queue update. Entries that can never be the extreme
+		 *         again (older and not better than x) are dropped from the tail,
+		 *         the one that just left the window from the head.
+		 */
+		void pushQueue(entry_t *q, uint8_t &head, uint8_t &tail, uint8_t &len, T x, bool isMin) {
+			if (len > 0 && _seen - q[head].seq >= N) {
+				head = (head + 1 == N) ? 0 : head + 1;
+				len--;
+			}
+
+			while (len > 0) {
+				uint8_t last = (tail == 0) ? N - 1 : tail - 1;
+
+				if (isMin ? (q[last].val < x) : (q[last].val > x))
+					break;
+				tail = last;
+				len--;
+			}
+
+			q[tail].val = x;
+			q[tail].seq = _seen;
+			tail = (tail + 1 == N) ? 0 : tail + 1;
+			len++;
+		}
+
+		T _ring[N];
+		entry_t _minQ[N];
+		entry_t _maxQ[N];
+		uint8_t _idx, _count;
+		uint8_t _minHead, _minTail, _minLen;
+		uint8_t _maxHead, _maxTail, _maxLen;
+		uint32_t _seen;
+		int64_t _sum;
+		uint64_t _sumSq;
+};
+
+/**
+ * @brief  Sliding (last N samples) and tumbling (blocks of setWindow()
+ *         samples) statistics for both MC11S channels.
+ */
+template <uint8_t N>
+class MC11S_ChannelStats {
+	public:
+		void setWindow(uint32_t n) {
+			_block[0].setWindow(n);
+			_block[1].setWindow(n);
+		}
+
+		void reset(void) {
+			for (uint8_t i = 0; i < 2; i++) {
+				_recent[i].reset();
+				_block[i].reset();
+			}
+		}
+
+		/**
+		 * @brief  Adds one conversion result.
+		 * @retval true when a tumbling block completed on both channels
+		 */
+		bool add(uint16_t ch0, uint16_t ch1) {
+			_recent[0].add(ch0);
+			_recent[1].add(ch1);
+
+			bool done0 = _block[0].add(ch0);
+			bool done1 = _block[1].add(ch1);
+
+			return done0 && done1;
+		}
+
+		MC11S_SlidingStats<uint16_t, N> &sliding(uint8_t ch) { return _recent[ch & 1]; }
+		MC11S_TumblingStats<uint16_t> &tumbling(uint8_t ch) { return _block[ch & 1]; }
+
+	private:
+		MC11S_SlidingStats<uint16_t, N> _recent[2];
+		MC11S_TumblingStats<uint16_t> _block[2];
+};
+
+#endif
@@ -0,0 +1,443 @@
+#include "MC11S_Stream.h"
+#include "MC11S_Crc.h"
+#include <string.h>
+
+#define MC11S_STREAM_HEADER_LEN		3
+#define MC11S_STREAM_MIN_FRAME		(MC11S_STREAM_HEADER_LEN + 1 + 2)
+
+static uint8_t mc11s_stream_status(const mc11s_status_t &status) {
+	uint8_t raw;
+
+	memcpy(&raw, &status, 1);
+	return raw;
+}
+
+static uint32_t mc11s_stream_get32(const uint8_t *p) {
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Reads a varint from data[*pos] up to end, false when it runs past end or 32 bits
+static bool mc11s_stream_varint(const uint8_t *data, uint8_t *pos, uint8_t end, uint32_t *v) {
+	uint8_t shift = 0;
+
+	*v = 0;
+	while (*pos < end && shift < 35) {
+		uint8_t b = data[(*pos)++];
+
+		*v |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+		shift += 7;
+	}
+
+	return false;
+}
+
+static bool mc11s_stream_zigzag(const uint8_t *data, uint8_t *pos, uint8_t end, int32_t *v) {
+	uint32_t u;
+
+	if (!mc11s_stream_varint(data, pos, end, &u))
+		return false;
+
+	*v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+	return true;
+}
+
+MC11S_StreamEncoder::MC11S_StreamEncoder(void) :
+	_out{NULL}, _source{0}, _frameSeq{0}, _keyInterval{32}, _sinceKey{0},
+	_batch{1}, _count{0}, _keyDue{true}, _len{0}, _countPos{0}, _prevStep{0},
+	_samples{0}, _frames{0}, _bytes{0}
+{
+	memset(&_prev, 0, sizeof(_prev));
+}
+
+/**
+ * @brief  			Starts a stream; the first sample goes out in a key frame
+ * @param	out		Destination, e.g. Serial
+ * @param	source	Sensor id carried in every frame
+ */
+void MC11S_StreamEncoder::begin(Print &out, uint8_t source) {
+	_out = &out;
+	_source = source;
+	_frameSeq = 0;
+	_len = 0;
+	_count = 0;
+	_keyDue = true;
+	resetStats();
+}
+
+void MC11S_StreamEncoder::setKeyframeInterval(uint16_t samples) {
+	_keyInterval = samples ? samples : 1;
+}
+
+void MC11S_StreamEncoder::setBatch(uint8_t samples) {
+	_batch = (samples == 0) ? 1 : (samples > MC11S_STREAM_BATCH) ? MC11S_STREAM_BATCH : samples;
+}
+
+void MC11S_StreamEncoder::keyframe(void) {
+	_keyDue = true;
+}
+
+void MC11S_StreamEncoder::putVarint(uint32_t v) {
+	while (v >= 0x80) {
+		_buf[_len++] = (uint8_t)v | 0x80;
+		v >>= 7;
+	}
+	_buf[_len++] = (uint8_t)v;
+}
+
+void MC11S_StreamEncoder::putZigzag(int32_t v) {
+	putVarint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+/**
+ * @brief  			Adds a sample to the stream, as a key sample or as a delta to
+ * 					the one before it, and writes the frame once it holds the
+ * 					batch size
+ * @param	sample	Next sample, normally with a larger seq than the last
+ * @retval  		Error code (0 -> no Error, -1 -> no begin() or a short write)
+ */
+int32_t MC11S_StreamEncoder::add(const mc11s_sample_t &sample) {
+	uint32_t seqStep = sample.seq - _prev.seq;
+	int32_t step = (int32_t)(sample.timestamp - _prev.timestamp);
+	uint8_t status = mc11s_stream_status(sample.status);
+	bool changed = (status != mc11s_stream_status(_prev.status));
+	int32_t ret = 0;
+
+	if (_out == NULL)
+		return -1;
+
+	if (_keyDue || _sinceKey >= _keyInterval || seqStep == 0 || seqStep > 0x80000000UL) {
+		ret = flush();
+
+		_buf[0] = (MC11S_STREAM_VERSION << 4) | MC11S_STREAM_KEY;
+		_buf[1] = _source;
+		_buf[2] = _frameSeq;
+		_len = MC11S_STREAM_HEADER_LEN;
+		for (uint8_t i = 0; i < 4; i++)
+			_buf[_len++] = (uint8_t)(sample.seq >> (8 * i));
+		for (uint8_t i = 0; i < 4; i++)
+			_buf[_len++] = (uint8_t)(sample.timestamp >> (8 * i));
+		_buf[_len++] = (uint8_t)sample.ch0;
+		_buf[_len++] = (uint8_t)(sample.ch0 >> 8);
+		_buf[_len++] = (uint8_t)sample.ch1;
+		_buf[_len++] = (uint8_t)(sample.ch1 >> 8);
+		_buf[_len++] = status;
+		_countPos = _len;
+		_buf[_len++] = 0;
+
+		_keyDue = false;
+		_sinceKey = 0;
+		_prevStep = 0;
+	} else {
+		if (_len == 0) {
+			_buf[0] = (MC11S_STREAM_VERSION << 4) | MC11S_STREAM_DELTA;
+			_buf[1] = _source;
+			_buf[2] = _frameSeq;
+			_len = MC11S_STREAM_HEADER_LEN;
+			_countPos = _len;
+			_buf[_len++] = 0;
+		}
+
+		putVarint((seqStep - 1) << 1 | (changed ? 1 : 0));
+		if (changed)
+			_buf[_len++] = status;
+		putZigzag((int32_t)((uint32_t)step - (uint32_t)_prevStep));
+		putZigzag((int32_t)sample.ch0 - _prev.ch0);
+		putZigzag((int32_t)sample.ch1 - _prev.ch1);
+		_buf[_countPos]++;
+
+		_prevStep = step;
+	}
+
+	_prev = sample;
+	_sinceKey++;
+	_count++;
+	_samples++;
+
+	if (_count >= _batch)
+		ret += flush();
+
+	return ret;
+}
+
+/**
+ * @brief  			Writes the frame being filled, if any: CRC, COBS and the
+ * 					0x00 delimiter
+ * @retval  		Error code (0 -> no Error, -1 -> short write)
+ */
+int32_t MC11S_StreamEncoder::flush(void) {
+	uint16_t crc;
+	uint8_t start = 0, i, code;
+	size_t n = 0, want;
+
+	if (_len == 0)
+		return 0;
+
+	crc = mc11s_crc16(_buf, _len);
+	_buf[_len++] = (uint8_t)crc;
+	_buf[_len++] = (uint8_t)(crc >> 8);
+
+	// The frame is shorter than 254 bytes: one code byte per run up to a zero
+	want = _len + 2;
+	for (i = 0; i <= _len; i++) {
+		if (i < _len && _buf[i] != 0)
+			continue;
+
+		code = i - start + 1;
+		n += _out->write(code);
+		if (i > start)
+			n += _out->write(&_buf[start], i - start);
+		start = i + 1;
+	}
+	n += _out->write((uint8_t)0);
+
+	_bytes += n;
+	_frames++;
+	_frameSeq++;
+	_len = 0;
+	_count = 0;
+
+	return (n == want) ? 0 : -1;
+}
+
+uint32_t MC11S_StreamEncoder::getSampleCount(void) {
+	return _samples;
+}
+
+uint32_t MC11S_StreamEncoder::getFrameCount(void) {
+	return _frames;
+}
+
+uint32_t MC11S_StreamEncoder::getByteCount(void) {
+	return _bytes;
+}
+
+void MC11S_StreamEncoder::resetStats(void) {
+	_samples = 0;
+	_frames = 0;
+	_bytes = 0;
+}
+
+MC11S_StreamDecoder::MC11S_StreamDecoder(void) :
+	_handler{NULL}, _handlerArg{NULL}
+{
+	reset();
+}
+
+void MC11S_StreamDecoder::onSample(mc11s_stream_handler_t handler, void *arg) {
+	_handler = handler;
+	_handlerArg = arg;
+}
+
+void MC11S_StreamDecoder::reset(void) {
+	uint8_t i;
+
+	_len = 0;
+	_overrun = false;
+	for (i = 0; i < MC11S_STREAM_SOURCES; i++) {
+		_sources[i].used = false;
+		_sources[i].synced = false;
+	}
+	_samples = 0;
+	_frames = 0;
+	_errors = 0;
+	_lost = 0;
+	_skipped = 0;
+	_bytes = 0;
+}
+
+/**
+ * @brief  			Takes the next byte of the stream; a 0x00 completes a frame,
+ * 					whose samples go to the handler
+ * @param	byte	Next byte
+ */
+void MC11S_StreamDecoder::push(uint8_t byte) {
+	uint8_t in = 0, out = 0, code, i;
+
+	_bytes++;
+
+	if (byte != 0) {
+		if (_len < sizeof(_buf))
+			_buf[_len++] = byte;
+		else
+			_overrun = true;
+		return;
+	}
+
+	if (_len == 0)
+		return;
+	if (_overrun) {
+		_errors++;
+		_len = 0;
+		_overrun = false;
+		return;
+	}
+
+	// COBS decode in place, the output never overtakes the input
+	while (in < _len) {
+		code = _buf[in++];
+		for (i = 1; i < code; i++) {
+			if (in >= _len) {
+				_errors++;
+				_len = 0;
+				return;
+			}
+			_buf[out++] = _buf[in++];
+		}
+		if (code < 0xFF && in < _len)
+			_buf[out++] = 0;
+	}
+
+	_len = 0;
+	if (frame(_buf, out) != 0)
+		_errors++;
+}
+
+void MC11S_StreamDecoder::push(const uint8_t *data, size_t len) {
+	while (len--)
+		push(*data++);
+}
+
+MC11S_StreamDecoder::source_t *MC11S_StreamDecoder::lookup(uint8_t source) {
+	uint8_t i;
+
+	for (i = 0; i < MC11S_STREAM_SOURCES; i++)
+		if (_sources[i].used && _sources[i].source == source)
+			return &_sources[i];
+
+	for (i = 0; i < MC11S_STREAM_SOURCES; i++) {
+		if (!_sources[i].used) {
+			_sources[i].used = true;
+			_sources[i].started = false;
+			_sources[i].synced = false;
+			_sources[i].source = source;
+			_sources[i].frameSeq = 0;
+			return &_sources[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief  			Checks and unpacks one decoded frame
+ * @param	data	Frame without COBS and delimiter
+ * @param	len		Its length
+ * @retval  		Error code (0 -> no Error, also for a frame that was skipped)
+ */
+int32_t MC11S_StreamDecoder::frame(uint8_t *data, uint8_t len) {
+	source_t *src;
+	mc11s_sample_t sample;
+	uint8_t pos = MC11S_STREAM_HEADER_LEN, end, count, kind, status, i;
+	uint32_t v;
+	int32_t dd, d0, d1;
+
+	if (len < MC11S_STREAM_MIN_FRAME)
+		return -1;
+	end = len - 2;
+	if (mc11s_crc16(data, end) != (uint16_t)(data[end] | (data[end + 1] << 8)))
+		return -1;
+	if ((data[0] >> 4) != MC11S_STREAM_VERSION)
+		return -1;
+	kind = data[0] & 0x0F;
+	if (kind != MC11S_STREAM_KEY && kind != MC11S_STREAM_DELTA)
+		return -1;
+
+	src = lookup(data[1]);
+	if (src == NULL)
+		return -1;
+
+	if (src->started && data[2] != src->frameSeq) {
+		_lost += (uint8_t)(data[2] - src->frameSeq);
+		src->synced = false;
+	}
+	src->started = true;
+	src->frameSeq = data[2] + 1;
+	_frames++;
+
+	if (kind == MC11S_STREAM_KEY) {
+		if (end - pos < MC11S_STREAM_KEY_LEN + 1) {
+			src->synced = false;
+			return -1;
+		}
+		memset(&sample, 0, sizeof(sample));
+		sample.seq = mc11s_stream_get32(&data[pos]);
+		sample.timestamp = mc11s_stream_get32(&data[pos + 4]);
+		sample.ch0 = (uint16_t)(data[pos + 8] | (data[pos + 9] << 8));
+		sample.ch1 = (uint16_t)(data[pos + 10] | (data[pos + 11] << 8));
+		memcpy(&sample.status, &data[pos + 12], 1);
+		pos += MC11S_STREAM_KEY_LEN;
+
+		src->prev = sample;
+		src->prevStep = 0;
+		src->synced = true;
+		_samples++;
+		if (_handler != NULL)
+			_handler(_handlerArg, src->source, sample);
+	} else if (!src->synced) {
+		_skipped++;
+		return 0;
+	}
+
+	// Deltas: a frame that turns out malformed still delivered its samples up to there
+	count = data[pos++];
+	for (i = 0; i < count; i++) {
+		sample = src->prev;
+
+		if (!mc11s_stream_varint(data, &pos, end, &v))
+			break;
+		if (v & 1) {
+			if (pos >= end)
+				break;
+			status = data[pos++];
+			memcpy(&sample.status, &status, 1);
+		}
+		if (!mc11s_stream_zigzag(data, &pos, end, &dd) ||
+			!mc11s_stream_zigzag(data, &pos, end, &d0) ||
+			!mc11s_stream_zigzag(data, &pos, end, &d1))
+			break;
+
+		sample.seq += (v >> 1) + 1;
+		src->prevStep = (int32_t)((uint32_t)src->prevStep + (uint32_t)dd);
+		sample.timestamp += (uint32_t)src->prevStep;
+		sample.ch0 = (uint16_t)(sample.ch0 + d0);
+		sample.ch1 = (uint16_t)(sample.ch1 + d1);
+
+		src->prev = sample;
+		_samples++;
+		if (_handler != NULL)
+			_handler(_handlerArg, src->source, sample);
+	}
+
+	if (i != count || pos != end) {
+		src->synced = false;
+		return -1;
+	}
+
+	return 0;
+}
+
+uint32_t MC11S_StreamDecoder::getSampleCount(void) {
+	return _samples;
+}
+
+uint32_t MC11S_StreamDecoder::getFrameCount(void) {
+	return _frames;
+}
+
+uint32_t MC11S_StreamDecoder::getErrorCount(void) {
+	return _errors;
+}
+
+uint32_t MC11S_StreamDecoder::getLostCount(void) {
+	return _lost;
+}
+
+uint32_t MC11S_StreamDecoder::getSkippedCount(void) {
+	return _skipped;
+}
+
+uint32_t MC11S_StreamDecoder::getByteCount(void) {
+	return _bytes;
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+This file defines the binary telemetry stream: samples from one or more
+MC11S sent over a serial link (or written to a file) at a fraction of the
+size of CSV, and the decoder that reconstructs them on the other side.
+
+Each frame is COBS encoded and ends in a 0x00, so a receiver that starts
+listening in the middle of a stream, or loses bytes, finds the start of
+the next frame at the next 0x00. Before COBS a frame is
+
+    u8 type         MC11S_STREAM_VERSION << 4 | MC11S_STREAM_KEY or _DELTA
+    u8 source       sensor id, so many sensors can share one link
+    u8 frame seq    per source, +1 every frame: a gap is a lost frame
+    key sample      KEY frames only: u32 seq, u32 timestamp, u16 ch0,
+                    u16 ch1, u8 status (little-endian, absolute)
+    u8 count        delta samples that follow
+    delta samples   each relative to the sample before it:
+                      varint (seq step - 1) << 1 | status changed
+                      u8 status, if it changed
+                      zigzag varint timestamp step - previous step
+                      zigzag varint ch0 step
+                      zigzag varint ch1 step
+    u16 CRC         CRC-16/CCITT-FALSE (MC11S_Crc.h) of everything before it
+
+At a steady rate with a slowly moving level a delta sample is 4-6 bytes
+where the CSV line of MC11S_SampleWriter is about 30. A key frame restarts
+the chain every setKeyframeInterval() samples (and for the first sample,
+after keyframe(), or when seq doesn't move forward), so a lost or
+corrupted frame costs the samples up to the next key frame and no more;
+the decoder drops delta frames until it has one. setBatch() puts up to
+MC11S_STREAM_BATCH samples in one frame, which spreads the 8 bytes of
+framing over them at the cost of latency.
+
+Nothing is allocated on either side. The encoder writes to any Print; the
+decoder takes bytes as they arrive and calls a handler for every sample it
+reconstructs, keeping the state of up to MC11S_STREAM_SOURCES sources.
+The host decoder and its command line tools are in extras/stream.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Stream_H__
+#define __MC11S_Stream_H__
+
+#include "MC11S_Sampler.h"
+#include "MC11S_Print.h"
+
+#define MC11S_STREAM_VERSION		1
+#define MC11S_STREAM_KEY			0x1
+#define MC11S_STREAM_DELTA			0x2
+
+// Samples per frame at most
+#ifndef MC11S_STREAM_BATCH
+#define MC11S_STREAM_BATCH			8
+#endif
+
+// Sources one decoder keeps track of
+#ifndef MC11S_STREAM_SOURCES
+#define MC11S_STREAM_SOURCES		8
+#endif
+
+#define MC11S_STREAM_KEY_LEN		13		// Absolute sample
+#define MC11S_STREAM_DELTA_MAX		17		// Delta sample at worst
+#define MC11S_STREAM_MAX_FRAME		(3 + MC11S_STREAM_KEY_LEN + 1 + MC11S_STREAM_BATCH * MC11S_STREAM_DELTA_MAX + 2)
+
+static_assert(MC11S_STREAM_MAX_FRAME < 254, "MC11S_STREAM_BATCH too large for single block COBS");
+
+// Called by the decoder for every sample, in order
+typedef void (*mc11s_stream_handler_t)(void *arg, uint8_t source, const mc11s_sample_t &sample);
+
+class MC11S_StreamEncoder {
+	public:
+		MC11S_StreamEncoder(void);
+
+		void begin(Print &out, uint8_t source = 0);
+		void setKeyframeInterval(uint16_t samples);	// Default 32 (1 -> every sample absolute)
+		void setBatch(uint8_t samples);				// Samples per frame, 1 .. MC11S_STREAM_BATCH (default 1)
+		void keyframe(void);						// The next sample starts a key frame
+
+		int32_t add(const mc11s_sample_t &sample);	// Writes a frame when one is complete
+		int32_t flush(void);						// Writes the samples held back by setBatch()
+
+		uint32_t getSampleCount(void);
+		uint32_t getFrameCount(void);
+		uint32_t getByteCount(void);				// Bytes written, framing included
+		void resetStats(void);
+
+	private:
+		void putVarint(uint32_t v);
+		void putZigzag(int32_t v);
+
+		Print *_out;
+		uint8_t _source, _frameSeq;
+		uint16_t _keyInterval, _sinceKey;
+		uint8_t _batch, _count;
+		bool _keyDue;
+
+		uint8_t _buf[MC11S_STREAM_MAX_FRAME];
+		uint8_t _len, _countPos;
+		mc11s_sample_t _prev;
+		int32_t _prevStep;
+
+		uint32_t _samples, _frames, _bytes;
+};
+
+class MC11S_StreamDecoder {
+	public:
+		MC11S_StreamDecoder(void);
+
+		void onSample(mc11s_stream_handler_t handler, void *arg = NULL);
+		void push(uint8_t byte);
+		void push(const uint8_t *data, size_t len);
+		void reset(void);							// Forgets every source and any partial frame
+
+		uint32_t getSampleCount(void);
+		uint32_t getFrameCount(void);				// Good frames
+		uint32_t getErrorCount(void);				// Frames with a bad CRC or layout
+		uint32_t getLostCount(void);				// Frames missing from the frame seq
+		uint32_t getSkippedCount(void);				// Delta frames dropped waiting for a key frame
+		uint32_t getByteCount(void);
+
+	private:
+		typedef struct {
+			uint8_t source;
+			bool used;
+			bool started;			// Has had a frame, frameSeq is known
+			bool synced;			// Has the sample the next delta builds on
+			uint8_t frameSeq;		// Expected next
+			mc11s_sample_t prev;
+			int32_t prevStep;
+		} source_t;
+
+		int32_t frame(uint8_t *data, uint8_t len);
+		source_t *lookup(uint8_t source);
+
+		mc11s_stream_handler_t _handler;
+		void *_handlerArg;
+
+		uint8_t _buf[MC11S_STREAM_MAX_FRAME + 2];
+		uint8_t _len;
+		bool _overrun;
+		source_t _sources[MC11S_STREAM_SOURCES];
+
+		uint32_t _samples, _frames, _errors, _lost, _skipped, _bytes;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/******************************************************************************
+This file defines the free running microsecond clock the library times
+things with: micros() on Arduino, CLOCK_MONOTONIC on Linux. Both wrap at
+2^32 us (about 71 minutes), so differences taken as uint32_t are right
+across the wrap. mc11s_micros() has the signature of micros() and is the
+default timebase of the classes that take one (setTimebase()).
+
+Other hosts have no clock: MC11S_HAS_MICROS is 0 there and mc11s_micros()
+returns 0, so anything that waits on it must check MC11S_HAS_MICROS first.
+
+Development environment specifics:
+    IDE: Arduino 2.1.0 / g++ (C++11)
+    Hardware Platform: any
+******************************************************************************/
+#ifndef __MC11S_Time_H__
+#define __MC11S_Time_H__
+
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#define MC11S_HAS_MICROS		1
+#elif defined(__linux__)
+#include <time.h>
+#define MC11S_HAS_MICROS		1
+#else
+#define MC11S_HAS_MICROS		0
+#endif
+
+static inline unsigned long mc11s_micros(void) {
+#if defined(ARDUINO)
+	return micros();
+#elif defined(__linux__)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+#else
+	return 0;
+#endif
+}
+
+#endif
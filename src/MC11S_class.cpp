@@ -27,8 +27,13 @@ THE SOFTWARE.
 version 0.1
 */
 
+#if defined(ARDUINO)
 #include <Arduino.h>
-#include "mc11s_class.h"
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+#include "MC11S_class.h"
+#include "MC11S_Time.h"
 
 // #define SPI_READ 0x80
 
@@ -105,6 +110,10 @@ int32_t MC11S::getTrhOfDStatus(mc11s_trh_of_d_status_t *statusVal) {
  * @retval  Error code (0 -> no Error)
  */
 int32_t MC11S::reset() {
+	_refClkSel = MC11S_SEL_INT_CLK;
+	_chEn = 0x3;
+	_alertActive = false;
+	_rangeValid = false;
 	return mc11s_reset(&sensor);
 }
 
@@ -126,6 +135,46 @@ int32_t MC11S::getCh1Data(uint16_t *ch1Val) {
 	return mc11s_data_ch1_get(&sensor, ch1Val);
 }
 
+/**
+ * @brief  			Get Channel0 and Channel1 raw data in a single bus transaction
+ * @param	ch0Val	Channel0 data register
+ * @param	ch1Val	Channel1 data register
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::getData(uint16_t *ch0Val, uint16_t *ch1Val) {
+	return mc11s_data_get(&sensor, ch0Val, ch1Val);
+}
+
+/**
+ * @brief  			Reads STATUS, then both channels: the flags as latched with the data
+ * @param	status	STATUS register (alert, trh_of_d and data ready flags)
+ * @param	ch0Val	Channel0 raw data
+ * @param	ch1Val	Channel1 raw data
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::getStatusData(mc11s_status_t *status, uint16_t *ch0Val, uint16_t *ch1Val) {
+	return mc11s_status_data_get(&sensor, status, ch0Val, ch1Val);
+}
+
+/**
+ * @brief  			Get STATUS
+ * @param	status	STATUS register (alert, trh_of_d and data ready flags)
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::getStatus(mc11s_status_t *status) {
+	return mc11s_status_get(&sensor, status);
+}
+
+/**
+ * @brief  			Whether a STATUS value reports a complete conversion: DRDY set
+ * 					for each channel enabled through setCh0En/setCh1En
+ * @param	status	STATUS as read
+ * @retval  		true when the data of every enabled channel is ready
+ */
+bool MC11S::isDataReady(mc11s_status_t status) {
+	return _chEn != 0 && (status.drdy_ch0 || !(_chEn & 0x1)) && (status.drdy_ch1 || !(_chEn & 0x2));
+}
+
 /**
  * @brief  			Get Device ID
  * @param	devId	Device ID
@@ -243,13 +292,77 @@ int32_t MC11S::getTrl(uint8_t *val) {
 	return mc11s_trl_get(&sensor, val);
 }
 
+/**
+ * @brief  			Programs TRH/TRL from capacitance ratios instead of raw bytes. The
+ * 					chip raises ALERT when 0x40 * DATA_D0 / DATA_D1 > TRH, that is when
+ * 					Csensor / Cref (ch0 / ch1) falls below tripRatio, and clears it when
+ * 					the comparator value is back below TRL, i.e. once the ratio has risen
+ * 					above releaseRatio. The Coef_fix correction is applied to both.
+ * @param	tripRatio		Csensor / Cref at which the alarm sets
+ * @param	releaseRatio	Csensor / Cref at which it clears (tripRatio + hysteresis)
+ * @retval  		Error code (0 -> no Error, -1 -> ratios not representable)
+ */
+int32_t MC11S::setAlarmRatio(float tripRatio, float releaseRatio) {
+	float tripCode, releaseCode;
+	int32_t trh, trl;
+	int32_t ret;
+
+	if (releaseRatio < tripRatio)
+		return -1;
+
+	if (mc11s_threshold_from_ratio(tripRatio, &tripCode) != 0 ||
+		mc11s_threshold_from_ratio(releaseRatio, &releaseCode) != 0)
+		return -1;
+
+	trh = (int32_t)(tripCode + 0.5f);
+	trl = (int32_t)(releaseCode + 0.5f);
+
+	// Rounding can't be allowed to invert the hysteresis
+	if (trl > trh)
+		trl = trh;
+
+	if (trh > 0xFF || trl < 0)
+		return -1;
+
+	ret = setTrh((uint8_t)trh);
+	ret += setTrl((uint8_t)trl);
+
+	return ret;
+}
+
+/**
+ * @brief  			Reads TRH/TRL back as the Csensor / Cref ratios they trip at
+ * @param	tripRatio		Csensor / Cref at which the alarm sets
+ * @param	releaseRatio	Csensor / Cref at which it clears
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::getAlarmRatio(float *tripRatio, float *releaseRatio) {
+	uint8_t trh, trl;
+	int32_t ret;
+
+	ret = getTrh(&trh);
+	ret += getTrl(&trl);
+
+	if (ret == 0) {
+		ret = mc11s_ratio_from_threshold(trh, tripRatio);
+		ret += mc11s_ratio_from_threshold(trl, releaseRatio);
+	}
+
+	return ret;
+}
+
 /**
  * @brief  			Sets Reference Clock Selector
  * @param	val		value
  * @retval  		Error code (0 -> no Error)
  */
 int32_t MC11S::setRefClkSel(mc11s_ref_clk_sel_status_t val) {
-	return mc11s_ref_clk_sel_status_set(&sensor, val);
+	int32_t ret = mc11s_ref_clk_sel_status_set(&sensor, val);
+
+	if (ret == 0)
+		_refClkSel = val;
+
+	return ret;
 }
 
 /**
@@ -261,6 +374,194 @@ int32_t MC11S::getRefClkSel(mc11s_ref_clk_sel_status_t *val) {
 	return mc11s_ref_clk_sel_status_get(&sensor, val);
 }
 
+/**
+ * @brief  			Selects the external reference clock
+ * @param	hz		Frequency of the clock on the external reference input
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::setExtClock(uint32_t hz) {
+	if (hz == 0)
+		return -1;
+
+	_extClkHz = hz;
+	return setRefClkSel(MC11S_SEL_EXT_CLK);
+}
+
+/**
+ * @brief  			Frequency of the selected reference clock that every conversion
+ * 					(capacitance, conversion times, ranging) is worked out with:
+ * 					the external clock as given, or the nominal internal clock
+ * 					times the correction factor
+ * @retval  		Reference clock in Hz
+ */
+uint32_t MC11S::getRefClock(void) {
+	if (_refClkSel == MC11S_SEL_EXT_CLK)
+		return _extClkHz;
+
+	return (uint32_t)(MC11S_INT_CLK_HZ * _clkCorrection + 0.5f);
+}
+
+/**
+ * @brief  			Sets the internal clock correction, e.g. one stored after
+ * 					calibrateClock() on an earlier run
+ * @param	factor	Actual / nominal internal clock frequency (0 -> 1)
+ */
+void MC11S::setClockCorrection(float factor) {
+	_clkCorrection = (factor > 0) ? factor : 1.0f;
+}
+
+float MC11S::getClockCorrection(void) {
+	return _clkCorrection;
+}
+
+/**
+ * @brief  			Times one single conversion, from the write that starts it to
+ * 					DRDY. STATUS is polled back to back, without sleeping, and the
+ * 					end is put halfway between the last poll that found the
+ * 					conversion busy and the one that found it done, so the
+ * 					estimate is off by at most half a STATUS read. Waiting
+ * 					offsetUs before the first poll moves the polls to another
+ * 					phase of the conversion; offsets spread over one poll make
+ * 					the quantisation average out.
+ * @param	offsetUs	Wait before the first poll
+ * @param	limitUs		Give up after this long
+ * @param	us			Conversion time
+ * @retval  		Error code (0 -> no Error, -1 -> timed out)
+ */
+int32_t MC11S::timeConversion(uint32_t offsetUs, uint32_t limitUs, uint32_t *us) {
+	mc11s_status_t status;
+	uint16_t ch0, ch1;
+	uint32_t start, busy, now;
+	int32_t ret;
+
+	// Reading the data clears DRDY of the conversion before
+	ret = getData(&ch0, &ch1);
+	ret += setConvMode(MC11S_SINGLE_CONV);
+	if (ret != 0)
+		return ret;
+
+	start = mc11s_micros();
+	while ((uint32_t)(mc11s_micros() - start) < offsetUs)
+		;
+
+	busy = start;
+	for (;;) {
+		now = mc11s_micros();
+		ret = mc11s_status_get(&sensor, &status);
+		if (ret != 0)
+			return ret;
+
+		if (isDataReady(status))
+			break;
+		if (now - start > limitUs)
+			return -1;
+		busy = now;
+	}
+
+	*us = (busy - start) + (now - busy) / 2;
+	return 0;
+}
+
+/**
+ * @brief  			Measures the internal clock against the MCU timebase and stores
+ * 					the correction factor. Times the given number of single
+ * 					conversions at a short and at a long RCNT: the difference is
+ * 					channels * (FREF_DIV + 1) * dRCNT / Fclk per conversion, and the
+ * 					write that starts a conversion costs the same in both, so it
+ * 					cancels. Each conversion is timed to within half a STATUS read
+ * 					by polling without sleeping (timeConversion()), with the first
+ * 					poll staggered over one STATUS read so the rest averages out.
+ * 					16 conversions take about half a second.
+ * 					Needs the internal clock selected and an MCU timebase (Arduino
+ * 					or Linux). FREF_DIV is cleared while it runs; it, RCNT and the
+ * 					conversion mode are restored.
+ * @param	conversions	Conversions at each RCNT
+ * @retval  		Error code (0 -> no Error, -1 -> not measurable)
+ */
+int32_t MC11S::calibrateClock(uint16_t conversions) {
+	const uint16_t rcntShort = 0x0400, rcntLong = 0x7FFF;
+	mc11s_conv_mode_status_t mode;
+	mc11s_ch_en_status_t en0, en1;
+	mc11s_status_t status;
+	uint16_t rcnt, ch0, ch1, i;
+	uint8_t scnt, frefDiv, pass, channels;
+	uint32_t start, pollUs, limitUs, us;
+	uint64_t elapsed[2] = {0, 0};
+	float saved, factor;
+	int32_t ret;
+
+#if !MC11S_HAS_MICROS
+	// Nothing to time the conversions with
+	return -1;
+#endif
+
+	if (_refClkSel != MC11S_SEL_INT_CLK || conversions == 0)
+		return -1;
+
+	ret = getConvMode(&mode);
+	ret += getRcnt(&rcnt);
+	ret += getScnt(&scnt);
+	ret += getFrefDiv(&frefDiv);
+	ret += getCh0En(&en0);
+	ret += getCh1En(&en1);
+	if (ret != 0)
+		return ret;
+
+	channels = (en0 == MC11S_CH_ENABLE) + (en1 == MC11S_CH_ENABLE);
+	if (channels == 0)
+		return -1;
+
+	// One STATUS read: the poll period, and the span the first polls are staggered over
+	start = mc11s_micros();
+	for (i = 0; i < 8 && ret == 0; i++)
+		ret = mc11s_status_get(&sensor, &status);
+	pollUs = (uint32_t)(mc11s_micros() - start) / 8;
+	if (ret != 0)
+		return ret;
+
+	// Time out generously while the clock is unknown
+	saved = _clkCorrection;
+	_clkCorrection = 0.5f;
+
+	ret = setConvMode(MC11S_STOP_CONV);
+	ret += setFrefDiv(0);
+
+	for (pass = 0; pass < 2 && ret == 0; pass++) {
+		ret = setRcnt(pass ? rcntLong : rcntShort);
+
+		// The first conversion after a change is left out
+		ret += singleConversion(&ch0, &ch1, &status);
+
+		// Twice the nominal time at half the clock, plus the bus
+		limitUs = (uint32_t)(2.0f * channels * ((float)(pass ? rcntLong : rcntShort) + scnt) * 1e6f / getRefClock()) + 20000;
+
+		for (i = 0; i < conversions && ret == 0; i++) {
+			ret = timeConversion((uint32_t)((uint64_t)pollUs * i / conversions), limitUs, &us);
+			elapsed[pass] += us;
+		}
+	}
+
+	_clkCorrection = saved;
+	ret += setRcnt(rcnt);
+	ret += setFrefDiv(frefDiv);
+	ret += setConvMode(mode);
+	if (ret != 0)
+		return ret;
+
+	if (elapsed[1] <= elapsed[0])
+		return -1;
+
+	factor = (float)channels * (rcntLong - rcntShort) * conversions * 1e6f /
+			 ((float)(elapsed[1] - elapsed[0]) * MC11S_INT_CLK_HZ);
+
+	// The oscillator is specified far tighter than this, anything outside is a bad measurement
+	if (factor < 0.5f || factor > 1.5f)
+		return -1;
+
+	_clkCorrection = factor;
+	return 0;
+}
+
 /**
  * @brief  			Sets Interrupt enable bit
  * @param	val		value
@@ -339,7 +640,12 @@ int32_t MC11S::getConvMode(mc11s_conv_mode_status_t *val) {
  * @retval  		Error code (0 -> no Error)
  */
 int32_t MC11S::setCh0En(mc11s_ch_en_status_t val) {
-	return mc11s_ch0_en_status_set(&sensor, val);
+	int32_t ret = mc11s_ch0_en_status_set(&sensor, val);
+
+	if (ret == 0)
+		_chEn = (val == MC11S_CH_ENABLE) ? (_chEn | 0x1) : (_chEn & ~0x1);
+
+	return ret;
 }
 
 /**
@@ -357,7 +663,12 @@ int32_t MC11S::getCh0En(mc11s_ch_en_status_t *val) {
  * @retval  		Error code (0 -> no Error)
  */
 int32_t MC11S::setCh1En(mc11s_ch_en_status_t val) {
-	return mc11s_ch1_en_status_set(&sensor, val);
+	int32_t ret = mc11s_ch1_en_status_set(&sensor, val);
+
+	if (ret == 0)
+		_chEn = (val == MC11S_CH_ENABLE) ? (_chEn | 0x2) : (_chEn & ~0x2);
+
+	return ret;
 }
 
 /**
@@ -423,6 +734,425 @@ int32_t MC11S::getGlitchFilter(mc11s_glitch_filter_status_t *val) {
 	return mc11s_glitch_filter_status_get(&sensor, val);
 }
 
+/**
+ * @brief  			Starts a single conversion and waits until the enabled channels are
+ * 					ready. Data left from an earlier conversion is read off first, so
+ * 					a stale DRDY can't end the wait early. The wait is bounded by twice
+ * 					the time RCNT/SCNT/FREF_DIV call for.
+ * @param	ch0Val	Channel0 raw data
+ * @param	ch1Val	Channel1 raw data
+ * @param	status	STATUS after the conversion (trh_of_d, alert)
+ * @retval  		Error code (0 -> no Error, -1 -> timed out)
+ */
+int32_t MC11S::singleConversion(uint16_t *ch0Val, uint16_t *ch1Val, mc11s_status_t *status) {
+	uint16_t rcnt;
+	uint8_t scnt, frefDiv, channels;
+	uint32_t polls, maxPolls;
+	int32_t ret;
+
+	channels = (_chEn & 0x1) + ((_chEn >> 1) & 0x1);
+	if (channels == 0)
+		return -1;
+
+	ret = getRcnt(&rcnt);
+	ret += getScnt(&scnt);
+	ret += getFrefDiv(&frefDiv);
+
+	// Reading the data clears DRDY of whatever conversion came before
+	ret += getData(ch0Val, ch1Val);
+	ret += setConvMode(MC11S_SINGLE_CONV);
+	if (ret != 0)
+		return ret;
+
+	// The enabled channels, in ms, doubled, plus some slack for the bus
+	maxPolls = (uint32_t)(2.0f * channels * ((float)rcnt + scnt) * (frefDiv + 1) * 1000 / getRefClock()) + 20;
+
+	for (polls = 0; polls < maxPolls; polls++) {
+		ret = mc11s_status_get(&sensor, status);
+		if (ret != 0)
+			return ret;
+
+		if (isDataReady(*status))
+			return getData(ch0Val, ch1Val);
+
+#if defined(ARDUINO)
+		delay(1);
+#elif defined(__linux__)
+		usleep(1000);
+#endif
+	}
+
+	return -1;
+}
+
+/**
+ * @brief  			Adds a handler for new data. Every handler gets the same pair of
+ * 					counts from one burst read, so adding handlers adds no bus traffic.
+ * @param	handler	Called with arg and both channels' data
+ * @param	arg		Passed back to the handler as is
+ * @retval  		Error code (0 -> no Error, -1 -> all MC11S_DATA_HANDLERS taken)
+ */
+int32_t MC11S::onDataReady(mc11s_data_handler_t handler, void *arg) {
+	uint8_t i;
+
+	if (handler == NULL)
+		return -1;
+
+	for (i = 0; i < MC11S_DATA_HANDLERS; i++) {
+		if (_dataHandler[i] == NULL) {
+			_dataHandler[i] = handler;
+			_dataArg[i] = arg;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief  			Sets the handler for the alarm: called with true when ALERT sets
+ * 					and false when it clears (ALERT is a level, the handler sees the
+ * 					changes only)
+ * @param	handler	NULL -> none
+ * @param	arg		Passed back to the handler as is
+ */
+void MC11S::onAlert(mc11s_alert_handler_t handler, void *arg) {
+	_alertHandler = handler;
+	_alertArg = arg;
+}
+
+/**
+ * @brief  			Sets the handler for TRH_OF_D, called on every service() that
+ * 					finds it set, e.g. to call checkRange()
+ * @param	handler	NULL -> none
+ * @param	arg		Passed back to the handler as is
+ */
+void MC11S::onOverflow(mc11s_event_handler_t handler, void *arg) {
+	_overflowHandler = handler;
+	_overflowArg = arg;
+}
+
+/**
+ * @brief  			Sets the handler for a STATUS or data read that failed in service()
+ * @param	handler	NULL -> none
+ * @param	arg		Passed back to the handler as is
+ */
+void MC11S::onError(mc11s_error_handler_t handler, void *arg) {
+	_errorHandler = handler;
+	_errorArg = arg;
+}
+
+void MC11S::clearHandlers(void) {
+	uint8_t i;
+
+	for (i = 0; i < MC11S_DATA_HANDLERS; i++)
+		_dataHandler[i] = NULL;
+	_alertHandler = NULL;
+	_overflowHandler = NULL;
+	_errorHandler = NULL;
+}
+
+/**
+ * @brief  			Reads STATUS once and calls the handlers for what it reports, in
+ * 					this order:
+ * 					data ready	both enabled channels' DRDY set: one burst read of
+ * 								the data, shared by every data-ready handler
+ * 					overflow	TRH_OF_D set
+ * 					alert		ALERT changed since the last call
+ * 					Call it when INTB fires, or at the conversion rate when polling.
+ * 					Nothing is read beyond STATUS unless a data-ready handler is set.
+ * @param	status	STATUS as read (may be NULL)
+ * @retval  		Error code (0 -> no Error), also passed to the error handler
+ */
+int32_t MC11S::service(mc11s_status_t *status) {
+	mc11s_status_t st;
+	uint16_t ch0, ch1;
+	int32_t ret;
+	uint8_t i;
+
+	ret = getStatus(&st);
+	if (ret != 0) {
+		if (_errorHandler != NULL)
+			_errorHandler(_errorArg, ret);
+		return ret;
+	}
+
+	if (status != NULL)
+		*status = st;
+
+	if (isDataReady(st) && _dataHandler[0] != NULL) {
+		ret = getData(&ch0, &ch1);
+		if (ret != 0) {
+			if (_errorHandler != NULL)
+				_errorHandler(_errorArg, ret);
+		} else {
+			for (i = 0; i < MC11S_DATA_HANDLERS && _dataHandler[i] != NULL; i++)
+				_dataHandler[i](_dataArg[i], ch0, ch1);
+		}
+	}
+
+	if (st.trh_of_d && _overflowHandler != NULL)
+		_overflowHandler(_overflowArg);
+
+	if ((bool)st.alert != _alertActive) {
+		_alertActive = st.alert;
+		if (_alertHandler != NULL)
+			_alertHandler(_alertArg, _alertActive);
+	}
+
+	return ret;
+}
+
+/**
+ * @brief  			Finds the drive current, FIN_DIV and RCNT that give the most counts
+ * 					(resolution) without overflow, using single conversions:
+ * 					1. RCNT is the longest that fits the conversion time
+ * 					2. A conversion, starting at the lowest gain, measures counts per
+ * 					   unit of Idrv * RCNT / FIN_DIV
+ * 					3. The setting predicted to come closest to targetCounts is applied
+ * 					   (the lower drive current when two are equal) and measured again,
+ * 					   until the prediction holds
+ * 					The result is cached (getRange()) and the conversion mode restored.
+ * 					If no setting fits, the drive current, FIN_DIV and RCNT in use
+ * 					before are put back and the cache is left as it was.
+ * @param	maxConvMs		Longest time a conversion of both channels may take
+ * @param	targetCounts	Counts to aim for on the larger channel; the rest is headroom
+ * @retval  		Error code (0 -> no Error, -1 -> no usable setting)
+ */
+int32_t MC11S::autoRange(uint16_t maxConvMs, uint16_t targetCounts) {
+	static const mc11s_drive_i_status_t drives[] = {
+		MC11S_DRIVE_I_200uA, MC11S_DRIVE_I_400uA, MC11S_DRIVE_I_800uA,
+		MC11S_DRIVE_I_1mA6, MC11S_DRIVE_I_2mA4, MC11S_DRIVE_I_3mA2_1
+	};
+	mc11s_drive_i_status_t drive = MC11S_DRIVE_I_200uA, bestDrive, prevDrive;
+	mc11s_fin_div_val_t finDiv = MC11S_FIN_DIV_256, bestFin, prevFin;
+	mc11s_conv_mode_status_t mode;
+	mc11s_status_t status;
+	uint16_t ch0, ch1, counts, rcnt, rcntMax, bestRcnt, Idrv, prevRcnt;
+	uint8_t scnt, frefDiv, i, d, f;
+	float maxRcnt, gain, pred, best;
+	bool found = false;
+	int32_t ret;
+
+	_rangeMaxMs = maxConvMs;
+	_rangeTarget = targetCounts;
+
+	// The settings in use, put back if no better ones are found
+	ret = getConvMode(&mode);
+	ret += getDriveCurrent(&prevDrive);
+	ret += getFinDiv(&prevFin);
+	ret += getRcnt(&prevRcnt);
+	ret += getScnt(&scnt);
+	ret += getFrefDiv(&frefDiv);
+	if (ret != 0)
+		return ret;
+
+	// Step 1: Longest RCNT (15 bits) for which both channels fit in maxConvMs
+	maxRcnt = (float)maxConvMs * getRefClock() / (frefDiv + 1) / 1000 / 2 - scnt;
+	if (maxRcnt < 1)
+		return -1;
+	rcntMax = (maxRcnt > 0x7FFF) ? 0x7FFF : (uint16_t)maxRcnt;
+	rcnt = rcntMax;
+
+	ret = setConvMode(MC11S_STOP_CONV);
+
+	for (i = 0; i < 8 && ret == 0; i++) {
+		// Step 2: Measure at the current setting
+		ret = applyRange(drive, finDiv, rcnt);
+		ret += singleConversion(&ch0, &ch1, &status);
+		if (ret != 0)
+			break;
+
+		counts = (ch0 > ch1) ? ch0 : ch1;
+
+		if (status.trh_of_d || counts == 0xFFFF) {
+			// Overflowed, so there's nothing to scale from: back off 16x and retry
+			if (finDiv <= MC11S_FIN_DIV_16)
+				finDiv = (mc11s_fin_div_val_t)(finDiv + 4);
+			else if (rcnt > 16)
+				rcnt /= 16;
+			else
+				ret = -1;
+			continue;
+		}
+
+		if (counts < 16 && (finDiv != MC11S_FIN_DIV_2 || drive != MC11S_DRIVE_I_3mA2_1)) {
+			// Too few counts to scale from: raise the gain at least 16x and retry
+			if (finDiv >= MC11S_FIN_DIV_32) {
+				finDiv = (mc11s_fin_div_val_t)(finDiv - 4);
+			} else {
+				finDiv = MC11S_FIN_DIV_2;
+				drive = MC11S_DRIVE_I_3mA2_1;
+			}
+			continue;
+		}
+
+		if (counts == 0) {
+			// Nothing oscillating on either channel even at the highest gain
+			ret = -1;
+			break;
+		}
+
+		mc11s_drive_i_ua_get(drive, &Idrv);
+		gain = (float)counts * (1UL << finDiv) / ((float)Idrv * rcnt);
+
+		// Step 3: Best predicted setting at full RCNT, the lower drive wins a tie
+		best = 0;
+		bestDrive = MC11S_DRIVE_I_200uA;
+		bestFin = MC11S_FIN_DIV_256;
+		bestRcnt = rcntMax;
+
+		for (d = 0; d < sizeof(drives) / sizeof(drives[0]); d++) {
+			mc11s_drive_i_ua_get(drives[d], &Idrv);
+
+			for (f = MC11S_FIN_DIV_2; f <= MC11S_FIN_DIV_256; f++) {
+				pred = gain * Idrv * rcntMax / (1UL << f);
+
+				if (pred <= targetCounts && pred > best * 1.001f) {
+					best = pred;
+					bestDrive = drives[d];
+					bestFin = (mc11s_fin_div_val_t)f;
+				}
+			}
+		}
+
+		if (best == 0) {
+			// Even the lowest gain overshoots: shorten RCNT instead
+			mc11s_drive_i_ua_get(MC11S_DRIVE_I_200uA, &Idrv);
+			pred = targetCounts * 256.0f / (gain * Idrv);
+			bestRcnt = (pred < 1) ? 1 : (uint16_t)pred;
+		}
+
+		if (bestDrive == drive && bestFin == finDiv && bestRcnt == rcnt && counts <= targetCounts) {
+			// Step 4: Prediction confirmed, cache it
+			_range.drive = drive;
+			_range.fin_div = finDiv;
+			_range.rcnt = rcnt;
+			_range.counts = counts;
+			_rangeValid = true;
+			found = true;
+			break;
+		}
+
+		drive = bestDrive;
+		finDiv = bestFin;
+		rcnt = bestRcnt;
+	}
+
+	if (!found) {
+		// Leave the device as it was rather than at the last setting tried
+		applyRange(prevDrive, prevFin, prevRcnt);
+		if (ret == 0)
+			ret = -1;
+	}
+
+	// Step 5: Back to the conversion mode it was in
+	if (mode != MC11S_SINGLE_CONV)
+		ret += setConvMode(mode);
+
+	return ret;
+}
+
+/**
+ * @brief  			Fast re-range for the service loop. When TRH_OF_D reports an
+ * 					overflow the cached range is backed off 4x (FIN_DIV, or drive
+ * 					current/RCNT when FIN_DIV is at its limit) and checked with one
+ * 					conversion; only if that still overflows is autoRange() run again.
+ * 					The conversion mode is restored whichever way it goes.
+ * @param	reranged	true when the settings were changed
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::checkRange(bool *reranged) {
+	mc11s_trh_of_d_status_t overflow;
+	mc11s_conv_mode_status_t mode;
+	mc11s_status_t status;
+	mc11s_range_t range;
+	uint16_t ch0, ch1;
+	int32_t ret;
+
+	*reranged = false;
+
+	ret = getTrhOfDStatus(&overflow);
+	if (ret != 0 || !overflow.trh_of_d)
+		return ret;
+
+	*reranged = true;
+
+	ret = getConvMode(&mode);
+	if (ret != 0)
+		return ret;
+
+	if (!_rangeValid) {
+		ret = autoRange(_rangeMaxMs, _rangeTarget);
+	} else {
+		range = _range;
+		if (range.fin_div <= MC11S_FIN_DIV_64)
+			range.fin_div = (mc11s_fin_div_val_t)(range.fin_div + 2);
+		else if (range.drive >= MC11S_DRIVE_I_800uA && range.drive <= MC11S_DRIVE_I_1mA6)
+			range.drive = (mc11s_drive_i_status_t)(range.drive - 2);
+		else
+			range.rcnt = (range.rcnt > 4) ? range.rcnt / 4 : 1;
+
+		ret = setConvMode(MC11S_STOP_CONV);
+		ret += applyRange(range.drive, range.fin_div, range.rcnt);
+		ret += singleConversion(&ch0, &ch1, &status);
+
+		if (ret == 0 && (status.trh_of_d || ch0 == 0xFFFF || ch1 == 0xFFFF)) {
+			ret = autoRange(_rangeMaxMs, _rangeTarget);
+		} else if (ret == 0) {
+			range.counts = (ch0 > ch1) ? ch0 : ch1;
+			_range = range;
+		}
+	}
+
+	// autoRange() restores the mode it found, which may be STOP by now
+	if (mode != MC11S_SINGLE_CONV)
+		ret += setConvMode(mode);
+
+	return ret;
+}
+
+/**
+ * @brief  			Settings found by the last autoRange()/checkRange()
+ * @param	range	drive current, FIN_DIV, RCNT and the counts they gave
+ * @retval  		Error code (0 -> no Error, -1 -> not ranged yet)
+ */
+int32_t MC11S::getRange(mc11s_range_t *range) {
+	if (!_rangeValid)
+		return -1;
+
+	*range = _range;
+	return 0;
+}
+
+/**
+ * @brief  			Applies range settings saved from an earlier autoRange(), so a
+ * 					restart doesn't have to search again
+ * @param	range	drive current, FIN_DIV and RCNT
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::setRange(const mc11s_range_t *range) {
+	int32_t ret;
+
+	ret = applyRange(range->drive, range->fin_div, range->rcnt);
+	if (ret == 0) {
+		_range = *range;
+		_rangeValid = true;
+	}
+
+	return ret;
+}
+
+int32_t MC11S::applyRange(mc11s_drive_i_status_t drive, mc11s_fin_div_val_t finDiv, uint16_t rcnt) {
+	int32_t ret;
+
+	ret = setDriveCurrent(drive);
+	ret += setFinDiv(finDiv);
+	ret += setRcnt(rcnt);
+
+	return ret;
+}
+
 /**
  * @brief  			Calculates capacitance of ref and sensor
  * @param	val0	Channel 0 Capacitor	value
@@ -430,7 +1160,211 @@ int32_t MC11S::getGlitchFilter(mc11s_glitch_filter_status_t *val) {
  * @retval  		Error code (0 -> no Error)
  */
 int32_t MC11S::getCapacitance(float *val0, float *val1) {
-	return mc11s_capacitance_get(&sensor, val0, val1);
+	return mc11s_capacitance_clk_get(&sensor, getRefClock(), val0, val1);
+}
+
+/**
+ * @brief  			Calculates capacitance of ref and sensor from channel data that has
+ * 					already been read (and possibly filtered) by the caller
+ * @param	ch0Val	Channel0 data
+ * @param	ch1Val	Channel1 data
+ * @param	val0	Channel 0 Capacitor	value
+ * @param	val1	Channel 1 Capacitance Value
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::calcCapacitance(uint16_t ch0Val, uint16_t ch1Val, float *val0, float *val1) {
+	return mc11s_capacitance_clk_calc(&sensor, getRefClock(), ch0Val, ch1Val, val0, val1);
+}
+
+/**
+ * @brief  			Calculates capacitance of ref and sensor from channel data and
+ * 					compensates it to the reference temperature (setTempco())
+ * @param	ch0Val	Channel0 data
+ * @param	ch1Val	Channel1 data
+ * @param	degC	Temperature the data was converted at
+ * @param	val0	Channel 0 Capacitor	value
+ * @param	val1	Channel 1 Capacitance Value
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::calcCapacitance(uint16_t ch0Val, uint16_t ch1Val, float degC, float *val0, float *val1) {
+	int32_t ret = calcCapacitance(ch0Val, ch1Val, val0, val1);
+
+	if (ret != 0)
+		return ret;
+
+	return compensate(degC, val0, val1);
+}
+
+#if defined(ARDUINO)
+static int32_t mc11s_analog_read(void *handle, uint16_t *raw) {
+	*raw = (uint16_t)analogRead((uint8_t)(uintptr_t)handle);
+	return 0;
+}
+
+/**
+ * @brief  			Reads the VT pin with analogRead()
+ * @param	pin			Analog pin VT is wired to, e.g. A2
+ * @param	vref		ADC reference voltage
+ * @param	fullScale	ADC code at vref, e.g. 1023 for 10 bits
+ */
+void MC11S::setTempPin(uint8_t pin, float vref, uint16_t fullScale) {
+	setTempAdc(mc11s_analog_read, (void *)(uintptr_t)pin, vref, fullScale);
+}
+#endif
+
+/**
+ * @brief  			Reads the VT pin through a hook, for external ADCs or hosts
+ * @param	read		Returns one raw ADC sample (0 -> no Error)
+ * @param	handle		Passed to read
+ * @param	vref		ADC reference voltage
+ * @param	fullScale	ADC code at vref
+ */
+void MC11S::setTempAdc(mc11s_adc_read_ptr read, void *handle, float vref, uint16_t fullScale) {
+	_tempRead = read;
+	_tempHandle = handle;
+	_tempVref = vref;
+	_tempFullScale = fullScale ? fullScale : 1;
+}
+
+/**
+ * @brief  			ADC samples averaged per temperature reading. Averaging n samples
+ * 					with about an LSB of noise on them resolves finer than one LSB
+ * 					(~2.7 degC with a 10 bit ADC at 5 V).
+ * @param	n		Samples, 1 to 255
+ */
+void MC11S::setTempOversampling(uint8_t n) {
+	_tempOversampling = n ? n : 1;
+}
+
+/**
+ * @brief  			Transfer function of the VT pin, degC = slope * V + offset. The
+ * 					default is the MC11S typical (-560 degC/V, 386.3 degC); a probe
+ * 					calibrated at two temperatures can set its own.
+ */
+void MC11S::setTempTransfer(float slope, float offset) {
+	_tempSlope = slope;
+	_tempOffset = offset;
+}
+
+/**
+ * @brief  			Temperature coefficient of each channel's capacitance, so
+ * 					C(T) = C(ref) * (1 + ppm * 1e-6 * (T - ref)); compensate() and
+ * 					calcCapacitance() with a temperature take the drift out.
+ * @param	ppm0	Channel 0, ppm/degC
+ * @param	ppm1	Channel 1, ppm/degC
+ * @param	refDegC	Temperature compensated to
+ */
+void MC11S::setTempco(float ppm0, float ppm1, float refDegC) {
+	_tempco[0] = ppm0;
+	_tempco[1] = ppm1;
+	_tempRef = refDegC;
+}
+
+int32_t MC11S::sampleTemp(uint8_t n, uint32_t *sum) {
+	uint16_t raw;
+	uint8_t i;
+
+	if (_tempRead == NULL)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		if (_tempRead(_tempHandle, &raw) != 0)
+			return -1;
+		*sum += raw;
+	}
+
+	return 0;
+}
+
+float MC11S::tempFromRaw(float raw) {
+	return _tempSlope * (raw * _tempVref / _tempFullScale) + _tempOffset;
+}
+
+/**
+ * @brief  			Reads the temperature from VT, oversampled
+ * @param	degC	Temperature
+ * @retval  		Error code (0 -> no Error, -1 -> no ADC set up)
+ */
+int32_t MC11S::getTemperature(float *degC) {
+	uint32_t sum = 0;
+
+	if (sampleTemp(_tempOversampling, &sum) != 0)
+		return -1;
+
+	*degC = tempFromRaw((float)sum / _tempOversampling);
+	return 0;
+}
+
+/**
+ * @brief  			Reads both channels with the temperature taken around the
+ * 					data burst, half the samples before and half after, so both
+ * 					describe the same moment
+ * @param	ch0Val	Channel0 data
+ * @param	ch1Val	Channel1 data
+ * @param	degC	Temperature
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::getTemperatureData(uint16_t *ch0Val, uint16_t *ch1Val, float *degC) {
+	uint8_t before = _tempOversampling / 2;
+	uint32_t sum = 0;
+	int32_t ret;
+
+	if (sampleTemp(before, &sum) != 0)
+		return -1;
+
+	ret = getData(ch0Val, ch1Val);
+	if (ret != 0)
+		return ret;
+
+	if (sampleTemp(_tempOversampling - before, &sum) != 0)
+		return -1;
+
+	*degC = tempFromRaw((float)sum / _tempOversampling);
+	return 0;
+}
+
+/**
+ * @brief  			Runs one conversion with the temperature averaged over it: half
+ * 					the samples just before it starts, half once the data is ready
+ * @param	ch0Val	Channel0 data
+ * @param	ch1Val	Channel1 data
+ * @param	status	STATUS at the end of the conversion
+ * @param	degC	Temperature
+ * @retval  		Error code (0 -> no Error, -1 -> timed out or no ADC set up)
+ */
+int32_t MC11S::singleConversion(uint16_t *ch0Val, uint16_t *ch1Val, mc11s_status_t *status, float *degC) {
+	uint8_t before = _tempOversampling / 2;
+	uint32_t sum = 0;
+	int32_t ret;
+
+	if (sampleTemp(before, &sum) != 0)
+		return -1;
+
+	ret = singleConversion(ch0Val, ch1Val, status);
+	if (ret != 0)
+		return ret;
+
+	if (sampleTemp(_tempOversampling - before, &sum) != 0)
+		return -1;
+
+	*degC = tempFromRaw((float)sum / _tempOversampling);
+	return 0;
+}
+
+/**
+ * @brief  			Takes the temperature drift out of both capacitances
+ * @param	degC	Temperature they were measured at
+ * @param	val0	Channel 0 capacitance, compensated in place
+ * @param	val1	Channel 1 capacitance, compensated in place
+ * @retval  		Error code (0 -> no Error)
+ */
+int32_t MC11S::compensate(float degC, float *val0, float *val1) {
+	float d = degC - _tempRef;
+
+	*val0 /= 1.0f + _tempco[0] * 1e-6f * d;
+	*val1 /= 1.0f + _tempco[1] * 1e-6f * d;
+
+	return 0;
 }
 
 /**
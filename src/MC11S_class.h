@@ -38,6 +38,33 @@ version 0.1
 
 #define MC11S_I2C_ADDRESS 		(MC11S_I2C_ADD >> 1)
 
+// Frequency of the clock fed to the external reference input, can be set from the build
+#ifndef MC11S_EXT_CLK_HZ
+#define MC11S_EXT_CLK_HZ		MC11S_INT_CLK_HZ
+#endif
+
+// Settings found by autoRange()
+typedef struct {
+	mc11s_drive_i_status_t drive;
+	mc11s_fin_div_val_t fin_div;
+	uint16_t rcnt;
+	uint16_t counts;		// Larger channel count at these settings when ranged
+} mc11s_range_t;
+
+// Reads one raw sample of the ADC the VT pin is wired to
+typedef int32_t (*mc11s_adc_read_ptr)(void *, uint16_t *);
+
+// Data-ready handlers a service() call can share one data burst with
+#ifndef MC11S_DATA_HANDLERS
+#define MC11S_DATA_HANDLERS		2
+#endif
+
+// Event handlers called from service(), each with the argument it was registered with
+typedef void (*mc11s_data_handler_t)(void *arg, uint16_t ch0Val, uint16_t ch1Val);
+typedef void (*mc11s_alert_handler_t)(void *arg, bool active);
+typedef void (*mc11s_event_handler_t)(void *arg);
+typedef void (*mc11s_error_handler_t)(void *arg, int32_t err);
+
 class MC11S {
 	public:
 		int32_t begin();	// Resets the device and sets up for operation
@@ -51,6 +78,10 @@ class MC11S {
 
 		int32_t getCh0Data(uint16_t *ch0Val);	// Returns Channel0 raw data
 		int32_t getCh1Data(uint16_t *ch1Val);	// Returns Channel1 raw data
+		int32_t getData(uint16_t *ch0Val, uint16_t *ch1Val);	// Returns both channels' raw data in one burst
+		int32_t getStatusData(mc11s_status_t *status, uint16_t *ch0Val, uint16_t *ch1Val);	// Returns STATUS, then both channels
+		int32_t getStatus(mc11s_status_t *status);	// Returns STATUS (reading it acknowledges a conversion interrupt)
+		bool isDataReady(mc11s_status_t status);	// True when STATUS has DRDY set for every enabled channel
         
 		int32_t getDeviceID(uint16_t *devId);	// Returns the ID of the MC11S
 
@@ -73,8 +104,16 @@ class MC11S {
 		int32_t setTrl(uint8_t val);			// Sets Threshold low value
 		int32_t getTrl(uint8_t *val);			// Returns Threshold low value
 
+		int32_t setAlarmRatio(float tripRatio, float releaseRatio);		// Sets TRH/TRL from Csensor/Cref trip and release ratios
+		int32_t getAlarmRatio(float *tripRatio, float *releaseRatio);	// Returns the ratios TRH/TRL correspond to
+
 		int32_t setRefClkSel(mc11s_ref_clk_sel_status_t val);	// Sets Reference Clock Selector
 		int32_t getRefClkSel(mc11s_ref_clk_sel_status_t *val);	// Returns Reference Clock Selector
+		int32_t setExtClock(uint32_t hz);						// Selects the external reference clock and its frequency
+		uint32_t getRefClock(void);								// Frequency of the selected reference clock, Hz
+		void setClockCorrection(float factor);					// Actual / nominal internal clock, e.g. from calibrateClock()
+		float getClockCorrection(void);
+		int32_t calibrateClock(uint16_t conversions = 16);		// Measures the internal clock against the MCU timebase
 
 		int32_t setIntbStatus(mc11s_intb_en_status_t val);		// Sets Interrupt enable bit
 		int32_t getIntbStatus(mc11s_intb_en_status_t *val);		// Returns Inerrupt enable bit
@@ -104,7 +143,35 @@ class MC11S {
 		int32_t setGlitchFilter(mc11s_glitch_filter_status_t val);	// Sets Glitch Filter Enable bit
 		int32_t getGlitchFilter(mc11s_glitch_filter_status_t *val);	// Returns Glitch Filter Enable bit
 
+		int32_t singleConversion(uint16_t *ch0Val, uint16_t *ch1Val, mc11s_status_t *status);	// Runs one conversion and waits for its data
+
+		int32_t onDataReady(mc11s_data_handler_t handler, void *arg = NULL);	// Adds a handler for each new pair of channel data
+		void onAlert(mc11s_alert_handler_t handler, void *arg = NULL);		// Sets the handler for ALERT setting or clearing
+		void onOverflow(mc11s_event_handler_t handler, void *arg = NULL);	// Sets the handler for TRH_OF_D
+		void onError(mc11s_error_handler_t handler, void *arg = NULL);		// Sets the handler for bus errors in service()
+		void clearHandlers(void);
+		int32_t service(mc11s_status_t *status = NULL);	// One STATUS read, dispatched to the handlers
+
+		int32_t autoRange(uint16_t maxConvMs = 20, uint16_t targetCounts = 0xC000);	// Picks drive current, FIN_DIV and RCNT for the most counts
+		int32_t checkRange(bool *reranged);				// Backs the range off quickly when TRH_OF_D reports overflow
+		int32_t getRange(mc11s_range_t *range);			// Returns the settings cached by autoRange()
+		int32_t setRange(const mc11s_range_t *range);	// Applies and caches range settings (e.g. from EEPROM)
+
 		int32_t getCapacitance(float *val0, float *val1);		// Calculates Capacitance of Channel 0 & 1
+		int32_t calcCapacitance(uint16_t ch0Val, uint16_t ch1Val, float *val0, float *val1);	// Calculates Capacitance from given channel data
+		int32_t calcCapacitance(uint16_t ch0Val, uint16_t ch1Val, float degC, float *val0, float *val1);	// ... compensated to the reference temperature
+
+#if defined(ARDUINO)
+		void setTempPin(uint8_t pin, float vref = 5.0f, uint16_t fullScale = 1023);	// VT read with analogRead()
+#endif
+		void setTempAdc(mc11s_adc_read_ptr read, void *handle, float vref = 5.0f, uint16_t fullScale = 1023);	// VT read through a hook
+		void setTempOversampling(uint8_t n);				// ADC samples averaged per reading
+		void setTempTransfer(float slope, float offset);	// degC = slope * V(VT) + offset
+		void setTempco(float ppm0, float ppm1, float refDegC = 25.0f);	// Capacitance drift per channel, ppm/degC
+		int32_t getTemperature(float *degC);				// Oversampled VT reading
+		int32_t getTemperatureData(uint16_t *ch0Val, uint16_t *ch1Val, float *degC);	// Data burst with the temperature around it
+		int32_t singleConversion(uint16_t *ch0Val, uint16_t *ch1Val, mc11s_status_t *status, float *degC);	// ... averaged over the conversion
+		int32_t compensate(float degC, float *val0, float *val1);	// Removes the capacitance drift from degC
 		int32_t getCoef(uint16_t val0, uint16_t val1, float *val2);	// Returns the Coef fix for the given data channel ratio
 
         int32_t writeFunctionConfiguration(uint8_t addr, uint8_t *data, uint8_t len); // Write interface definition
@@ -112,6 +179,42 @@ class MC11S {
 
     protected: 
         stmdev_ctx_t sensor;
+
+		int32_t applyRange(mc11s_drive_i_status_t drive, mc11s_fin_div_val_t finDiv, uint16_t rcnt);
+		int32_t timeConversion(uint32_t offsetUs, uint32_t limitUs, uint32_t *us);
+		int32_t sampleTemp(uint8_t n, uint32_t *sum);
+		float tempFromRaw(float raw);
+
+		mc11s_range_t _range;
+		uint16_t _rangeMaxMs = 20;
+		uint16_t _rangeTarget = 0xC000;
+		bool _rangeValid = false;
+
+		uint8_t _chEn = 0x3;				// Channels enabled, bit n -> channel n
+
+		mc11s_data_handler_t _dataHandler[MC11S_DATA_HANDLERS] = {};
+		void *_dataArg[MC11S_DATA_HANDLERS] = {};
+		mc11s_alert_handler_t _alertHandler = NULL;
+		void *_alertArg = NULL;
+		mc11s_event_handler_t _overflowHandler = NULL;
+		void *_overflowArg = NULL;
+		mc11s_error_handler_t _errorHandler = NULL;
+		void *_errorArg = NULL;
+		bool _alertActive = false;			// ALERT as of the last service()
+
+		mc11s_ref_clk_sel_status_t _refClkSel = MC11S_SEL_INT_CLK;
+		uint32_t _extClkHz = MC11S_EXT_CLK_HZ;
+		float _clkCorrection = 1.0f;
+
+		mc11s_adc_read_ptr _tempRead = NULL;
+		void *_tempHandle = NULL;
+		float _tempVref = 5.0f;
+		uint16_t _tempFullScale = 1023;
+		uint8_t _tempOversampling = 16;
+		float _tempSlope = -560.0f;			// VT transfer of the MC11S, V -> degC
+		float _tempOffset = 386.3f;
+		float _tempco[2] = {0, 0};			// ppm/degC
+		float _tempRef = 25.0f;
 };
 
 #endif
\ No newline at end of file
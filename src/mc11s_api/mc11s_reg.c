@@ -18,7 +18,9 @@
  */
 
 #include "mc11s_reg.h"
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 
 /**
  * @defgroup  MC11S
@@ -149,6 +151,50 @@ int32_t mc11s_data_ch1_get(stmdev_ctx_t *ctx, uint16_t *val) {
 	return ret;
 }
 
+/**
+ * @brief  CH0 and CH1 sensor data registers in one burst.[get]
+ *
+ * @param  ctx      read / write interface definitions
+ * @param  val0     CH0 data register
+ * @param  val1     CH1 data register
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_data_get(stmdev_ctx_t *ctx, uint16_t *val0, uint16_t *val1) {
+    uint8_t buff[4];
+	int32_t ret;
+
+	// DATA_CH0_MSB..DATA_CH1_LSB are contiguous, one transaction returns both channels
+	ret = mc11s_read_reg(ctx, MC11S_DATA_CH0_MSB, &buff[0], 4);
+	*val0 = (uint16_t)((buff[0] * 256U) + buff[1]);
+	*val1 = (uint16_t)((buff[2] * 256U) + buff[3]);
+
+	return ret;
+}
+
+/**
+ * @brief  STATUS and both channels, with the flags as they were latched.
+ *         STATUS is read first, then DATA_CH0_MSB..DATA_CH1_LSB: two short
+ *         transactions, since a single burst would have to run through the
+ *         configuration and reserved registers in between. Reading the data
+ *         clears the data ready flags, so STATUS must come first.
+ *
+ * @param  ctx      read / write interface definitions
+ * @param  status   STATUS register
+ * @param  val0     Channel0 Data Register value
+ * @param  val1     Channel1 Data Register value
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_status_data_get(stmdev_ctx_t *ctx, mc11s_status_t *status, uint16_t *val0, uint16_t *val1) {
+	int32_t ret;
+
+	ret = mc11s_read_reg(ctx, MC11S_STATUS, (uint8_t *)status, 1);
+	ret += mc11s_data_get(ctx, val0, val1);
+
+	return ret;
+}
+
 /**
  * @brief  Counting time configuration register.[set]
  *
@@ -168,7 +214,7 @@ int32_t mc11s_rcnt_set(stmdev_ctx_t *ctx, uint16_t val) {
     // MSB is to be written first and then LSB; so swap the buff locations
 	buff[0] = (uint8_t)(val / 256U);
 	buff[1] = (uint8_t)(val - (buff[0] * 256U));
-	ret += mc11s_write_reg(ctx, MC11S_RCNT_MSB, &buff[0], 2);
+	ret = mc11s_write_reg(ctx, MC11S_RCNT_MSB, &buff[0], 2);
 
 	return ret;
 }
@@ -391,6 +437,18 @@ int32_t mc11s_alert_status_get(stmdev_ctx_t *ctx, mc11s_alert_status_t *val) {
 	return ret;
 }
 
+/**
+ * @brief  Whole STATUS register in one read.[get]
+ *
+ * @param  ctx      read / write interface definitions
+ * @param  val      STATUS register
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_status_get(stmdev_ctx_t *ctx, mc11s_status_t *val) {
+	return mc11s_read_reg(ctx, MC11S_STATUS, (uint8_t*) val, 1);
+}
+
 /**
  * @brief  Status of Data1 Threshold overflow bit.[get]
  *
@@ -1079,7 +1137,8 @@ int32_t mc11s_glitch_filter_status_get(stmdev_ctx_t *ctx, mc11s_glitch_filter_st
 }
 
 /**
- * @brief  Calculate capacitance of ref and sensor.
+ * @brief  Calculate capacitance of ref and sensor, assuming the nominal
+ *         internal reference clock (MC11S_INT_CLK_HZ).
  *
  * @param  ctx      read / write interface definitions
  * @param  C_ch0    Capacitance of channel 0
@@ -1088,6 +1147,20 @@ int32_t mc11s_glitch_filter_status_get(stmdev_ctx_t *ctx, mc11s_glitch_filter_st
  *
  */
 int32_t mc11s_capacitance_get(stmdev_ctx_t *ctx, float *C_ch0, float *C_ch1) {
+    return mc11s_capacitance_clk_get(ctx, MC11S_INT_CLK_HZ, C_ch0, C_ch1);
+}
+
+/**
+ * @brief  Calculate capacitance of ref and sensor.
+ *
+ * @param  ctx      read / write interface definitions
+ * @param  fclk     Reference clock frequency in Hz (internal or external)
+ * @param  C_ch0    Capacitance of channel 0
+ * @param  C_ch1    Capacitance of channel 1
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_capacitance_clk_get(stmdev_ctx_t *ctx, uint32_t fclk, float *C_ch0, float *C_ch1) {
     // C(sensor): 8.670 pf F1(ref):26.036 MHz F2(sensor):23.682 MHz VBE: 626.08 mV
     int32_t ret;
 
@@ -1096,112 +1169,230 @@ int32_t mc11s_capacitance_get(stmdev_ctx_t *ctx, float *C_ch0, float *C_ch1) {
     ret = mc11s_conv_mode_status_get(ctx, &conv_mode_val);
     ret += mc11s_conv_mode_status_set(ctx, MC11S_STOP_CONV);
 
-    // Step 2a: get ch0 & ch1 data
+    // Step 2: get ch0 & ch1 data
     uint16_t data_ch0, data_ch1;
 
-    ret += mc11s_data_ch0_get(ctx, &data_ch0);
+    ret += mc11s_data_get(ctx, &data_ch0, &data_ch1);
 
-    ret += mc11s_data_ch1_get(ctx, &data_ch1);
+    // Step 3: Convert the counts with the current configuration
+    ret += mc11s_capacitance_clk_calc(ctx, fclk, data_ch0, data_ch1, C_ch0, C_ch1);
 
+    // Step 4: Set the conversion mode to previous value
+    ret += mc11s_conv_mode_status_set(ctx, conv_mode_val);
 
-    // Step 2b: get Fin_div
-    //uint16_t Fin_div;
+    return ret;
+}
+
+/**
+ * @brief  Calculate capacitance of ref and sensor from already acquired
+ *         (and possibly filtered) channel counts, assuming the nominal
+ *         internal reference clock (MC11S_INT_CLK_HZ).
+ *
+ * @param  ctx       read / write interface definitions
+ * @param  data_ch0  Channel0 count
+ * @param  data_ch1  Channel1 count
+ * @param  C_ch0     Capacitance of channel 0
+ * @param  C_ch1     Capacitance of channel 1
+ * @retval           interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_capacitance_calc(stmdev_ctx_t *ctx, uint16_t data_ch0, uint16_t data_ch1, float *C_ch0, float *C_ch1) {
+    return mc11s_capacitance_clk_calc(ctx, MC11S_INT_CLK_HZ, data_ch0, data_ch1, C_ch0, C_ch1);
+}
+
+/**
+ * @brief  Calculate capacitance of ref and sensor from already acquired
+ *         (and possibly filtered) channel counts.
+ *
+ * @param  ctx       read / write interface definitions
+ * @param  fclk      Reference clock frequency in Hz (internal or external)
+ * @param  data_ch0  Channel0 count
+ * @param  data_ch1  Channel1 count
+ * @param  C_ch0     Capacitance of channel 0
+ * @param  C_ch1     Capacitance of channel 1
+ * @retval           interface status (MANDATORY: return 0 -> no Error,
+ *                   -1 -> a count or RCNT is zero)
+ *
+ */
+int32_t mc11s_capacitance_clk_calc(stmdev_ctx_t *ctx, uint32_t fclk, uint16_t data_ch0, uint16_t data_ch1, float *C_ch0, float *C_ch1) {
+    int32_t ret = 0;
+
+    // Step 1a: get Fin_div (divides by 2^Fin_div_val)
     mc11s_fin_div_val_t Fin_div_val;
     ret += mc11s_fin_div_get(ctx, &Fin_div_val);
 
     if (Fin_div_val > MC11S_FIN_DIV_256)
         Fin_div_val = MC11S_FIN_DIV_256;
 
-    //Fin_div = 2 ^ Fin_div_val;
-
-    // Step 2c: get Fclk
-    uint32_t Fclk = 2400000;    // 2.4 MHz CLK
-
-    // Step 2d: get Fref_div
-    uint16_t Fref_div;
-
-    ret += mc11s_fref_div_get(ctx, (uint8_t*) &Fref_div);
+    // Step 1b: get Fref_div, Fref = Fclk / (Fref_div + 1)
+    uint8_t Fref_div;
 
-    //Fref_div = Fref_div + 1;    // Fref value from 1 to 256
+    ret += mc11s_fref_div_get(ctx, &Fref_div);
 
-    // Step 2e: get RCNT
+    // Step 1c: get RCNT
     uint16_t rcnt;
 
     ret += mc11s_rcnt_get(ctx, &rcnt);
 
-    // Step 2f: get Idrv
+    // Step 1d: get Idrv
     uint16_t Idrv;
     mc11s_drive_i_status_t drive_i;
 
     ret += mc11s_drive_i_status_get(ctx, &drive_i);
 
-    switch (drive_i) {
+    ret += mc11s_drive_i_ua_get(drive_i, &Idrv);
+
+    if (ret != 0)
+        return ret;
+
+    if (data_ch0 == 0 || data_ch1 == 0 || rcnt == 0)
+        return -1;
+
+    // Step 2: Calculate Channel 1 capacitance
+    // Fsensor = data_chx * Fin_div * (Fclk / (Fref_div + 1)) / RCNT
+    // C = K * Idrv / Fsensor, with Idrv in uA and Fsensor in MHz -> pF
+    float Fsensor = (float) data_ch1 * (float) (1UL << Fin_div_val) * ((float) fclk / (Fref_div + 1)) / rcnt;
+    *C_ch1 = (float) (K * Idrv * 1e6f / Fsensor);
+
+    // Step 3: Get Coef fix for the values
+    float Coef_fix;
+    ret += mc11s_coef_fix_get(ctx, data_ch0, data_ch1, &Coef_fix);
+
+    // Step 4: Calculate Channel 0 capacitance
+    *C_ch0 = ((float) data_ch1 / data_ch0) * (*C_ch1) * Coef_fix;
+
+    return ret;
+}
+
+/**
+ * @brief  Return the value of Coef_fix for a given ratio of Data_Ch1 / Data_Ch0
+ *
+ * @param  ctx      read / write interface definitions
+ * @param  val0     Channel0 Data Register value
+ * @param  val1     Channel1 Data Register value
+ * @param  Coef_fix Coef_fix value based on the table in the datasheet
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_coef_fix_get(stmdev_ctx_t *ctx, uint16_t val0, uint16_t val1, float *Coef_fix) {
+    float ratio;
+
+    (void)ctx;      // Kept for API compatibility, the ratio alone sets Coef_fix
+    ratio = (float) val1 / val0;
+
+    return mc11s_coef_fix_ratio_get(ratio, Coef_fix);
+}
+
+/**
+ * @brief  Drive current setting in uA
+ *
+ * @param  val      DRIVE_I setting
+ * @param  Idrv     drive current in uA
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_drive_i_ua_get(mc11s_drive_i_status_t val, uint16_t *Idrv) {
+    int32_t ret = 0;
+
+    switch (val) {
         case MC11S_DRIVE_I_200uA:
-            Idrv = 200;
+            *Idrv = 200;
             break;
-        
+
         case MC11S_DRIVE_I_400uA:
-            Idrv = 400;
+            *Idrv = 400;
             break;
 
         case MC11S_DRIVE_I_800uA:
-            Idrv = 800;
+            *Idrv = 800;
             break;
 
         case MC11S_DRIVE_I_1mA6:
-            Idrv = 1600;
+            *Idrv = 1600;
             break;
 
         case MC11S_DRIVE_I_2mA4:
-            Idrv = 2400;
+            *Idrv = 2400;
             break;
-            
+
         case MC11S_DRIVE_I_3mA2_1:
         case MC11S_DRIVE_I_3mA2_2:
         case MC11S_DRIVE_I_3mA2_3:
-            Idrv = 3200;
+            *Idrv = 3200;
             break;
 
         default:
-            Idrv = 0;
+            *Idrv = 0;
+            ret = -1;
             break;
     }
 
-    // Step 3: Calculate Channel 1 capacitance
-    // C = k * Idrv /(data_chx * Fin_div * (Fclk /(Fref_div + 1))/ RCNT)
-    *C_ch1 = (float) (K * Idrv / (data_ch1 * (2 ^ Fin_div_val) * (Fclk / (Fref_div + 1)) / rcnt));
+    return ret;
+}
 
-    // Step 3a: Calculate Channel 0 capacitance
-    //*Csensor = (float) (K * Idrv / (data_ch0 * (2 ^ Fin_div_val) * (Fclk / (Fref_div + 1)) / rcnt));
+/**
+ * @brief  Conversion period of a CR setting in ms
+ *
+ * @param  val      CR setting
+ * @param  ms       time between conversions in ms
+ * @retval          interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_conv_time_ms_get(mc11s_conv_time_status_t val, uint32_t *ms) {
+    int32_t ret = 0;
 
-    // Step 4: Get Coef fix for the values
-    float Coef_fix;
-    ret += mc11s_coef_fix_get(ctx, data_ch0, data_ch1, &Coef_fix);
+    switch (val) {
+        case MC11S_CONV_60S:
+            *ms = 60000;
+            break;
 
-    // Step 5: Calculate Channel 0 capacitance
-    *C_ch0 = (data_ch1 / data_ch0) * (*C_ch1) * Coef_fix;
+        case MC11S_CONV_30S:
+            *ms = 30000;
+            break;
 
-    // Step 6: Set the conversion mode to previous value
-    ret += mc11s_conv_mode_status_set(ctx, conv_mode_val);
+        case MC11S_CONV_10S:
+            *ms = 10000;
+            break;
+
+        case MC11S_CONV_5S:
+            *ms = 5000;
+            break;
+
+        case MC11S_CONV_2S:
+            *ms = 2000;
+            break;
+
+        case MC11S_CONV_1S:
+            *ms = 1000;
+            break;
+
+        case MC11S_CONV_0S5:
+            *ms = 500;
+            break;
+
+        case MC11S_CONV_0S25:
+            *ms = 250;
+            break;
+
+        default:
+            *ms = 0;
+            ret = -1;
+            break;
+    }
 
     return ret;
 }
 
 /**
- * @brief  Return the value of Coef_fix for a given ratio of Data_Ch1 / Data_Ch0
+ * @brief  Return the value of Coef_fix for a given ratio Data_Ch1 / Data_Ch0
  *
- * @param  ctx      read / write interface definitions
- * @param  val0     Channel0 Data Register value
- * @param  val1     Channel1 Data Register value
+ * @param  ratio    Data_Ch1 / Data_Ch0
  * @param  Coef_fix Coef_fix value based on the table in the datasheet
  * @retval          interface status (MANDATORY: return 0 -> no Error)
  *
  */
-int32_t mc11s_coef_fix_get(stmdev_ctx_t *ctx, uint16_t val0, uint16_t val1, float *Coef_fix) {
-    float ratio;
-    int32_t ret;
-
-    ratio = (float) val1 / val0;
+int32_t mc11s_coef_fix_ratio_get(float ratio, float *Coef_fix) {
+    int32_t ret = 0;
 
     if (ratio >= 0.529 && ratio < 0.623) {
         *Coef_fix = 0.946;
@@ -1230,6 +1421,58 @@ int32_t mc11s_coef_fix_get(stmdev_ctx_t *ctx, uint16_t val0, uint16_t val1, floa
 
     return ret;
 }
+
+/**
+ * @brief  Alarm comparator value for a capacitance ratio.
+ *         The chip compares 0x40 * DATA_D0 / DATA_D1 against TRH/TRL; with
+ *         C_ch0 / C_ch1 = (DATA_D1 / DATA_D0) * Coef_fix that is
+ *         0x40 * Coef_fix / (C_ch0 / C_ch1). Coef_fix itself depends on
+ *         the data ratio, so the inverse is found by a few fixed point steps.
+ *
+ * @param  cap_ratio  C_ch0 / C_ch1
+ * @param  code       comparator value (not rounded)
+ * @retval            interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_threshold_from_ratio(float cap_ratio, float *code) {
+    float data_ratio = cap_ratio;    // DATA_D1 / DATA_D0
+    float Coef_fix = 1.0;
+    uint8_t i;
+
+    if (cap_ratio <= 0)
+        return -1;
+
+    for (i = 0; i < 4; i++) {
+        mc11s_coef_fix_ratio_get(data_ratio, &Coef_fix);
+        data_ratio = cap_ratio / Coef_fix;
+    }
+
+    *code = 0x40 / data_ratio;
+
+    return 0;
+}
+
+/**
+ * @brief  Capacitance ratio at which the alarm comparator sees a given value.
+ *
+ * @param  code       comparator value (0x40 * DATA_D0 / DATA_D1)
+ * @param  cap_ratio  C_ch0 / C_ch1
+ * @retval            interface status (MANDATORY: return 0 -> no Error)
+ *
+ */
+int32_t mc11s_ratio_from_threshold(float code, float *cap_ratio) {
+    float data_ratio, Coef_fix;
+
+    if (code <= 0)
+        return -1;
+
+    data_ratio = 0x40 / code;
+    mc11s_coef_fix_ratio_get(data_ratio, &Coef_fix);
+    *cap_ratio = data_ratio * Coef_fix;
+
+    return 0;
+}
+
 /**
  * @}
  *
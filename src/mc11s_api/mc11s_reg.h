@@ -385,6 +385,7 @@ typedef struct {
 
 /* Sensor Parameter */
 #define K                                     0.362
+#define MC11S_INT_CLK_HZ                      2400000UL
 /**
  * @}
  *
@@ -439,6 +440,8 @@ int32_t mc11s_device_id_get(stmdev_ctx_t *ctx, uint16_t *val);
 
 int32_t mc11s_data_ch0_get(stmdev_ctx_t *ctx, uint16_t *val);
 int32_t mc11s_data_ch1_get(stmdev_ctx_t *ctx, uint16_t *val);
+int32_t mc11s_data_get(stmdev_ctx_t *ctx, uint16_t *val0, uint16_t *val1);
+int32_t mc11s_status_data_get(stmdev_ctx_t *ctx, mc11s_status_t *status, uint16_t *val0, uint16_t *val1);
 
 int32_t mc11s_rcnt_set(stmdev_ctx_t *ctx, uint16_t val);
 int32_t mc11s_rcnt_get(stmdev_ctx_t *ctx, uint16_t *val);
@@ -482,6 +485,8 @@ typedef struct {
 } mc11s_trh_of_d_status_t;
 int32_t mc11s_trh_of_d_status_get(stmdev_ctx_t *ctx, mc11s_trh_of_d_status_t *val);
 
+int32_t mc11s_status_get(stmdev_ctx_t *ctx, mc11s_status_t *val);
+
 int32_t mc11s_trh_set(stmdev_ctx_t *ctx, uint8_t val);
 int32_t mc11s_trh_get(stmdev_ctx_t *ctx, uint8_t *val);
 
@@ -576,7 +581,15 @@ int32_t mc11s_glitch_filter_status_get(stmdev_ctx_t *ctx, mc11s_glitch_filter_st
 
 /* Higher Level APIs*/
 int32_t mc11s_capacitance_get(stmdev_ctx_t *ctx, float *C_ch1, float *C_ch0);
+int32_t mc11s_capacitance_calc(stmdev_ctx_t *ctx, uint16_t data_ch0, uint16_t data_ch1, float *C_ch0, float *C_ch1);
+int32_t mc11s_capacitance_clk_get(stmdev_ctx_t *ctx, uint32_t fclk, float *C_ch0, float *C_ch1);
+int32_t mc11s_capacitance_clk_calc(stmdev_ctx_t *ctx, uint32_t fclk, uint16_t data_ch0, uint16_t data_ch1, float *C_ch0, float *C_ch1);
 int32_t mc11s_coef_fix_get(stmdev_ctx_t *ctx, uint16_t val0, uint16_t val1, float *Coef_fix);
+int32_t mc11s_coef_fix_ratio_get(float ratio, float *Coef_fix);
+int32_t mc11s_threshold_from_ratio(float cap_ratio, float *code);
+int32_t mc11s_ratio_from_threshold(float code, float *cap_ratio);
+int32_t mc11s_drive_i_ua_get(mc11s_drive_i_status_t val, uint16_t *Idrv);
+int32_t mc11s_conv_time_ms_get(mc11s_conv_time_status_t val, uint32_t *ms);
 
 #ifdef __cplusplus
 }